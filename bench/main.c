@@ -0,0 +1,804 @@
+// Headless benchmarks for the UI module. Nothing here needs a window or a GL context.
+// Results are written as a single JSON object, to stdout or to the file given as the first argument.
+
+#include "core/memory/alloc.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "frame_atlas.h"
+#include "frame_instance.h"
+#include "frame_io.h"
+#include "frame_pack.h"
+#include "frame_theme.h"
+#include "layout.h"
+#include "layout_flat.h"
+#include "layout_index.h"
+#include "layout_pool.h"
+#include "menu.h"
+#include "ui_damage.h"
+#include "ui_stats.h"
+
+// Each benchmark runs for at least this long
+#define BENCH_MIN_NS 200000000ull
+
+typedef void (*bench_func)(void* data);
+
+static FILE* output;
+static bool first_result = true;
+static char temp_folder[] = "/tmp/dfgame_ui_bench.XXXXXX";
+
+static const uint32 layout_sizes[] = { 10, 1000, 100000 };
+#define LAYOUT_SIZE_COUNT (sizeof(layout_sizes) / sizeof(layout_sizes[0]))
+
+static void report_start(const char* name, uint32 size) {
+    fprintf(output, "%s\n    {\"name\":\"%s\",\"size\":%u", first_result ? "" : ",", name, size);
+    first_result = false;
+}
+
+// Reports a measurement that isn't a timing, like a byte count
+static void report_value(const char* name, uint32 size, const char* metric, double value) {
+    report_start(name, size);
+    fprintf(output, ",\"metric\":\"%s\",\"value\":%.3f}", metric, value);
+}
+
+// Runs func until at least BENCH_MIN_NS have passed, and reports the average time per call
+static void bench_run(const char* name, uint32 size, bench_func func, void* data) {
+    // Warm up caches and let any lazy allocations happen
+    func(data);
+
+    uint64 iterations = 0;
+    uint64 batch = 1;
+    uint64 start = ui_stats_get_time();
+    uint64 elapsed = 0;
+    while(elapsed < BENCH_MIN_NS) {
+        for(uint64 i = 0; i < batch; ++i) {
+            func(data);
+        }
+        iterations += batch;
+        batch *= 2;
+        elapsed = ui_stats_get_time() - start;
+    }
+
+    report_start(name, size);
+    fprintf(output, ",\"metric\":\"ns_per_op\",\"value\":%.3f,\"iterations\":%llu}",
+            (double)elapsed / iterations, (unsigned long long)iterations);
+}
+
+// A small deterministic generator, so that every run benchmarks the same inputs
+static uint32 next_random(uint32* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Frame data with a fake texture. Only the texture's dimensions are needed to build vertices.
+static frame_data make_frame_data(frame_fill fill) {
+    frame_data data;
+    gltex tex = { 0 };
+    tex.width = 64;
+    tex.height = 64;
+
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 64, .y = 64 } };
+    frame_margins margins = { .left = 8, .top = 8, .right = 8, .bottom = 8 };
+    frame_data_new(&data, tex, box, margins, fill, fill);
+
+    return data;
+}
+
+//
+// Nine-slice vertex generation
+//
+
+typedef struct frame_bench {
+    frame_data data;
+    frame f;
+    vt_pt* verts;
+    uint32 step;
+} frame_bench;
+
+static void bench_build_vertices(void* data) {
+    frame_bench* b = data;
+    frame_build_vertices(&b->data, (vec2){ .x = 512, .y = 256 }, ALIGN_CENTER, b->verts);
+}
+
+static void bench_build_positions(void* data) {
+    frame_bench* b = data;
+    frame_build_positions(&b->data, (vec2){ .x = 512, .y = 256 }, ALIGN_CENTER, b->verts);
+}
+
+static void bench_resize(void* data) {
+    frame_bench* b = data;
+    b->step = (b->step + 1) % 256;
+    frame_set_dimensions(b->f, (vec2){ .x = 256 + b->step, .y = 128 + b->step });
+    frame_get_vertices(b->f, NULL);
+}
+
+static void run_frame_benchmarks() {
+    frame_bench b = { .data = make_frame_data(FRAME_FILL_STRETCH), .step = 0 };
+    b.f = frame_new(&b.data, (vec2){ .x = 256, .y = 128 });
+    b.verts = salloc(FRAME_VERTEX_MAX * sizeof(vt_pt));
+
+    bench_run("frame.build_vertices", 1, bench_build_vertices, &b);
+    bench_run("frame.build_positions", 1, bench_build_positions, &b);
+    bench_run("frame.resize", 1, bench_resize, &b);
+    frame_free(b.f, false);
+    sfree(b.verts);
+
+    frame_bench tiled = { .data = make_frame_data(FRAME_FILL_TILE), .step = 0 };
+    uint32 count = frame_get_vertex_count(&tiled.data, (vec2){ .x = 512, .y = 256 });
+    tiled.verts = salloc(count * sizeof(vt_pt));
+    bench_run("frame.build_vertices_tiled", count, bench_build_vertices, &tiled);
+    sfree(tiled.verts);
+}
+
+//
+// Layouts
+//
+
+typedef struct layout_bench {
+    layout l;
+    layout_element* elements;
+    uint32 count;
+
+    // Used by the nested stack benchmark
+    layout* rows;
+    uint32 row_count;
+
+    layout_flat flat;
+} layout_bench;
+
+static const char* get_layout_name(layout_type type) {
+    switch(type) {
+        case LAYOUT_FREE: return "free";
+        case LAYOUT_STACK_HORIZONTAL: return "stack_horizontal";
+        case LAYOUT_STACK_VERTICAL: return "stack_vertical";
+        case LAYOUT_GRID: return "grid";
+        case LAYOUT_FLEX_HORIZONTAL: return "flex_horizontal";
+        case LAYOUT_FLEX_VERTICAL: return "flex_vertical";
+    }
+
+    return "unknown";
+}
+
+static vec2 get_element_dims(uint32 i) {
+    return (vec2){ .x = 20 + (i % 7) * 5, .y = 10 + (i % 5) * 4 };
+}
+
+static void init_elements(layout_bench* b, uint32 count) {
+    b->count = count;
+    b->elements = scalloc(count, sizeof(layout_element));
+    for(uint32 i = 0; i < count; ++i) {
+        layout_element* elem = &b->elements[i];
+        elem->requested_dims = get_element_dims(i);
+        elem->padding = (vec2){ .x = 1, .y = 1 };
+        elem->align = ALIGN_DEFAULT;
+        elem->grow = 1;
+        elem->shrink = 1;
+    }
+}
+
+static void bench_layout_update(void* data) {
+    layout_bench* b = data;
+    layout_mark_dirty(&b->l);
+    layout_update(&b->l);
+}
+
+static void bench_nested_update(void* data) {
+    layout_bench* b = data;
+    layout_mark_dirty(&b->l);
+    for(uint32 i = 0; i < b->row_count; ++i) {
+        layout_mark_dirty(&b->rows[i]);
+    }
+    layout_update(&b->l);
+}
+
+static void bench_flat_update(void* data) {
+    layout_bench* b = data;
+    layout_flat_update(&b->flat);
+}
+
+static void run_layout_benchmarks() {
+    const vec2 bounds = { .x = 1920, .y = 1080 };
+    char name[64];
+
+    for(uint32 s = 0; s < LAYOUT_SIZE_COUNT; ++s) {
+        uint32 count = layout_sizes[s];
+        uint16 columns = (uint16)ceilf(sqrtf(count));
+
+        for(layout_type type = LAYOUT_FREE; type <= LAYOUT_FLEX_VERTICAL; ++type) {
+            layout_bench b;
+            init_elements(&b, count);
+            layout_init(&b.l, bounds, type);
+            layout_set_columns(&b.l, columns);
+            layout_set_wrap(&b.l, true);
+            for(uint32 i = 0; i < count; ++i) {
+                layout_add_element(&b.l, &b.elements[i]);
+            }
+
+            snprintf(name, sizeof(name), "layout.update.%s", get_layout_name(type));
+            bench_run(name, count, bench_layout_update, &b);
+
+            layout_cleanup(&b.l);
+            sfree(b.elements);
+        }
+
+        // The same grid of elements, built as a vertical stack of horizontal stacks
+        layout_bench nested;
+        init_elements(&nested, count);
+        nested.row_count = (count + columns - 1) / columns;
+        nested.rows = scalloc(nested.row_count, sizeof(layout));
+        layout_init(&nested.l, bounds, LAYOUT_STACK_VERTICAL);
+        for(uint32 r = 0; r < nested.row_count; ++r) {
+            layout_init(&nested.rows[r], (vec2){ .x = bounds.x, .y = bounds.y / nested.row_count }, LAYOUT_STACK_HORIZONTAL);
+            for(uint32 i = r * columns; i < count && i < (r + 1) * columns; ++i) {
+                layout_add_element(&nested.rows[r], &nested.elements[i]);
+            }
+            layout_add_layout(&nested.l, &nested.rows[r]);
+        }
+
+        bench_run("layout.update.nested_stack", count, bench_nested_update, &nested);
+
+        for(uint32 r = 0; r < nested.row_count; ++r) {
+            layout_cleanup(&nested.rows[r]);
+        }
+        layout_cleanup(&nested.l);
+        sfree(nested.rows);
+        sfree(nested.elements);
+
+        // Flat layouts support the non-wrapping types
+        const layout_type flat_types[] = { LAYOUT_FREE, LAYOUT_STACK_HORIZONTAL, LAYOUT_STACK_VERTICAL };
+        for(uint8 t = 0; t < 3; ++t) {
+            layout_bench flat;
+            layout_flat_init(&flat.flat, bounds, flat_types[t]);
+            for(uint32 i = 0; i < count; ++i) {
+                layout_flat_add_element(&flat.flat, get_element_dims(i), (vec2){ .x = 1, .y = 1 }, ALIGN_DEFAULT);
+            }
+
+            snprintf(name, sizeof(name), "layout_flat.update.%s", get_layout_name(flat_types[t]));
+            bench_run(name, count, bench_flat_update, &flat);
+
+            layout_flat_cleanup(&flat.flat);
+        }
+    }
+}
+
+//
+// Parallel layout solving
+//
+
+#define PANEL_LAYOUT_COUNT 100
+#define PANEL_LAYOUT_ELEMENTS 1000
+
+typedef struct panel_tree_bench {
+    layout root;
+    layout_bench panels[PANEL_LAYOUT_COUNT];
+    layout_pool pool;
+} panel_tree_bench;
+
+static void bench_panel_tree_serial(void* data) {
+    panel_tree_bench* b = data;
+    for(uint32 i = 0; i < PANEL_LAYOUT_COUNT; ++i) {
+        layout_mark_dirty(&b->panels[i].l);
+    }
+    layout_update(&b->root);
+}
+
+static void bench_panel_tree_parallel(void* data) {
+    panel_tree_bench* b = data;
+    for(uint32 i = 0; i < PANEL_LAYOUT_COUNT; ++i) {
+        layout_mark_dirty(&b->panels[i].l);
+    }
+    layout_update_parallel(&b->root, b->pool);
+}
+
+static void run_parallel_layout_benchmarks() {
+    panel_tree_bench* b = mscalloc(1, panel_tree_bench);
+    layout_init(&b->root, (vec2){ .x = 1920, .y = 1080 }, LAYOUT_GRID);
+    layout_set_columns(&b->root, 10);
+    for(uint32 i = 0; i < PANEL_LAYOUT_COUNT; ++i) {
+        layout_bench* panel = &b->panels[i];
+        init_elements(panel, PANEL_LAYOUT_ELEMENTS);
+        layout_init(&panel->l, vec2_zero, LAYOUT_FLEX_HORIZONTAL);
+        layout_set_wrap(&panel->l, true);
+        for(uint32 j = 0; j < PANEL_LAYOUT_ELEMENTS; ++j) {
+            layout_add_element(&panel->l, &panel->elements[j]);
+        }
+        layout_add_layout(&b->root, &panel->l);
+    }
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint16 threads = cores > 1 ? (uint16)min(cores - 1, 64) : 0;
+    b->pool = layout_pool_new(threads);
+
+    uint32 count = PANEL_LAYOUT_COUNT * PANEL_LAYOUT_ELEMENTS;
+    bench_run("layout.update_panels.serial", count, bench_panel_tree_serial, b);
+    bench_run("layout.update_panels.parallel", count, bench_panel_tree_parallel, b);
+    report_value("layout.update_panels.parallel", count, "threads", threads + 1);
+
+    layout_pool_free(b->pool);
+    for(uint32 i = 0; i < PANEL_LAYOUT_COUNT; ++i) {
+        layout_cleanup(&b->panels[i].l);
+        sfree(b->panels[i].elements);
+    }
+    layout_cleanup(&b->root);
+    sfree(b);
+}
+
+//
+// Hit-testing
+//
+
+#define HIT_TEST_ELEMENTS 10000
+
+typedef struct hit_bench {
+    layout_bench layout;
+    layout_index index;
+    uint32 state;
+    layout_element* found;
+} hit_bench;
+
+static vec2 next_point(uint32* state) {
+    return (vec2){ .x = next_random(state) % 1920, .y = next_random(state) % 1080 };
+}
+
+static void bench_hit_scan(void* data) {
+    hit_bench* b = data;
+    vec2 point = next_point(&b->state);
+
+    b->found = NULL;
+    for(uint32 i = 0; i < b->layout.count; ++i) {
+        aabb_2d box = b->layout.elements[i].calculated_bounds;
+        if(point.x >= box.position.x && point.x <= box.position.x + box.dimensions.x &&
+           point.y >= box.position.y && point.y <= box.position.y + box.dimensions.y) {
+            b->found = &b->layout.elements[i];
+            break;
+        }
+    }
+}
+
+static void bench_hit_index(void* data) {
+    hit_bench* b = data;
+    b->found = layout_index_query_point(b->index, next_point(&b->state));
+}
+
+static void run_hit_test_benchmarks() {
+    const vec2 bounds = { .x = 1920, .y = 1080 };
+
+    hit_bench b = { .state = 3 };
+    init_elements(&b.layout, HIT_TEST_ELEMENTS);
+    layout_init(&b.layout.l, bounds, LAYOUT_GRID);
+    layout_set_columns(&b.layout.l, 100);
+    for(uint32 i = 0; i < HIT_TEST_ELEMENTS; ++i) {
+        layout_add_element(&b.layout.l, &b.layout.elements[i]);
+    }
+
+    b.index = layout_index_new((aabb_2d){ .position = vec2_zero, .dimensions = bounds }, (vec2){ .x = 32, .y = 32 });
+    layout_set_index(&b.layout.l, b.index);
+    layout_update(&b.layout.l);
+
+    bench_run("hit_test.scan", HIT_TEST_ELEMENTS, bench_hit_scan, &b);
+    bench_run("hit_test.index", HIT_TEST_ELEMENTS, bench_hit_index, &b);
+
+    // Re-solving the grid without changes leaves the index untouched
+    bench_run("hit_test.update_unchanged", HIT_TEST_ELEMENTS, bench_layout_update, &b.layout);
+
+    layout_index_free(b.index);
+    layout_cleanup(&b.layout.l);
+    sfree(b.layout.elements);
+}
+
+//
+// Menus
+//
+
+// Fonts need a GL context in dfgame, so menus get their glyphs from a synthetic source instead,
+// where every character is an 8x12 quad that advances by 8 pixels
+static bool get_bench_glyph(void* data, uint32 c, menu_glyph* g) {
+    *g = (menu_glyph) {
+        .texture_bounds = { .position = { .x = (c % 16) * 8, .y = (c / 16 % 16) * 16 }, .dimensions = { .x = 8, .y = 12 } },
+        .bearing = { .x = 0, .y = 12 },
+        .advance = 8
+    };
+    return true;
+}
+
+static vec2 get_bench_atlas_size(void* data) {
+    return (vec2){ .x = 128, .y = 256 };
+}
+
+// Labels are 5 to 19 characters long, so entries are 40 to 152 pixels wide
+static menu make_menu(container_index count) {
+    menu_glyph_source glyphs = {
+        .get_glyph = get_bench_glyph,
+        .get_atlas_size = get_bench_atlas_size,
+        .line_height = 16,
+        .data = NULL
+    };
+
+    menu m = menu_new_with_glyphs(glyphs);
+    menu_set_offset(m, (vec3){ .x = 0.5f, .y = 2, .z = 0 });
+    m->can_wrap = true;
+
+    char label[20];
+    for(container_index i = 0; i < count; ++i) {
+        uint32 length = 5 + (i * 37) % 15;
+        for(uint32 c = 0; c < length; ++c) {
+            label[c] = 'a' + (i + c) % 26;
+        }
+        label[length] = '\0';
+        menu_add_entry(m, label, NULL, NULL);
+    }
+
+    return m;
+}
+
+static void bench_move_cursor(void* data) {
+    menu m = data;
+    menu_move_cursor(m, 7);
+}
+
+static void bench_move_cursor_wrap(void* data) {
+    menu m = data;
+    menu_move_cursor(m, (int16)(menu_get_entry_count(m) / 2 + 3));
+}
+
+static void bench_calculate_dims(void* data) {
+    menu m = data;
+    menu_invalidate_dims(m);
+    menu_calculate_dims(m);
+}
+
+static void bench_cached_dims(void* data) {
+    menu m = data;
+    menu_calculate_dims(m);
+}
+
+static void bench_menu_vertices(void* data) {
+    menu m = data;
+    menu_build_vertices(m);
+}
+
+static void run_menu_benchmarks() {
+    for(uint32 s = 0; s < LAYOUT_SIZE_COUNT; ++s) {
+        menu m = make_menu(layout_sizes[s]);
+
+        bench_run("menu.move_cursor", layout_sizes[s], bench_move_cursor, m);
+        bench_run("menu.move_cursor_wrap", layout_sizes[s], bench_move_cursor_wrap, m);
+        bench_run("menu.calculate_dims", layout_sizes[s], bench_calculate_dims, m);
+        bench_run("menu.calculate_dims_cached", layout_sizes[s], bench_cached_dims, m);
+        bench_run("menu.build_vertices", layout_sizes[s], bench_menu_vertices, m);
+
+        menu_free(m);
+    }
+}
+
+//
+// Frame files
+//
+
+#define FRAME_FILE_COUNT 1000
+
+typedef struct io_bench {
+    frame_data data;
+    char* path;
+
+    char* paths[FRAME_FILE_COUNT];
+    char* names[FRAME_FILE_COUNT];
+    char* pack_path;
+    char* theme_path;
+    frame_theme theme;
+} io_bench;
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+
+    return path;
+}
+
+static void bench_save(void* data) {
+    io_bench* b = data;
+    save_frame(b->path, &b->data);
+}
+
+static void bench_load(void* data) {
+    io_bench* b = data;
+    frame_data f;
+    char* texture_path = NULL;
+    if(load_frame_properties(b->path, &f, &texture_path)) {
+        sfree(texture_path);
+    }
+}
+
+static void bench_load_all_xml(void* data) {
+    io_bench* b = data;
+    for(uint32 i = 0; i < FRAME_FILE_COUNT; ++i) {
+        frame_data f;
+        char* texture_path = NULL;
+        if(load_frame_properties(b->paths[i], &f, &texture_path)) {
+            sfree(texture_path);
+        }
+    }
+}
+
+static void bench_load_all_pack(void* data) {
+    io_bench* b = data;
+    frame_pack p = frame_pack_open(b->pack_path);
+    if(p == NULL) {
+        return;
+    }
+
+    for(uint32 i = 0; i < FRAME_FILE_COUNT; ++i) {
+        uint32 index = frame_pack_find(p, b->paths[i]);
+        frame_pack_get_uvs(p, index);
+    }
+    frame_pack_close(p);
+}
+
+// Loads the same frames as bench_load_all_xml from a single theme file, and looks each of them up by name
+static void bench_load_all_theme(void* data) {
+    io_bench* b = data;
+    frame_theme t = frame_theme_load(b->theme_path, NULL);
+    if(t == NULL) {
+        return;
+    }
+
+    for(uint32 i = 0; i < FRAME_FILE_COUNT; ++i) {
+        frame_theme_find(t, b->names[i]);
+    }
+    frame_theme_free(t);
+}
+
+static void bench_theme_find(void* data) {
+    io_bench* b = data;
+    for(uint32 i = 0; i < FRAME_FILE_COUNT; ++i) {
+        frame_theme_find(b->theme, b->names[i]);
+    }
+}
+
+static void run_io_benchmarks() {
+    io_bench b;
+    b.data = make_frame_data(FRAME_FILL_STRETCH);
+    b.data.texture.asset_path = "frame_texture.png";
+    b.path = make_temp_path("frame.xml");
+
+    bench_run("frame_io.save", 1, bench_save, &b);
+    bench_run("frame_io.load_properties", 1, bench_load, &b);
+
+    char name[32];
+    b.theme_path = make_temp_path("theme.xml");
+    xmlTextWriterPtr theme = frame_theme_write_begin(b.theme_path);
+    for(uint32 i = 0; i < FRAME_FILE_COUNT; ++i) {
+        snprintf(name, sizeof(name), "frame%u.xml", i);
+        b.paths[i] = make_temp_path(name);
+        b.data.margins.left = i % 16;
+        save_frame(b.paths[i], &b.data);
+
+        snprintf(name, sizeof(name), "skin%u", i);
+        b.names[i] = salloc(strlen(name) + 1);
+        strcpy(b.names[i], name);
+        frame_theme_write_skin(theme, b.names[i], &b.data);
+    }
+    frame_theme_write_end(theme);
+
+    b.theme = frame_theme_load(b.theme_path, NULL);
+    if(b.theme != NULL) {
+        bench_run("frame_theme.load_all", FRAME_FILE_COUNT, bench_load_all_theme, &b);
+        bench_run("frame_theme.find", FRAME_FILE_COUNT, bench_theme_find, &b);
+        frame_theme_free(b.theme);
+    }
+
+    b.pack_path = make_temp_path("frames.dffp");
+    if(frame_pack_build(b.pack_path, (const char* const*)b.paths, FRAME_FILE_COUNT)) {
+        bench_run("frame_io.load_all_xml", FRAME_FILE_COUNT, bench_load_all_xml, &b);
+        bench_run("frame_pack.load_all", FRAME_FILE_COUNT, bench_load_all_pack, &b);
+        unlink(b.pack_path);
+    }
+
+    for(uint32 i = 0; i < FRAME_FILE_COUNT; ++i) {
+        unlink(b.paths[i]);
+        sfree(b.paths[i]);
+        sfree(b.names[i]);
+    }
+    unlink(b.theme_path);
+    unlink(b.path);
+    sfree(b.path);
+    sfree(b.pack_path);
+    sfree(b.theme_path);
+}
+
+//
+// Atlas packing
+//
+
+#define ATLAS_SKIN_COUNT 1000
+
+typedef struct atlas_bench {
+    uint16 widths[ATLAS_SKIN_COUNT];
+    uint16 heights[ATLAS_SKIN_COUNT];
+    uint16 page_count;
+    float occupancy;
+} atlas_bench;
+
+static void bench_atlas_pack(void* data) {
+    atlas_bench* b = data;
+    frame_atlas a = frame_atlas_new(2048, 2048, 1);
+
+    uint16 x, y;
+    for(uint32 i = 0; i < ATLAS_SKIN_COUNT; ++i) {
+        frame_atlas_pack_rect(a, b->widths[i], b->heights[i], &x, &y);
+    }
+
+    b->page_count = frame_atlas_get_page_count(a);
+    b->occupancy = frame_atlas_get_occupancy(a);
+    frame_atlas_free(a);
+}
+
+static void run_atlas_benchmarks() {
+    atlas_bench b;
+    uint32 state = 1;
+    for(uint32 i = 0; i < ATLAS_SKIN_COUNT; ++i) {
+        b.widths[i] = 16 + next_random(&state) % 113;
+        b.heights[i] = 16 + next_random(&state) % 113;
+    }
+
+    bench_run("frame_atlas.pack", ATLAS_SKIN_COUNT, bench_atlas_pack, &b);
+    report_value("frame_atlas.pack", ATLAS_SKIN_COUNT, "pages", b.page_count);
+    report_value("frame_atlas.pack", ATLAS_SKIN_COUNT, "occupancy", b.occupancy);
+}
+
+//
+// Animated panels: per-frame meshes vs instances
+//
+
+#define PANEL_COUNT 1000
+
+typedef struct panel_bench {
+    frame_data data;
+    frame panels[PANEL_COUNT];
+    frame_instance_batch instances;
+    uint32 step;
+
+    // Bytes that the last animation step would upload
+    size_t upload_bytes;
+} panel_bench;
+
+static void animate_panels(panel_bench* b) {
+    b->step = (b->step + 1) % 64;
+    for(uint32 i = 0; i < PANEL_COUNT; ++i) {
+        float grow = (b->step + i) % 64;
+        frame_set_dimensions(b->panels[i], (vec2){ .x = 100 + grow, .y = 60 + grow });
+    }
+}
+
+static void bench_panels_mesh(void* data) {
+    panel_bench* b = data;
+    animate_panels(b);
+
+    // Each resized panel re-uploads its whole vertex buffer
+    b->upload_bytes = 0;
+    for(uint32 i = 0; i < PANEL_COUNT; ++i) {
+        uint32 count = 0;
+        frame_get_vertices(b->panels[i], &count);
+        b->upload_bytes += count * sizeof(vt_pt);
+    }
+}
+
+static void bench_panels_instanced(void* data) {
+    panel_bench* b = data;
+    animate_panels(b);
+
+    for(uint32 i = 0; i < PANEL_COUNT; ++i) {
+        frame_instance_batch_add(b->instances, b->panels[i], mat4_ident);
+    }
+    b->upload_bytes = frame_instance_batch_get_upload_size(b->instances);
+    frame_instance_batch_clear(b->instances);
+}
+
+static void run_panel_benchmarks() {
+    panel_bench* b = mscalloc(1, panel_bench);
+    b->data = make_frame_data(FRAME_FILL_STRETCH);
+    b->instances = frame_instance_batch_new();
+    for(uint32 i = 0; i < PANEL_COUNT; ++i) {
+        b->panels[i] = frame_new(&b->data, (vec2){ .x = 100, .y = 60 });
+    }
+
+    bench_run("panels.mesh", PANEL_COUNT, bench_panels_mesh, b);
+    report_value("panels.mesh", PANEL_COUNT, "upload_bytes_per_frame", b->upload_bytes);
+    bench_run("panels.instanced", PANEL_COUNT, bench_panels_instanced, b);
+    report_value("panels.instanced", PANEL_COUNT, "upload_bytes_per_frame", b->upload_bytes);
+
+    for(uint32 i = 0; i < PANEL_COUNT; ++i) {
+        frame_free(b->panels[i], false);
+    }
+    frame_instance_batch_free(b->instances);
+    sfree(b);
+}
+
+//
+// Damage merging
+//
+
+#define DAMAGE_RECT_COUNT 1000
+
+typedef struct damage_bench {
+    ui_damage damage;
+    aabb_2d rects[DAMAGE_RECT_COUNT];
+    uint16 region_count;
+} damage_bench;
+
+static void bench_damage_merge(void* data) {
+    damage_bench* b = data;
+    ui_damage_clear(b->damage);
+    for(uint32 i = 0; i < DAMAGE_RECT_COUNT; ++i) {
+        ui_damage_add(b->damage, b->rects[i]);
+    }
+    ui_damage_get_regions(b->damage, &b->region_count);
+}
+
+static void run_damage_benchmarks() {
+    damage_bench* b = mscalloc(1, damage_bench);
+    aabb_2d screen = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 1920, .y = 1080 } };
+    b->damage = ui_damage_new(screen, 16);
+
+    // Small widgets scattered over the screen, like a list of animated panels
+    uint32 state = 7;
+    for(uint32 i = 0; i < DAMAGE_RECT_COUNT; ++i) {
+        b->rects[i] = (aabb_2d) {
+            .position = { .x = next_random(&state) % 1800, .y = next_random(&state) % 1000 },
+            .dimensions = { .x = 8 + next_random(&state) % 112, .y = 8 + next_random(&state) % 72 }
+        };
+    }
+
+    bench_run("ui_damage.merge", DAMAGE_RECT_COUNT, bench_damage_merge, b);
+    report_value("ui_damage.merge", DAMAGE_RECT_COUNT, "regions", b->region_count);
+
+    ui_damage_free(b->damage);
+    sfree(b);
+}
+
+int main(int argc, char** argv) {
+    output = stdout;
+    if(argc > 1) {
+        output = fopen(argv[1], "w");
+        if(output == NULL) {
+            fprintf(stderr, "Can't open %s for writing\n", argv[1]);
+            return 1;
+        }
+    }
+
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    fprintf(output, "{\"benchmarks\":[");
+
+    run_frame_benchmarks();
+    run_layout_benchmarks();
+    run_parallel_layout_benchmarks();
+    run_hit_test_benchmarks();
+    run_menu_benchmarks();
+    run_io_benchmarks();
+    run_atlas_benchmarks();
+    run_panel_benchmarks();
+    run_damage_benchmarks();
+
+    // Stats cover the whole run, and are only non-zero when the library is built with them enabled
+    ui_stats stats;
+    ui_stats_snapshot(&stats);
+    fprintf(output, "\n],\"stats\":");
+    ui_stats_write_json(&stats, output);
+    fprintf(output, "}\n");
+
+    rmdir(temp_folder);
+    if(output != stdout) {
+        fclose(output);
+    }
+
+    return 0;
+}
@@ -2,21 +2,80 @@
 #define LOG_CATEGORY "UI"
 
 #include "frame.h"
+#include "ui_stats.h"
 
 #include "core/check.h"
 #include "graphics/mesh.h"
 #include "graphics/shader.h"
 #include "math/matrix.h"
 
+#include <math.h>
+
 // Create a new frame with the given texture data and dimensions
 frame frame_new(frame_data* data, vec2 dims) {
     frame f = mscalloc(1, struct frame);
     f->data = data;
+    f->data_revision = data != NULL ? data->revision : 0;
     f->align = ALIGN_DEFAULT;
     f->dims = dims;
+    f->verts = NULL;
+    f->vert_count = 0;
+    f->vert_capacity = 0;
+    f->owns_verts = true;
+    ui_buffer_init(&f->buffer);
+    f->in_arena = false;
     f->m = NULL;
 
     f->is_dirty = true;
+    f->is_resized = false;
+    f->needs_upload = false;
+    f->needs_mesh = false;
+    f->warned_tile_limit = false;
+    f->is_damaged = true;
+
+    return f;
+}
+
+// Releases the resources of a frame that live outside of its own allocation
+static void frame_release(void* data) {
+    frame f = data;
+
+    ui_buffer_cleanup(&f->buffer);
+    if(f->m != NULL) {
+        mesh_free(f->m);
+    }
+    if(f->owns_verts) {
+        sfree(f->verts);
+    }
+}
+
+// Create a new frame in an arena. It's released along with the arena, and must not be freed with frame_free.
+frame frame_new_in(ui_arena a, frame_data* data, vec2 dims) {
+    check_return(a != NULL, "Arena is NULL", NULL);
+
+    frame f = ui_arena_mnew(a, struct frame);
+    f->data = data;
+    f->data_revision = data != NULL ? data->revision : 0;
+    f->align = ALIGN_DEFAULT;
+    f->dims = dims;
+    f->in_arena = true;
+
+    // Stretched frames never need more than this, so most arena frames never touch the heap
+    f->verts = ui_arena_alloc(a, FRAME_VERTEX_MAX * sizeof(vt_pt));
+    f->vert_count = 0;
+    f->vert_capacity = FRAME_VERTEX_MAX;
+    f->owns_verts = false;
+    ui_buffer_init(&f->buffer);
+    f->m = NULL;
+
+    f->is_dirty = true;
+    f->is_resized = false;
+    f->needs_upload = false;
+    f->needs_mesh = false;
+    f->warned_tile_limit = false;
+    f->is_damaged = true;
+
+    ui_arena_defer(a, frame_release, f);
 
     return f;
 }
@@ -24,124 +83,338 @@ frame frame_new(frame_data* data, vec2 dims) {
 // Frees the frame
 void _frame_free(frame f, bool deep) {
     check_return(f != NULL, "Frame is NULL", );
+    check_return(!f->in_arena, "Frames created in an arena are released with the arena", );
 
     if(deep) {
         frame_data_cleanup(f->data);
         sfree(f->data);
     }
-    if(f->m) {
-        mesh_free(f->m);
-    }
+    frame_release(f);
 
     sfree(f);
 }
 
-void build_box(vt_pt* verts, aabb_2d box, aabb_2d uv_box) {
-    verts[0] = (vt_pt) {
-        .position = (vec3){ .x = box.position.x, .y = box.position.y, .z = 0 },
-        .uv = uv_box.position
-    };
+static void build_box_positions(vt_pt* verts, aabb_2d box) {
+    verts[0].position = (vec3){ .x = box.position.x, .y = box.position.y, .z = 0 };
+    verts[1].position = (vec3){ .x = box.position.x + box.dimensions.x, .y = box.position.y, .z = 0 };
+    verts[2].position = (vec3){ .x = box.position.x + box.dimensions.x, .y = box.position.y + box.dimensions.y, .z = 0 };
+    verts[3].position = (vec3){ .x = box.position.x, .y = box.position.y, .z = 0 };
+    verts[4].position = (vec3){ .x = box.position.x + box.dimensions.x, .y = box.position.y + box.dimensions.y, .z = 0 };
+    verts[5].position = (vec3){ .x = box.position.x, .y = box.position.y + box.dimensions.y, .z = 0 };
+}
 
-    verts[1] = (vt_pt) {
-        .position = (vec3){ .x = box.position.x + box.dimensions.x, .y = box.position.y, .z = 0 },
-        .uv = uv_box.position
-    };
+static void build_box_uvs(vt_pt* verts, aabb_2d uv_box) {
+    verts[0].uv = uv_box.position;
+
+    verts[1].uv = uv_box.position;
     verts[1].uv.x += uv_box.dimensions.x;
 
-    verts[2] = (vt_pt) {
-        .position = (vec3){ .x = box.position.x + box.dimensions.x, .y = box.position.y + box.dimensions.y, .z = 0 },
-        .uv = vec2_add(uv_box.position, uv_box.dimensions)
-    };
+    verts[2].uv = vec2_add(uv_box.position, uv_box.dimensions);
 
-    verts[3] = (vt_pt) {
-        .position = (vec3){ .x = box.position.x, .y = box.position.y, .z = 0 },
-        .uv = uv_box.position
-    };
+    verts[3].uv = uv_box.position;
+
+    verts[4].uv = vec2_add(uv_box.position, uv_box.dimensions);
+
+    verts[5].uv = uv_box.position;
+    verts[5].uv.y += uv_box.dimensions.y;
+}
 
-    verts[4] = (vt_pt) {
-        .position = (vec3){ .x = box.position.x + box.dimensions.x, .y = box.position.y + box.dimensions.y, .z = 0 },
-        .uv = vec2_add(uv_box.position, uv_box.dimensions)
+void build_box(vt_pt* verts, aabb_2d box, aabb_2d uv_box) {
+    build_box_positions(verts, box);
+    build_box_uvs(verts, uv_box);
+}
+
+// Gets the unaligned position of slice i of a frame with the given data and dimensions
+static aabb_2d get_slice_box(const frame_data* data, uint8 i, vec2 dims) {
+    aabb_2d box = (aabb_2d) {
+        .position = vec2_zero,
+        .dimensions = dims
     };
 
-    verts[5] = (vt_pt) {
-        .position = (vec3){ .x = box.position.x, .y = box.position.y + box.dimensions.y, .z = 0 },
-        .uv = uv_box.position
+    // For edges, make the box size fixed
+    if(i % 3 == 0) { // Left column
+        box.dimensions.x = data->uvs[i].dimensions.x;
+        box.position.x -= box.dimensions.x;
+    } else if (i % 3 == 2) { // Right column
+        box.position.x += box.dimensions.x;
+        box.dimensions.x = data->uvs[i].dimensions.x;
+    }
+    if(i / 3 == 0) { // Top row
+        box.dimensions.y = data->uvs[i].dimensions.y;
+        box.position.y -= box.dimensions.y;
+    } else if (i / 3 == 2) { // Bottom row
+        box.position.y += box.dimensions.y;
+        box.dimensions.y = data->uvs[i].dimensions.y;
+    }
+
+    return box;
+}
+
+// Gets the offset that moves a frame's origin to its alignment point
+static vec2 get_align_offset(vec2 dims, alignment_2d align) {
+    aabb_2d frame_box = {
+        .position = vec2_zero,
+        .dimensions = dims
     };
-    verts[5].uv.y += uv_box.dimensions.y;
+
+    return aabb_get_origin_2d(frame_box, align);
 }
 
-// Rebuilds the mesh data for f
-void frame_rebuild_mesh(frame f) {
-    check_return(f != NULL, "Frame is NULL", );
+// Gets the fill mode of slice i. Corners are never tiled.
+static frame_fill get_slice_fill(const frame_data* data, uint8 i) {
+    if(i == 4) {
+        return data->center_fill;
+    } else if(i % 2 == 1) {
+        return data->edge_fill;
+    }
 
-    if(f->m != NULL) {
-        mesh_free(f->m);
+    return FRAME_FILL_STRETCH;
+}
+
+// Gets the number of tiles needed to cover length, with the last tile cut short.
+// Returns 0 if more than FRAME_TILE_MAX tiles would be needed.
+static uint32 get_tile_count(float length, float tile) {
+    if(length <= 0 || tile <= 0) {
+        return 1;
     }
 
-    if(f->data != NULL) {
-        vt_pt verts[54];
-        uint8 len = 0;
+    // Compared as a float first, so that huge or infinite lengths aren't cast
+    float count = ceilf(length / tile);
+    if(!(count <= FRAME_TILE_MAX)) {
+        return 0;
+    }
 
-        check_return(f->data->texture.width != 0 && f->data->texture.height != 0, "Texture dimensions are invalid", );
-        float uv_x_transform = 1.0f / f->data->texture.width;
-        float uv_y_transform = 1.0f / f->data->texture.height;
+    return (uint32)count;
+}
 
-        for(uint8 i = 0; i < 9; ++i) {
-            // If the box has no size, skip it
-            if(eq0(vec2_len_squared(f->data->uvs[i].dimensions))) {
-                continue;
-            }
+// Gets the number of tiles along each axis of slice i, when it covers box.
+// Edges only tile along their length, and the center tiles along both axes.
+// Slices needing more than FRAME_TILE_MAX tiles are stretched instead. Returns false if that happened.
+static bool get_slice_tiles(const frame_data* data, uint8 i, aabb_2d box, bool* tile_x, bool* tile_y, uint32* columns, uint32* rows) {
+    bool is_tiled = get_slice_fill(data, i) == FRAME_FILL_TILE;
+    *tile_x = is_tiled && i % 3 == 1;
+    *tile_y = is_tiled && i / 3 == 1;
+    *columns = *tile_x ? get_tile_count(box.dimensions.x, data->uvs[i].dimensions.x) : 1;
+    *rows = *tile_y ? get_tile_count(box.dimensions.y, data->uvs[i].dimensions.y) : 1;
+
+    if(*columns == 0 || *rows == 0 || *columns * *rows > FRAME_TILE_MAX) {
+        *tile_x = *tile_y = false;
+        *columns = *rows = 1;
+        return false;
+    }
 
-            aabb_2d box = (aabb_2d) {
-                .position = vec2_zero,
-                .dimensions = f->dims
+    return true;
+}
+
+// Fills verts with the tiles of slice i covering box. uv_scale converts pixels to texture coordinates.
+// Returns the number of vertices written.
+static uint32 build_slice(const frame_data* data, uint8 i, aabb_2d box, vec2 uv_scale, vt_pt* verts) {
+    bool tile_x, tile_y;
+    uint32 columns, rows;
+    get_slice_tiles(data, i, box, &tile_x, &tile_y, &columns, &rows);
+
+    aabb_2d uv_box = data->uvs[i];
+    vec2 tile_dims = {
+        .x = tile_x ? uv_box.dimensions.x : box.dimensions.x,
+        .y = tile_y ? uv_box.dimensions.y : box.dimensions.y
+    };
+
+    uint32 len = 0;
+    for(uint32 row = 0; row < rows; ++row) {
+        for(uint32 column = 0; column < columns; ++column) {
+            aabb_2d tile = {
+                .position = { .x = box.position.x + column * tile_dims.x, .y = box.position.y + row * tile_dims.y },
+                .dimensions = tile_dims
             };
-            aabb_2d uv_box = f->data->uvs[i];
-            uv_box.position.x *= uv_x_transform;
-            uv_box.dimensions.x *= uv_x_transform;
-            uv_box.position.y *= uv_y_transform;
-            uv_box.dimensions.y *= uv_y_transform;
-
-            // For edges, make the box size fixed
-            if(i % 3 == 0) { // Left column
-                box.dimensions.x = f->data->uvs[i].dimensions.x;
-                box.position.x -= box.dimensions.x;
-            } else if (i % 3 == 2) { // Right column
-                box.position.x += box.dimensions.x;
-                box.dimensions.x = f->data->uvs[i].dimensions.x;
+            aabb_2d tile_uv = uv_box;
+
+            // The last tile is cut short, cropping its UVs rather than squashing them
+            if(tile_x) {
+                tile.dimensions.x = min(tile_dims.x, box.dimensions.x - column * tile_dims.x);
+                tile_uv.dimensions.x = tile.dimensions.x;
             }
-            if(i / 3 == 0) { // Top row
-                box.dimensions.y = f->data->uvs[i].dimensions.y;
-                box.position.y -= box.dimensions.y;
-            } else if (i / 3 == 2) { // Bottom row
-                box.position.y += box.dimensions.y;
-                box.dimensions.y = f->data->uvs[i].dimensions.y;
+            if(tile_y) {
+                tile.dimensions.y = min(tile_dims.y, box.dimensions.y - row * tile_dims.y);
+                tile_uv.dimensions.y = tile.dimensions.y;
             }
 
-            build_box(verts + (len), box, uv_box);
+            tile_uv.position.x *= uv_scale.x;
+            tile_uv.dimensions.x *= uv_scale.x;
+            tile_uv.position.y *= uv_scale.y;
+            tile_uv.dimensions.y *= uv_scale.y;
 
+            build_box(verts + len, tile, tile_uv);
             len += 6;
         }
+    }
 
-        // Calculate and apply offset for alignment
-        aabb_2d box = {
-            .position = vec2_zero,
-            .dimensions = f->dims
-        };
-        vec2 offset = aabb_get_origin_2d(box, f->align);
-        for(uint8 i = 0; i < len; ++i) {
-            verts[i].position.xy = vec2_sub(verts[i].position.xy, offset);
+    return len;
+}
+
+// Counts the vertices a frame generates, and sets stretched if any tiled slice is stretched instead
+static uint32 count_vertices(const frame_data* data, vec2 dims, bool* stretched) {
+    *stretched = false;
+
+    uint32 count = 0;
+    for(uint8 i = 0; i < 9; ++i) {
+        if(eq0(vec2_len_squared(data->uvs[i].dimensions))) {
+            continue;
         }
 
-        if(f->m) {
-            mesh_free(f->m);
+        bool tile_x, tile_y;
+        uint32 columns, rows;
+        if(!get_slice_tiles(data, i, get_slice_box(data, i, dims), &tile_x, &tile_y, &columns, &rows)) {
+            *stretched = true;
         }
-        if(len != 0) {
-            f->m = mesh_new(len, verts, NULL);
+        count += columns * rows * 6;
+    }
+
+    return count;
+}
+
+// Gets the number of vertices a frame with the given data and dimensions generates
+uint32 frame_get_vertex_count(const frame_data* data, vec2 dims) {
+    check_return(data != NULL, "Frame data is NULL", 0);
+
+    bool stretched;
+    return count_vertices(data, dims, &stretched);
+}
+
+// Fills the positions of verts for a frame with the given data, dimensions and alignment
+uint32 frame_build_positions(const frame_data* data, vec2 dims, alignment_2d align, vt_pt* verts) {
+    check_return(data != NULL, "Frame data is NULL", 0);
+    check_return(verts != NULL, "Vertex buffer is NULL", 0);
+    check_return(!frame_data_is_tiled(data), "Tiled frames can't have only their positions rebuilt", 0);
+
+    vec2 offset = get_align_offset(dims, align);
+
+    uint32 len = 0;
+    for(uint8 i = 0; i < 9; ++i) {
+        // If the box has no size, skip it
+        if(eq0(vec2_len_squared(data->uvs[i].dimensions))) {
+            continue;
         }
 
-        f->is_dirty = false;
+        aabb_2d box = get_slice_box(data, i, dims);
+        box.position = vec2_sub(box.position, offset);
+        build_box_positions(verts + len, box);
+
+        len += 6;
     }
+
+    return len;
+}
+
+// Fills verts with the nine-slice vertices for a frame with the given data, dimensions and alignment
+uint32 frame_build_vertices(const frame_data* data, vec2 dims, alignment_2d align, vt_pt* verts) {
+    check_return(data != NULL, "Frame data is NULL", 0);
+    check_return(verts != NULL, "Vertex buffer is NULL", 0);
+    check_return(data->texture.width != 0 && data->texture.height != 0, "Texture dimensions are invalid", 0);
+
+    vec2 offset = get_align_offset(dims, align);
+    vec2 uv_scale = {
+        .x = 1.0f / data->texture.width,
+        .y = 1.0f / data->texture.height
+    };
+
+    uint32 len = 0;
+    for(uint8 i = 0; i < 9; ++i) {
+        // If the box has no size, skip it
+        if(eq0(vec2_len_squared(data->uvs[i].dimensions))) {
+            continue;
+        }
+
+        aabb_2d box = get_slice_box(data, i, dims);
+        box.position = vec2_sub(box.position, offset);
+        len += build_slice(data, i, box, uv_scale, verts + len);
+    }
+
+    return len;
+}
+
+// Marks the frame dirty if its data has been replaced in place since it was last checked
+static void check_data_revision(frame f) {
+    if(f->data == NULL || f->data->revision == f->data_revision) {
+        return;
+    }
+
+    f->data_revision = f->data->revision;
+    f->is_dirty = true;
+    f->is_damaged = true;
+}
+
+// Rebuilds the mesh data for f
+void frame_rebuild_mesh(frame f) {
+    check_return(f != NULL, "Frame is NULL", );
+
+    check_data_revision(f);
+
+    if(!frame_data_is_ready(f->data)) {
+        // Leave the frame dirty, so that it's fully built once its data finishes loading
+        f->vert_count = 0;
+        f->is_dirty = true;
+        return;
+    }
+
+    ui_stat_time_begin(UI_STAT_TIME_MESH_REBUILD);
+
+    if(f->is_dirty || frame_data_is_tiled(f->data)) {
+        // Tile counts depend on the dimensions, so tiled frames are fully rebuilt when resized
+        bool stretched;
+        uint32 count = count_vertices(f->data, f->dims, &stretched);
+        if(stretched && !f->warned_tile_limit) {
+            warn("Frame needs more than %u tiles per slice to cover %gx%g, so those slices are stretched instead", FRAME_TILE_MAX, f->dims.x, f->dims.y);
+            f->warned_tile_limit = true;
+        }
+        if(count > f->vert_capacity) {
+            // Every vertex is about to be rewritten, so the old contents don't need to be kept
+            if(f->owns_verts) {
+                sfree(f->verts);
+            }
+            f->vert_capacity = max(count, f->vert_capacity * 2);
+            f->verts = salloc(f->vert_capacity * sizeof(vt_pt));
+            f->owns_verts = true;
+        }
+
+        f->vert_count = frame_build_vertices(f->data, f->dims, f->align, f->verts);
+    } else {
+        // Only the dimensions or alignment changed, so the UVs can be kept as-is
+        frame_build_positions(f->data, f->dims, f->align, f->verts);
+    }
+
+    ui_stat_time_end(UI_STAT_TIME_MESH_REBUILD);
+    ui_stat_add(UI_STAT_MESH_REBUILDS, 1);
+
+    f->is_dirty = false;
+    f->is_resized = false;
+    f->needs_upload = true;
+    f->needs_mesh = true;
+}
+
+// Returns true if the frame's vertices are out of date
+bool frame_needs_rebuild(frame f) {
+    check_return(f != NULL, "Frame is NULL", false);
+
+    check_data_revision(f);
+    return f->is_dirty || f->is_resized;
+}
+
+// Gets the frame's vertices, rebuilding them if needed.
+// This doesn't touch GL, so it can be used without a context.
+const vt_pt* frame_get_vertices(frame f, uint32* count) {
+    check_return(f != NULL, "Frame is NULL", NULL);
+
+    check_data_revision(f);
+
+    if(f->is_dirty || f->is_resized) {
+        frame_rebuild_mesh(f);
+    }
+
+    if(count != NULL) {
+        *count = f->vert_count;
+    }
+
+    return f->verts;
 }
 
 // Gets/sets the frame's texture data
@@ -154,7 +427,9 @@ void frame_set_data(frame f, frame_data* data) {
     check_return(f != NULL, "Frame is NULL", );
 
     f->data = data;
+    f->data_revision = data != NULL ? data->revision : 0;
     f->is_dirty = true;
+    f->is_damaged = true;
 }
 
 // Gets/sets the dimensions of the frame
@@ -166,8 +441,13 @@ vec2 frame_get_dimensions(frame f) {
 void frame_set_dimensions(frame f, vec2 dims) {
     check_return(f != NULL, "Frame is NULL", );
 
+    if(dims.x == f->dims.x && dims.y == f->dims.y) {
+        return;
+    }
+
     f->dims = dims;
-    f->is_dirty = true;
+    f->is_resized = true;
+    f->is_damaged = true;
 }
 
 // Gets/sets the alignment of the frame
@@ -180,16 +460,76 @@ void frame_set_align(frame f, alignment_2d align) {
     check_return(f != NULL, "Frame is NULL", );
     check_return(align <= ALIGN_LAST, "Invalid frame alignment 0x%x", , align);
 
+    if(align == f->align) {
+        return;
+    }
+
     f->align = align;
-    f->is_dirty = true;
+    f->is_resized = true;
+    f->is_damaged = true;
+}
+
+aabb_2d frame_get_bounds(frame f) {
+    check_return(f != NULL, "Frame is NULL", (aabb_2d){ 0 });
+
+    return (aabb_2d) {
+        .position = vec2_sub(vec2_zero, get_align_offset(f->dims, f->align)),
+        .dimensions = f->dims
+    };
+}
+
+void frame_report_damage(frame f, ui_damage d, mat4 m) {
+    check_return(f != NULL, "Frame is NULL", );
+    check_return(d != NULL, "Damage tracker is NULL", );
+
+    check_data_revision(f);
+    aabb_2d bounds = ui_damage_transform(frame_get_bounds(f), m);
+    bool moved = bounds.position.x != f->damage_bounds.position.x || bounds.position.y != f->damage_bounds.position.y ||
+                 bounds.dimensions.x != f->damage_bounds.dimensions.x || bounds.dimensions.y != f->damage_bounds.dimensions.y;
+    if(!f->is_damaged && !moved) {
+        return;
+    }
+
+    ui_damage_add(d, f->damage_bounds);
+    ui_damage_add(d, bounds);
+    f->damage_bounds = bounds;
+    f->is_damaged = false;
+}
+
+// Return the frame's vertex buffer, uploading changed vertices in-place
+const ui_buffer* frame_get_buffer(frame f) {
+    check_return(f != NULL, "Frame is NULL", NULL);
+
+    uint32 count = 0;
+    const vt_pt* verts = frame_get_vertices(f, &count);
+
+    if(f->needs_upload) {
+        // The buffer only grows when the vertex count does, so re-uploads reuse it
+        ui_buffer_upload(&f->buffer, verts, count);
+        f->needs_upload = false;
+    }
+
+    return count != 0 ? &f->buffer : NULL;
 }
 
-// Return the frame's generated mesh
+// Return the frame's generated mesh.
+// The mesh is only made when asked for, and is recreated whenever the vertices change.
 const mesh frame_get_mesh(frame f) {
     check_return(f != NULL, "Frame is NULL", NULL);
 
-    if(f->is_dirty || f->m == NULL) {
-        frame_rebuild_mesh(f);
+    uint32 count = 0;
+    const vt_pt* verts = frame_get_vertices(f, &count);
+
+    if(f->needs_mesh || (f->m == NULL && count != 0)) {
+        if(f->m != NULL) {
+            mesh_free(f->m);
+        }
+        if(count != 0) {
+            f->m = mesh_new(count, (vt_pt*)verts, NULL);
+            ui_stat_add(UI_STAT_BUFFER_ALLOCATIONS, 1);
+            ui_stat_add(UI_STAT_UPLOAD_BYTES, count * sizeof(vt_pt));
+        }
+        f->needs_mesh = false;
     }
 
     return f->m;
@@ -197,9 +537,9 @@ const mesh frame_get_mesh(frame f) {
 
 // Helper function to render a frame
 void frame_draw(frame f, shader s, mat4 m) {
-    mesh final_mesh = frame_get_mesh(f);
+    const ui_buffer* final_buffer = frame_get_buffer(f);
 
-    if(final_mesh != NULL) {
+    if(final_buffer != NULL) {
         glUseProgram(s.id);
 
         shader_bind_uniform_name(s, "u_transform", m);
@@ -208,6 +548,6 @@ void frame_draw(frame f, shader s, mat4 m) {
         vec2 v1 = (vec2){.x=1,.y=1};
         shader_bind_uniform_name(s, "uv_offset", v0);
         shader_bind_uniform_name(s, "uv_scale", v1);
-        mesh_render(s, final_mesh, GL_TRIANGLES, "i_pos", VT_POSITION, "i_uv", VT_TEXTURE);
+        ui_buffer_render(&f->buffer, s, f->vert_count);
     }
 }
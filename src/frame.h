@@ -2,28 +2,88 @@
 #define DF_UI_FRAME
 
 #include "frame_data.h"
+#include "ui_arena.h"
+#include "ui_buffer.h"
+#include "ui_damage.h"
 
-#include "graphics/mesh.hd"
+#include "graphics/mesh.h"
 #include "graphics/shader.hd"
 #include "math/alignment.h"
 #include "math/matrix.hd"
 
+// The number of vertices a frame with stretched slices generates at most
+#define FRAME_VERTEX_MAX 54
+
+// The number of tiles a tiled slice can be split into. Slices that would need more are stretched instead.
+#define FRAME_TILE_MAX 1024
+
 typedef struct frame {
     frame_data* data;
+    // The revision of data that the vertices were built from
+    uint32 data_revision;
 
     vec2 dims;
     alignment_2d align;
+
+    // Vertices are kept between rebuilds, so that resizing only rewrites positions.
+    // The buffer is sized for the whole mesh before it's built, and only grows when tiling needs more room.
+    vt_pt* verts;
+    uint32 vert_count;
+    uint32 vert_capacity;
+    // False while verts points into the frame's arena
+    bool owns_verts;
+    ui_buffer buffer;
+    // Only made by frame_get_mesh, for code that still renders frames as meshes
     mesh m;
+
+    // Set for frames created with frame_new_in, which are released with their arena
+    bool in_arena;
+
+    // Set when the frame data changes, and all vertices must be rebuilt
     bool is_dirty;
+    // Set when the dimensions or alignment change, and only positions must be rebuilt
+    bool is_resized;
+    // Set when the vertices have changed since they were last uploaded
+    bool needs_upload;
+    // Set when the vertices have changed since m was made
+    bool needs_mesh;
+    // Set once the frame has warned about stretching slices that needed too many tiles, so it only warns once
+    bool warned_tile_limit;
+
+    // Set when the frame's appearance changes, until it's reported to a damage tracker
+    bool is_damaged;
+    // The screen bounds last reported to a damage tracker
+    aabb_2d damage_bounds;
 }* frame;
 
 // Create a new frame with the given texture data and dimensions
 frame frame_new(frame_data* data, vec2 dims);
 
+// Create a new frame in an arena. It's released along with the arena, and must not be freed with frame_free.
+// Its data isn't owned by the arena.
+frame frame_new_in(ui_arena a, frame_data* data, vec2 dims);
+
 // Frees the frame
 #define frame_free(f, deep) { _frame_free(f, deep); f = NULL; }
 void _frame_free(frame f, bool deep);
 
+// Fills 6 vertices with two triangles covering box, textured with uv_box
+void build_box(vt_pt* verts, aabb_2d box, aabb_2d uv_box);
+
+// Gets the number of vertices a frame with the given data and dimensions generates.
+// Each slice makes at most FRAME_TILE_MAX tiles of 6 vertices, and frame_build_vertices writes exactly this many.
+uint32 frame_get_vertex_count(const frame_data* data, vec2 dims);
+
+// Fills verts with the nine-slice vertices for a frame with the given data, dimensions and alignment.
+// verts must have room for frame_get_vertex_count vertices. Returns the number of vertices written.
+// This doesn't touch GL, so it can be used without a context.
+uint32 frame_build_vertices(const frame_data* data, vec2 dims, alignment_2d align, vt_pt* verts);
+
+// Fills the positions of verts for a frame with the given data, dimensions and alignment, leaving UVs untouched.
+// This only works for data without tiling, since the number of tiles depends on the dimensions.
+// Returns the number of vertices written.
+uint32 frame_build_positions(const frame_data* data, vec2 dims, alignment_2d align, vt_pt* verts);
+
 // Rebuilds the mesh data for f
 void frame_rebuild_mesh(frame f);
 
@@ -39,7 +99,25 @@ void frame_set_dimensions(frame f, vec2 dims);
 alignment_2d frame_get_align(frame f);
 void frame_set_align(frame f, alignment_2d align);
 
-// Return the frame's generated mesh
+// Gets the box the frame covers, relative to its alignment point
+aabb_2d frame_get_bounds(frame f);
+
+// Reports the frame's damage to d, if it has changed or moved since it was last reported.
+// m is the transform the frame is drawn with. Both the old and new screen bounds are damaged.
+void frame_report_damage(frame f, ui_damage d, mat4 m);
+
+// Returns true if the frame's vertices are out of date, including when its data has been reloaded since they were built
+bool frame_needs_rebuild(frame f);
+
+// Gets the frame's vertices, rebuilding them if needed.
+// This doesn't touch GL, so it can be used without a context.
+const vt_pt* frame_get_vertices(frame f, uint32* count);
+
+// Return the frame's vertex buffer, uploading changed vertices in-place. This is what frame_draw renders.
+const ui_buffer* frame_get_buffer(frame f);
+
+// Return the frame's generated mesh, or NULL if it has no vertices.
+// The mesh is recreated whenever the vertices change, so frame_get_buffer is cheaper for frames that are resized often.
 const mesh frame_get_mesh(frame f);
 
 // Helper function to render a frame
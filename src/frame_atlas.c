@@ -0,0 +1,443 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_atlas.h"
+#include "frame_io.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Create an empty atlas. padding transparent pixels are left between packed rectangles.
+frame_atlas frame_atlas_new(uint16 page_width, uint16 page_height, uint16 padding) {
+    check_return(page_width != 0 && page_height != 0, "Atlas pages can't be empty", NULL);
+
+    frame_atlas a = mscalloc(1, struct frame_atlas);
+    a->page_width = page_width;
+    a->page_height = page_height;
+    a->padding = padding;
+    a->pages = NULL;
+    a->page_count = 0;
+
+    return a;
+}
+
+// Frees the atlas, including any uploaded page textures
+void _frame_atlas_free(frame_atlas a) {
+    check_return(a != NULL, "Atlas is NULL", );
+
+    for(uint16 i = 0; i < a->page_count; ++i) {
+        frame_image_cleanup(&a->pages[i].image);
+        if(a->pages[i].texture.handle != 0) {
+            gltex_cleanup(&a->pages[i].texture);
+        }
+        sfree(a->pages[i].nodes);
+    }
+    sfree(a->pages);
+    sfree(a);
+}
+
+static frame_atlas_page* add_page(frame_atlas a) {
+    a->pages = srealloc(a->pages, (a->page_count + 1) * sizeof(frame_atlas_page));
+
+    frame_atlas_page* page = &a->pages[a->page_count++];
+    memset(page, 0, sizeof(frame_atlas_page));
+    frame_image_init(&page->image, a->page_width, a->page_height);
+
+    page->node_capacity = 16;
+    page->nodes = scalloc(page->node_capacity, sizeof(frame_atlas_node));
+    page->nodes[0] = (frame_atlas_node) { .x = 0, .y = 0, .width = a->page_width };
+    page->node_count = 1;
+
+    return page;
+}
+
+// Finds the height at which a rectangle placed at the start of node index would rest, or -1 if it doesn't fit
+static int32 skyline_fit(frame_atlas a, const frame_atlas_page* page, uint16 index, uint16 width, uint16 height) {
+    const frame_atlas_node* node = &page->nodes[index];
+    if((uint32)node->x + width > a->page_width) {
+        return -1;
+    }
+
+    int32 y = node->y;
+    int32 remaining = width;
+    for(uint16 i = index; remaining > 0; ++i) {
+        y = max(y, (int32)page->nodes[i].y);
+        if(y + height > a->page_height) {
+            return -1;
+        }
+        remaining -= page->nodes[i].width;
+    }
+
+    return y;
+}
+
+static void remove_node(frame_atlas_page* page, uint16 index) {
+    memmove(page->nodes + index, page->nodes + index + 1, (page->node_count - index - 1) * sizeof(frame_atlas_node));
+    --page->node_count;
+}
+
+// Raises the skyline to cover a rectangle placed at the start of node index
+static void skyline_insert(frame_atlas_page* page, uint16 index, uint16 x, uint16 y, uint16 width, uint16 height) {
+    if(page->node_count == page->node_capacity) {
+        page->node_capacity *= 2;
+        page->nodes = srealloc(page->nodes, page->node_capacity * sizeof(frame_atlas_node));
+    }
+
+    memmove(page->nodes + index + 1, page->nodes + index, (page->node_count - index) * sizeof(frame_atlas_node));
+    page->nodes[index] = (frame_atlas_node) { .x = x, .y = y + height, .width = width };
+    ++page->node_count;
+
+    // Cut the new node's span out of the nodes after it
+    while(index + 1 < page->node_count) {
+        frame_atlas_node* prev = &page->nodes[index];
+        frame_atlas_node* node = &page->nodes[index + 1];
+        uint16 prev_end = prev->x + prev->width;
+        if(node->x >= prev_end) {
+            break;
+        }
+
+        uint16 overlap = prev_end - node->x;
+        if(node->width <= overlap) {
+            remove_node(page, index + 1);
+        } else {
+            node->x += overlap;
+            node->width -= overlap;
+            break;
+        }
+    }
+
+    // Merge neighbours at the same height
+    for(uint16 i = 0; i + 1 < page->node_count;) {
+        if(page->nodes[i].y == page->nodes[i + 1].y) {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            remove_node(page, i + 1);
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Tries to pack a rectangle into a page, choosing the position with the lowest top edge
+static bool pack_in_page(frame_atlas a, frame_atlas_page* page, uint16 width, uint16 height, uint16* x, uint16* y) {
+    int32 best_top = -1;
+    uint16 best_index = 0;
+    for(uint16 i = 0; i < page->node_count; ++i) {
+        int32 fit = skyline_fit(a, page, i, width, height);
+        if(fit >= 0 && (best_top < 0 || fit + height < best_top)) {
+            best_top = fit + height;
+            best_index = i;
+        }
+    }
+
+    if(best_top < 0) {
+        return false;
+    }
+
+    *x = page->nodes[best_index].x;
+    *y = best_top - height;
+    skyline_insert(page, best_index, *x, *y, width, height);
+
+    return true;
+}
+
+// Reserve space for a width x height rectangle, adding a page if needed.
+// Returns the page index, or FRAME_ATLAS_PAGE_INVALID if the rectangle is larger than a page.
+uint16 frame_atlas_pack_rect(frame_atlas a, uint16 width, uint16 height, uint16* x, uint16* y) {
+    check_return(a != NULL, "Atlas is NULL", FRAME_ATLAS_PAGE_INVALID);
+
+    uint32 padded_width = (uint32)width + a->padding;
+    uint32 padded_height = (uint32)height + a->padding;
+    check_return(padded_width <= a->page_width && padded_height <= a->page_height,
+            "Rectangle %ux%u doesn't fit in a %ux%u atlas page", FRAME_ATLAS_PAGE_INVALID, width, height, a->page_width, a->page_height);
+
+    uint16 index = 0;
+    for(; index < a->page_count; ++index) {
+        if(pack_in_page(a, &a->pages[index], padded_width, padded_height, x, y)) {
+            break;
+        }
+    }
+
+    if(index == a->page_count) {
+        pack_in_page(a, add_page(a), padded_width, padded_height, x, y);
+    }
+
+    a->pages[index].used_area += (uint64)width * height;
+
+    return index;
+}
+
+// Copy a frame's source pixels from source into the atlas, and rewrite its UVs to atlas coordinates.
+// The frame's texture is replaced with an empty placeholder, and its previous texture isn't freed.
+// The placeholder stays empty until frame_atlas_upload gives the frame the page's texture.
+// Returns the page index, or FRAME_ATLAS_PAGE_INVALID on failure.
+uint16 frame_atlas_add_frame(frame_atlas a, frame_data* f, const frame_image* source) {
+    check_return(a != NULL, "Atlas is NULL", FRAME_ATLAS_PAGE_INVALID);
+    check_return(f != NULL, "Frame is NULL", FRAME_ATLAS_PAGE_INVALID);
+    check_return(source != NULL && source->pixels != NULL, "Source image is empty", FRAME_ATLAS_PAGE_INVALID);
+
+    // The source rectangle covers every non-empty slice
+    float left = INFINITY, top = INFINITY, right = -INFINITY, bottom = -INFINITY;
+    for(uint8 i = 0; i < 9; ++i) {
+        if(eq0(vec2_len_squared(f->uvs[i].dimensions))) {
+            continue;
+        }
+        left = min(left, f->uvs[i].position.x);
+        top = min(top, f->uvs[i].position.y);
+        right = max(right, f->uvs[i].position.x + f->uvs[i].dimensions.x);
+        bottom = max(bottom, f->uvs[i].position.y + f->uvs[i].dimensions.y);
+    }
+    check_return(left < right && top < bottom, "Frame has no area to pack", FRAME_ATLAS_PAGE_INVALID);
+
+    int32 src_x = floorf(left);
+    int32 src_y = floorf(top);
+    int32 width = ceilf(right) - src_x;
+    int32 height = ceilf(bottom) - src_y;
+    check_return(src_x >= 0 && src_y >= 0 && src_x + width <= source->width && src_y + height <= source->height,
+            "Frame's source rectangle is outside of its %ux%u image", FRAME_ATLAS_PAGE_INVALID, source->width, source->height);
+
+    uint16 x, y;
+    uint16 index = frame_atlas_pack_rect(a, width, height, &x, &y);
+    if(index == FRAME_ATLAS_PAGE_INVALID) {
+        return index;
+    }
+
+    frame_image* dest = &a->pages[index].image;
+    for(int32 row = 0; row < height; ++row) {
+        memcpy(dest->pixels + ((size_t)(y + row) * dest->width + x) * 4,
+               source->pixels + ((size_t)(src_y + row) * source->width + src_x) * 4,
+               (size_t)width * 4);
+    }
+
+    vec2 offset = { .x = (float)x - src_x, .y = (float)y - src_y };
+    for(uint8 i = 0; i < 9; ++i) {
+        f->uvs[i].position = vec2_add(f->uvs[i].position, offset);
+    }
+
+    // The placeholder stays empty, so the frame isn't ready until frame_atlas_upload sizes it
+    memset(&f->texture, 0, sizeof(gltex));
+
+    return index;
+}
+
+typedef struct build_item {
+    uint32 index;
+    float height;
+} build_item;
+
+static int compare_build_items(const void* a, const void* b) {
+    const build_item* item_a = a;
+    const build_item* item_b = b;
+    if(item_a->height != item_b->height) {
+        return item_a->height < item_b->height ? 1 : -1;
+    }
+
+    return item_a->index < item_b->index ? -1 : (item_a->index > item_b->index);
+}
+
+// Load the frame files in frame_paths into frames, packing them all into the atlas.
+// Frames are packed tallest first, and each source image is only decoded once. pages receives each frame's page index.
+// Returns true if every frame was packed.
+bool frame_atlas_build(frame_atlas a, const char* const* frame_paths, uint32 count, frame_data* frames, uint16* pages) {
+    check_return(a != NULL, "Atlas is NULL", false);
+    check_return(count == 0 || (frame_paths != NULL && frames != NULL && pages != NULL), "Atlas build inputs are NULL", false);
+
+    bool success = true;
+    char** texture_paths = scalloc(count == 0 ? 1 : count, sizeof(char*));
+    build_item* items = scalloc(count == 0 ? 1 : count, sizeof(build_item));
+
+    for(uint32 i = 0; i < count; ++i) {
+        pages[i] = FRAME_ATLAS_PAGE_INVALID;
+        memset(&frames[i], 0, sizeof(frame_data));
+
+        if(load_frame_properties(frame_paths[i], &frames[i], &texture_paths[i])) {
+            frames[i].asset_path = nstrdup(frame_paths[i]);
+        } else {
+            success = false;
+        }
+
+        items[i] = (build_item) { .index = i, .height = frame_data_get_box(&frames[i]).dimensions.y };
+    }
+
+    qsort(items, count, sizeof(build_item), compare_build_items);
+
+    // Decoded source images, so that frames sharing an image only decode it once
+    char** image_paths = scalloc(count == 0 ? 1 : count, sizeof(char*));
+    frame_image* images = scalloc(count == 0 ? 1 : count, sizeof(frame_image));
+    uint32 image_count = 0;
+
+    for(uint32 i = 0; i < count; ++i) {
+        uint32 index = items[i].index;
+        if(texture_paths[index] == NULL) {
+            continue;
+        }
+
+        uint32 image = 0;
+        while(image < image_count && strcmp(image_paths[image], texture_paths[index]) != 0) {
+            ++image;
+        }
+        if(image == image_count) {
+            if(!frame_image_load(texture_paths[index], &images[image])) {
+                success = false;
+                continue;
+            }
+            image_paths[image] = texture_paths[index];
+            ++image_count;
+        }
+
+        pages[index] = frame_atlas_add_frame(a, &frames[index], &images[image]);
+        success = success && pages[index] != FRAME_ATLAS_PAGE_INVALID;
+    }
+
+    for(uint32 i = 0; i < image_count; ++i) {
+        frame_image_cleanup(&images[i]);
+    }
+    for(uint32 i = 0; i < count; ++i) {
+        sfree(texture_paths[i]);
+    }
+    sfree(images);
+    sfree(image_paths);
+    sfree(texture_paths);
+    sfree(items);
+
+    return success;
+}
+
+// Create textures for every page, and point frames at them
+void frame_atlas_upload(frame_atlas a, frame_data* frames, const uint16* pages, uint32 count) {
+    check_return(a != NULL, "Atlas is NULL", );
+
+    for(uint16 i = 0; i < a->page_count; ++i) {
+        if(a->pages[i].texture.handle == 0) {
+            a->pages[i].texture = frame_image_upload(&a->pages[i].image, NULL);
+        }
+    }
+
+    for(uint32 i = 0; i < count; ++i) {
+        if(pages[i] < a->page_count) {
+            frames[i].texture = a->pages[pages[i]].texture;
+        }
+    }
+}
+
+// Gets the name of the file a frame is saved to, which must be freed
+static char* get_frame_file_name(const char* name, const frame_data* f, uint32 index) {
+    const char* asset_name = f->asset_path;
+    if(asset_name == NULL) {
+        char* generated = salloc(strlen(name) + 24);
+        sprintf(generated, "%s_frame%u.xml", name, index);
+        return generated;
+    }
+
+    if(strrchr(asset_name, '/') != NULL) {
+        asset_name = strrchr(asset_name, '/') + 1;
+    }
+
+    return nstrdup(asset_name);
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Write every page to folder as <name><index>.png, and each frame next to them as an xml file named after its asset.
+// Frames without an asset path are named <name>_frame<index>.xml.
+// Nothing is written if two frames would be saved to the same file. Returns true on success.
+bool frame_atlas_save(frame_atlas a, const char* folder, const char* name, const frame_data* frames, const uint16* pages, uint32 count) {
+    check_return(a != NULL, "Atlas is NULL", false);
+    check_return(folder != NULL && name != NULL, "Atlas save path is NULL", false);
+    check_return(count == 0 || (frames != NULL && pages != NULL), "Atlas save inputs are NULL", false);
+
+    // Frames from different folders can share a file name, which would overwrite each other
+    char** file_names = scalloc(count == 0 ? 1 : count, sizeof(char*));
+    char** sorted_names = scalloc(count == 0 ? 1 : count, sizeof(char*));
+    uint32 saved_count = 0;
+    for(uint32 i = 0; i < count; ++i) {
+        if(pages[i] < a->page_count) {
+            file_names[i] = get_frame_file_name(name, &frames[i], i);
+            sorted_names[saved_count++] = file_names[i];
+        }
+    }
+
+    bool success = true;
+    qsort(sorted_names, saved_count, sizeof(char*), compare_names);
+    for(uint32 i = 1; i < saved_count && success; ++i) {
+        if(strcmp(sorted_names[i - 1], sorted_names[i]) == 0) {
+            error("More than one frame would be saved to %s/%s", folder, sorted_names[i]);
+            success = false;
+        }
+    }
+
+    size_t path_len = strlen(folder) + strlen(name) + 32;
+    char* page_name = salloc(strlen(name) + 16);
+    char* path = salloc(path_len);
+
+    for(uint16 i = 0; i < a->page_count && success; ++i) {
+        sprintf(page_name, "%s%u.png", name, i);
+        snprintf(path, path_len, "%s/%s", folder, page_name);
+        success = frame_image_save(path, &a->pages[i].image);
+    }
+
+    for(uint32 i = 0; i < count && success; ++i) {
+        if(file_names[i] == NULL) {
+            continue;
+        }
+
+        char* frame_path = salloc(strlen(folder) + strlen(file_names[i]) + 2);
+        sprintf(frame_path, "%s/%s", folder, file_names[i]);
+
+        // Frames reference their page relative to their own file, which sits next to the page
+        sprintf(page_name, "%s%u.png", name, pages[i]);
+        frame_data f = frames[i];
+        f.texture.asset_path = page_name;
+        save_frame(frame_path, &f);
+
+        sfree(frame_path);
+    }
+
+    for(uint32 i = 0; i < count; ++i) {
+        sfree(file_names[i]);
+    }
+    sfree(file_names);
+    sfree(sorted_names);
+    sfree(page_name);
+    sfree(path);
+
+    return success;
+}
+
+// Get the number of pages in the atlas
+uint16 frame_atlas_get_page_count(frame_atlas a) {
+    check_return(a != NULL, "Atlas is NULL", 0);
+
+    return a->page_count;
+}
+
+// Get the pixels of a page
+const frame_image* frame_atlas_get_page(frame_atlas a, uint16 index) {
+    check_return(a != NULL, "Atlas is NULL", NULL);
+    check_return(index < a->page_count, "Page index %u is out of range", NULL, index);
+
+    return &a->pages[index].image;
+}
+
+// Get the fraction of the atlas' total page area that's been packed with rectangles
+float frame_atlas_get_occupancy(frame_atlas a) {
+    check_return(a != NULL, "Atlas is NULL", 0);
+
+    if(a->page_count == 0) {
+        return 0;
+    }
+
+    uint64 used = 0;
+    for(uint16 i = 0; i < a->page_count; ++i) {
+        used += a->pages[i].used_area;
+    }
+
+    return (double)used / ((double)a->page_count * a->page_width * a->page_height);
+}
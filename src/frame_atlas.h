@@ -0,0 +1,78 @@
+#ifndef DF_UI_FRAME_ATLAS
+#define DF_UI_FRAME_ATLAS
+
+#include "frame_data.h"
+#include "frame_image.h"
+
+#define FRAME_ATLAS_PAGE_INVALID 0xFFFF
+
+// A horizontal segment of a page's skyline. Everything below y is occupied.
+typedef struct frame_atlas_node {
+    uint16 x;
+    uint16 y;
+    uint16 width;
+} frame_atlas_node;
+
+// A single atlas texture, packed with a bottom-left skyline
+typedef struct frame_atlas_page {
+    frame_image image;
+    gltex texture;
+
+    frame_atlas_node* nodes;
+    uint16 node_count;
+    uint16 node_capacity;
+
+    uint64 used_area;
+} frame_atlas_page;
+
+// Packs the source rectangles of many frames into shared pages, so that they can be drawn with fewer textures.
+// Packing works on plain pixel buffers, and only frame_atlas_upload needs GL.
+typedef struct frame_atlas {
+    uint16 page_width;
+    uint16 page_height;
+    uint16 padding;
+
+    frame_atlas_page* pages;
+    uint16 page_count;
+}* frame_atlas;
+
+// Create an empty atlas. padding transparent pixels are left between packed rectangles.
+frame_atlas frame_atlas_new(uint16 page_width, uint16 page_height, uint16 padding);
+
+// Frees the atlas, including any uploaded page textures
+#define frame_atlas_free(a) { _frame_atlas_free(a); a = NULL; }
+void _frame_atlas_free(frame_atlas a);
+
+// Reserve space for a width x height rectangle, adding a page if needed.
+// Returns the page index, or FRAME_ATLAS_PAGE_INVALID if the rectangle is larger than a page.
+uint16 frame_atlas_pack_rect(frame_atlas a, uint16 width, uint16 height, uint16* x, uint16* y);
+
+// Copy a frame's source pixels from source into the atlas, and rewrite its UVs to atlas coordinates.
+// The frame's texture is replaced with an empty placeholder, and its previous texture isn't freed.
+// The frame isn't ready to draw until frame_atlas_upload gives it the page's texture.
+// Returns the page index, or FRAME_ATLAS_PAGE_INVALID on failure.
+uint16 frame_atlas_add_frame(frame_atlas a, frame_data* f, const frame_image* source);
+
+// Load the frame files in frame_paths into frames, packing them all into the atlas.
+// Frames are packed tallest first, and each source image is only decoded once. pages receives each frame's page index.
+// Returns true if every frame was packed.
+bool frame_atlas_build(frame_atlas a, const char* const* frame_paths, uint32 count, frame_data* frames, uint16* pages);
+
+// Create textures for every page, and point frames at them
+void frame_atlas_upload(frame_atlas a, frame_data* frames, const uint16* pages, uint32 count);
+
+// Write every page to folder as <name><index>.png, and each frame next to them as an xml file named after its asset.
+// Frames without an asset path are named <name>_frame<index>.xml.
+// Nothing is written if two frames would be saved to the same file. Returns true on success.
+bool frame_atlas_save(frame_atlas a, const char* folder, const char* name, const frame_data* frames, const uint16* pages, uint32 count);
+
+// Get the number of pages in the atlas
+uint16 frame_atlas_get_page_count(frame_atlas a);
+
+// Get the pixels of a page
+const frame_image* frame_atlas_get_page(frame_atlas a, uint16 index);
+
+// Get the fraction of the atlas' total page area that's been packed with rectangles
+float frame_atlas_get_occupancy(frame_atlas a);
+
+#endif // DF_UI_FRAME_ATLAS
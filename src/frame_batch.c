@@ -0,0 +1,178 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_batch.h"
+#include "ui_stats.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "graphics/shader.h"
+
+// Create a new, empty frame batch
+frame_batch frame_batch_new() {
+    frame_batch b = mscalloc(1, struct frame_batch);
+    b->groups = NULL;
+    b->group_count = 0;
+    b->group_capacity = 0;
+    ui_buffer_init(&b->buffer);
+
+    return b;
+}
+
+// Frees the batch
+void _frame_batch_free(frame_batch b) {
+    check_return(b != NULL, "Batch is NULL", );
+
+    for(uint16 i = 0; i < b->group_capacity; ++i) {
+        sfree(b->groups[i].verts);
+    }
+    sfree(b->groups);
+    ui_buffer_cleanup(&b->buffer);
+
+    sfree(b);
+}
+
+// Finds the group for tex, creating it if it doesn't exist
+static frame_batch_group* get_group(frame_batch b, gltex tex) {
+    for(uint16 i = 0; i < b->group_count; ++i) {
+        if(b->groups[i].texture.handle == tex.handle) {
+            return &b->groups[i];
+        }
+    }
+
+    if(b->group_count == b->group_capacity) {
+        uint16 capacity = b->group_capacity == 0 ? 4 : b->group_capacity * 2;
+        b->groups = srealloc(b->groups, capacity * sizeof(frame_batch_group));
+        for(uint16 i = b->group_capacity; i < capacity; ++i) {
+            b->groups[i] = (frame_batch_group) {
+                .verts = NULL,
+                .vert_count = 0,
+                .vert_capacity = 0
+            };
+        }
+        b->group_capacity = capacity;
+    }
+
+    // Groups past group_count keep their vertex storage from previous frames
+    frame_batch_group* group = &b->groups[b->group_count++];
+    group->texture = tex;
+    group->vert_count = 0;
+
+    return group;
+}
+
+// Applies the transform m to the point p
+static vec3 transform_point(mat4 m, vec3 p) {
+    return (vec3) {
+        .x = m.data[0] * p.x + m.data[4] * p.y + m.data[8]  * p.z + m.data[12],
+        .y = m.data[1] * p.x + m.data[5] * p.y + m.data[9]  * p.z + m.data[13],
+        .z = m.data[2] * p.x + m.data[6] * p.y + m.data[10] * p.z + m.data[14],
+    };
+}
+
+// Adds a frame to the batch, with its vertices transformed by m.
+// This doesn't touch GL, so batches can be built without a context.
+void frame_batch_add(frame_batch b, frame f, mat4 m) {
+    check_return(b != NULL, "Batch is NULL", );
+    check_return(f != NULL, "Frame is NULL", );
+
+    if(f->data == NULL) {
+        return;
+    }
+
+    // Reuse the frame's cached vertices, so unchanged frames aren't rebuilt every time they're batched
+    uint32 len = 0;
+    const vt_pt* src = frame_get_vertices(f, &len);
+    if(len == 0) {
+        // Frames still loading have no texture yet, and shouldn't leave an empty group behind
+        return;
+    }
+
+    frame_batch_group* group = get_group(b, f->data->texture);
+    if(group->vert_count + len > group->vert_capacity) {
+        uint32 capacity = group->vert_capacity == 0 ? FRAME_VERTEX_MAX * 8 : group->vert_capacity * 2;
+        while(capacity < group->vert_count + len) {
+            capacity *= 2;
+        }
+        group->verts = srealloc(group->verts, capacity * sizeof(vt_pt));
+        group->vert_capacity = capacity;
+    }
+
+    vt_pt* verts = group->verts + group->vert_count;
+    for(uint32 i = 0; i < len; ++i) {
+        verts[i] = (vt_pt) {
+            .position = transform_point(m, src[i].position),
+            .uv = src[i].uv
+        };
+    }
+
+    group->vert_count += len;
+}
+
+// Removes all frames from the batch, keeping allocated storage for reuse
+void frame_batch_clear(frame_batch b) {
+    check_return(b != NULL, "Batch is NULL", );
+
+    b->group_count = 0;
+}
+
+// Gets the number of texture groups in the batch
+uint16 frame_batch_get_group_count(frame_batch b) {
+    check_return(b != NULL, "Batch is NULL", 0);
+
+    return b->group_count;
+}
+
+// Gets a texture group in the batch
+const frame_batch_group* frame_batch_get_group(frame_batch b, uint16 index) {
+    check_return(b != NULL, "Batch is NULL", NULL);
+    check_return(index < b->group_count, "Group index %u is out of range", NULL, index);
+
+    return &b->groups[index];
+}
+
+// Gets the total number of vertices in the batch
+uint32 frame_batch_get_vertex_count(frame_batch b) {
+    check_return(b != NULL, "Batch is NULL", 0);
+
+    uint32 count = 0;
+    for(uint16 i = 0; i < b->group_count; ++i) {
+        count += b->groups[i].vert_count;
+    }
+
+    return count;
+}
+
+// Draws each texture group with a single draw call, then clears the batch
+void frame_batch_flush(frame_batch b, shader s, mat4 vp) {
+    check_return(b != NULL, "Batch is NULL", );
+
+    if(b->group_count == 0) {
+        return;
+    }
+
+    ui_stat_time_begin(UI_STAT_TIME_BATCH_FLUSH);
+
+    glUseProgram(s.id);
+
+    shader_bind_uniform_name(s, "u_transform", vp);
+    vec2 v0 = vec2_zero;
+    vec2 v1 = (vec2){.x=1,.y=1};
+    shader_bind_uniform_name(s, "uv_offset", v0);
+    shader_bind_uniform_name(s, "uv_scale", v1);
+
+    for(uint16 i = 0; i < b->group_count; ++i) {
+        frame_batch_group* group = &b->groups[i];
+        if(group->vert_count == 0) {
+            continue;
+        }
+
+        shader_bind_uniform_texture_name(s, "u_texture", group->texture, GL_TEXTURE0);
+        ui_buffer_upload(&b->buffer, group->verts, group->vert_count);
+        ui_buffer_render(&b->buffer, s, group->vert_count);
+    }
+
+    ui_stat_time_end(UI_STAT_TIME_BATCH_FLUSH);
+
+    frame_batch_clear(b);
+}
@@ -0,0 +1,54 @@
+#ifndef DF_UI_FRAME_BATCH
+#define DF_UI_FRAME_BATCH
+
+#include "frame.h"
+#include "ui_buffer.h"
+
+#include "math/matrix.h"
+
+// A set of transformed frame vertices that share a texture
+typedef struct frame_batch_group {
+    gltex texture;
+
+    vt_pt* verts;
+    uint32 vert_count;
+    uint32 vert_capacity;
+} frame_batch_group;
+
+// Accumulates many frames into per-texture vertex streams, so that they can be drawn
+// with one draw call per texture instead of one per frame
+typedef struct frame_batch {
+    frame_batch_group* groups;
+    uint16 group_count;
+    uint16 group_capacity;
+
+    ui_buffer buffer;
+}* frame_batch;
+
+// Create a new, empty frame batch
+frame_batch frame_batch_new();
+
+// Frees the batch
+#define frame_batch_free(b) { _frame_batch_free(b); b = NULL; }
+void _frame_batch_free(frame_batch b);
+
+// Adds a frame to the batch, with its vertices transformed by m.
+// This doesn't touch GL, so batches can be built without a context.
+void frame_batch_add(frame_batch b, frame f, mat4 m);
+
+// Removes all frames from the batch, keeping allocated storage for reuse
+void frame_batch_clear(frame_batch b);
+
+// Gets the number of texture groups in the batch
+uint16 frame_batch_get_group_count(frame_batch b);
+
+// Gets a texture group in the batch
+const frame_batch_group* frame_batch_get_group(frame_batch b, uint16 index);
+
+// Gets the total number of vertices in the batch
+uint32 frame_batch_get_vertex_count(frame_batch b);
+
+// Draws each texture group with a single draw call, then clears the batch
+void frame_batch_flush(frame_batch b, shader s, mat4 vp);
+
+#endif // DF_UI_FRAME_BATCH
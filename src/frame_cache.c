@@ -0,0 +1,338 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_cache.h"
+#include "frame_io.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
+#include "resource/texture_loader.h"
+
+#include <string.h>
+
+static gltex default_load_texture(const char* path, void* user) {
+    return load_texture_gl(path);
+}
+static void default_release_texture(gltex* tex, void* user) {
+    gltex_cleanup(tex);
+}
+
+// Create a new cache, which loads textures with load_texture_gl
+frame_cache frame_cache_new() {
+    frame_cache c = mscalloc(1, struct frame_cache);
+    c->frames = array_mnew_ordered(frame_cache_frame*, 16);
+    c->textures = array_mnew_ordered(frame_cache_texture*, 16);
+    c->generation = 0;
+    c->load_texture = default_load_texture;
+    c->release_texture = default_release_texture;
+    c->loader_data = NULL;
+
+    return c;
+}
+
+// Frees the cache and everything in it, whether or not it's still referenced
+void _frame_cache_free(frame_cache c) {
+    check_return(c != NULL, "Frame cache is NULL", );
+
+    array_foreach(c->frames, it) {
+        frame_cache_frame* entry = array_iter_data(it, frame_cache_frame*);
+        sfree(entry->data.asset_path);
+        sfree(entry->path);
+        sfree(entry);
+    }
+    array_foreach(c->textures, it) {
+        frame_cache_texture* entry = array_iter_data(it, frame_cache_texture*);
+        c->release_texture(&entry->texture, c->loader_data);
+        sfree(entry->path);
+        sfree(entry);
+    }
+
+    array_free(c->frames);
+    array_free(c->textures);
+    sfree(c);
+}
+
+// Replace the functions used to load and release textures
+void frame_cache_set_texture_loader(frame_cache c, frame_texture_load_func load, frame_texture_release_func release, void* user) {
+    check_return(c != NULL, "Frame cache is NULL", );
+    check_return(load != NULL && release != NULL, "Texture loader functions can't be NULL", );
+
+    c->load_texture = load;
+    c->release_texture = release;
+    c->loader_data = user;
+}
+
+// Gets a copy of path with repeated slashes and "." segments removed, and ".." segments cancelling the segment
+// before them, so that different spellings of the same file are cached once. The copy must be freed.
+// This is done on the text alone, without touching the file system.
+static char* normalize_path(const char* path) {
+    bool is_absolute = path[0] == '/';
+    size_t root_len = is_absolute ? 1 : 0;
+    char* result = salloc(strlen(path) + 2);
+    size_t len = 0;
+    if(is_absolute) {
+        result[len++] = '/';
+    }
+
+    // The number of segments at the end of result that a ".." can cancel
+    uint32 removable = 0;
+    const char* next = path;
+    while(*next != '\0') {
+        while(*next == '/') {
+            ++next;
+        }
+        const char* segment = next;
+        while(*next != '\0' && *next != '/') {
+            ++next;
+        }
+        size_t segment_len = next - segment;
+
+        bool is_parent = segment_len == 2 && segment[0] == '.' && segment[1] == '.';
+        if(segment_len == 0 || (segment_len == 1 && segment[0] == '.')) {
+            continue;
+        }
+        if(is_parent && removable > 0) {
+            while(len > root_len && result[len - 1] != '/') {
+                --len;
+            }
+            if(len > root_len) {
+                --len;
+            }
+            --removable;
+            continue;
+        }
+        if(is_parent && is_absolute) {
+            // The root's parent is itself
+            continue;
+        }
+
+        if(len > root_len) {
+            result[len++] = '/';
+        }
+        memcpy(result + len, segment, segment_len);
+        len += segment_len;
+        removable += is_parent ? 0 : 1;
+    }
+
+    if(len == 0) {
+        result[len++] = '.';
+    }
+    result[len] = '\0';
+
+    return result;
+}
+
+// Finds a frame by its normalized path
+static frame_cache_frame* find_frame(frame_cache c, const char* path) {
+    array_foreach(c->frames, it) {
+        frame_cache_frame* entry = array_iter_data(it, frame_cache_frame*);
+        if(strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// Finds a texture by its normalized path
+static frame_cache_texture* find_texture(frame_cache c, const char* path) {
+    array_foreach(c->textures, it) {
+        frame_cache_texture* entry = array_iter_data(it, frame_cache_texture*);
+        if(strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// Gets the texture at path, loading it if needed
+static frame_cache_texture* acquire_texture(frame_cache c, const char* path) {
+    char* normalized = normalize_path(path);
+    frame_cache_texture* entry = find_texture(c, normalized);
+    if(entry == NULL) {
+        entry = mscalloc(1, frame_cache_texture);
+        entry->path = normalized;
+        normalized = NULL;
+        entry->texture = c->load_texture(entry->path, c->loader_data);
+        entry->refs = 0;
+        array_add(c->textures, entry);
+        ++c->generation;
+    }
+
+    sfree(normalized);
+    ++entry->refs;
+    return entry;
+}
+
+static void release_texture(frame_cache c, frame_cache_texture* tex) {
+    if(--tex->refs != 0) {
+        return;
+    }
+
+    array_foreach(c->textures, it) {
+        if(array_iter_data(it, frame_cache_texture*) == tex) {
+            array_remove_iter(c->textures, &it);
+            ++c->generation;
+            break;
+        }
+    }
+
+    c->release_texture(&tex->texture, c->loader_data);
+    sfree(tex->path);
+    sfree(tex);
+}
+
+// Load the frame at path, or return the already-loaded copy. Returns NULL on failure.
+frame_data* frame_cache_load(frame_cache c, const char* path) {
+    check_return(c != NULL, "Frame cache is NULL", NULL);
+    check_return(path != NULL, "Frame path is NULL", NULL);
+
+    char* normalized = normalize_path(path);
+    frame_cache_frame* entry = find_frame(c, normalized);
+    if(entry != NULL) {
+        sfree(normalized);
+        ++entry->refs;
+        return &entry->data;
+    }
+
+    frame_data data;
+    char* texture_path = NULL;
+    if(!load_frame_properties(normalized, &data, &texture_path)) {
+        sfree(normalized);
+        return NULL;
+    }
+
+    entry = mscalloc(1, frame_cache_frame);
+    entry->path = normalized;
+    entry->texture = acquire_texture(c, texture_path);
+    entry->refs = 1;
+    sfree(texture_path);
+
+    entry->data = data;
+    entry->data.texture = entry->texture->texture;
+    entry->data.asset_path = nstrdup(normalized);
+
+    array_add(c->frames, entry);
+    ++c->generation;
+
+    return &entry->data;
+}
+
+// Release a frame returned by frame_cache_load
+void frame_cache_release(frame_cache c, frame_data* data) {
+    check_return(c != NULL, "Frame cache is NULL", );
+    check_return(data != NULL, "Frame data is NULL", );
+
+    array_foreach(c->frames, it) {
+        frame_cache_frame* entry = array_iter_data(it, frame_cache_frame*);
+        if(&entry->data != data) {
+            continue;
+        }
+
+        if(--entry->refs == 0) {
+            array_remove_iter(c->frames, &it);
+            ++c->generation;
+
+            release_texture(c, entry->texture);
+            sfree(entry->data.asset_path);
+            sfree(entry->path);
+            sfree(entry);
+        }
+        return;
+    }
+
+    error("Frame data %p wasn't loaded by this cache", data);
+}
+
+// Reload the frame file at path, replacing its data in place
+bool frame_cache_reload(frame_cache c, const char* path) {
+    check_return(c != NULL, "Frame cache is NULL", false);
+    check_return(path != NULL, "Frame path is NULL", false);
+
+    char* normalized = normalize_path(path);
+    frame_cache_frame* entry = find_frame(c, normalized);
+    sfree(normalized);
+    check_return(entry != NULL, "Frame %s isn't in the cache", false, path);
+
+    frame_data data;
+    char* texture_path = NULL;
+    if(!load_frame_properties(entry->path, &data, &texture_path)) {
+        return false;
+    }
+
+    // Acquire the new texture before releasing the old one, so an unchanged texture isn't reloaded
+    frame_cache_texture* texture = acquire_texture(c, texture_path);
+    release_texture(c, entry->texture);
+    entry->texture = texture;
+    sfree(texture_path);
+
+    // The data's address and asset path stay the same, so frames pointing at it pick up the change
+    memcpy(entry->data.uvs, data.uvs, sizeof(data.uvs));
+    entry->data.margins = data.margins;
+    entry->data.edge_fill = data.edge_fill;
+    entry->data.center_fill = data.center_fill;
+    entry->data.texture = texture->texture;
+    ++entry->data.revision;
+
+    return true;
+}
+
+// Reload the texture at path, updating every frame that uses it
+bool frame_cache_reload_texture(frame_cache c, const char* path) {
+    check_return(c != NULL, "Frame cache is NULL", false);
+    check_return(path != NULL, "Texture path is NULL", false);
+
+    char* normalized = normalize_path(path);
+    frame_cache_texture* tex = find_texture(c, normalized);
+    sfree(normalized);
+    check_return(tex != NULL, "Texture %s isn't in the cache", false, path);
+
+    c->release_texture(&tex->texture, c->loader_data);
+    tex->texture = c->load_texture(tex->path, c->loader_data);
+
+    // UVs are scaled by the texture's size, so the frames' vertices have to be rebuilt as well
+    array_foreach(c->frames, it) {
+        frame_cache_frame* entry = array_iter_data(it, frame_cache_frame*);
+        if(entry->texture == tex) {
+            entry->data.texture = tex->texture;
+            ++entry->data.revision;
+        }
+    }
+
+    return true;
+}
+
+// Get a texture by its resolved path, loading it if needed. Each call must be matched with frame_cache_release_texture.
+gltex frame_cache_acquire_texture(frame_cache c, const char* path) {
+    check_return(c != NULL, "Frame cache is NULL", (gltex){ 0 });
+    check_return(path != NULL, "Texture path is NULL", (gltex){ 0 });
+
+    return acquire_texture(c, path)->texture;
+}
+
+// Release a texture returned by frame_cache_acquire_texture
+void frame_cache_release_texture(frame_cache c, const char* path) {
+    check_return(c != NULL, "Frame cache is NULL", );
+    check_return(path != NULL, "Texture path is NULL", );
+
+    char* normalized = normalize_path(path);
+    frame_cache_texture* tex = find_texture(c, normalized);
+    sfree(normalized);
+    check_return(tex != NULL, "Texture %s isn't in the cache", , path);
+
+    release_texture(c, tex);
+}
+
+// Get the number of distinct frames and textures currently loaded
+uint32 frame_cache_get_frame_count(frame_cache c) {
+    check_return(c != NULL, "Frame cache is NULL", 0);
+
+    return array_get_length(c->frames);
+}
+uint32 frame_cache_get_texture_count(frame_cache c) {
+    check_return(c != NULL, "Frame cache is NULL", 0);
+
+    return array_get_length(c->textures);
+}
@@ -0,0 +1,78 @@
+#ifndef DF_UI_FRAME_CACHE
+#define DF_UI_FRAME_CACHE
+
+#include "frame_data.h"
+
+#include "core/container/array.h"
+
+// Loads the texture at path. Used so that the cache can be driven without GL.
+typedef gltex (*frame_texture_load_func)(const char* path, void* user);
+// Releases a texture returned by a frame_texture_load_func
+typedef void (*frame_texture_release_func)(gltex* tex, void* user);
+
+// A texture shared by one or more cached frames
+typedef struct frame_cache_texture {
+    // The normalized path
+    char* path;
+    gltex texture;
+    uint32 refs;
+} frame_cache_texture;
+
+// A frame loaded through the cache
+typedef struct frame_cache_frame {
+    // The normalized path, which is also the data's asset path
+    char* path;
+    frame_data data;
+    frame_cache_texture* texture;
+    uint32 refs;
+} frame_cache_frame;
+
+// Deduplicates frame data and textures across loads. Each load must be matched with a release,
+// and data is freed once nothing references it.
+// Paths are normalized before they're compared, so "ui/a.xml" and "./ui/b/../a.xml" are the same frame.
+// Frames using cached data must not be freed with frame_free(f, true).
+typedef struct frame_cache {
+    array frames;
+    array textures;
+    // Incremented whenever a frame or texture is added or removed, so watchers know when to rescan
+    uint32 generation;
+
+    frame_texture_load_func load_texture;
+    frame_texture_release_func release_texture;
+    void* loader_data;
+}* frame_cache;
+
+// Create a new cache, which loads textures with load_texture_gl
+frame_cache frame_cache_new();
+
+// Frees the cache and everything in it, whether or not it's still referenced
+#define frame_cache_free(c) { _frame_cache_free(c); c = NULL; }
+void _frame_cache_free(frame_cache c);
+
+// Replace the functions used to load and release textures
+void frame_cache_set_texture_loader(frame_cache c, frame_texture_load_func load, frame_texture_release_func release, void* user);
+
+// Load the frame at path, or return the already-loaded copy. Returns NULL on failure.
+frame_data* frame_cache_load(frame_cache c, const char* path);
+
+// Release a frame returned by frame_cache_load
+void frame_cache_release(frame_cache c, frame_data* data);
+
+// Get a texture by its resolved path, loading it if needed. Each call must be matched with frame_cache_release_texture.
+gltex frame_cache_acquire_texture(frame_cache c, const char* path);
+
+// Release a texture returned by frame_cache_acquire_texture
+void frame_cache_release_texture(frame_cache c, const char* path);
+
+// Reload the frame file at path, replacing its data in place. Frames using it are rebuilt the next time they're drawn.
+// Returns false if the frame isn't in the cache, or the file couldn't be read. In that case, the old data is kept.
+bool frame_cache_reload(frame_cache c, const char* path);
+
+// Reload the texture at path, updating every frame that uses it. Returns false if the texture isn't in the cache.
+bool frame_cache_reload_texture(frame_cache c, const char* path);
+
+// Get the number of distinct frames and textures currently loaded
+uint32 frame_cache_get_frame_count(frame_cache c);
+uint32 frame_cache_get_texture_count(frame_cache c);
+
+#endif // DF_UI_FRAME_CACHE
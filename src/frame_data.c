@@ -6,42 +6,50 @@
 #include "core/check.h"
 
 void frame_data_new_default(frame_data* f, gltex tex, aabb_2d frame_box, uint16 margin) {
+    frame_margins margins = { .left = margin, .top = margin, .right = margin, .bottom = margin };
+    frame_data_new(f, tex, frame_box, margins, FRAME_FILL_STRETCH, FRAME_FILL_STRETCH);
+}
+
+void frame_data_new(frame_data* f, gltex tex, aabb_2d frame_box, frame_margins margins, frame_fill edge_fill, frame_fill center_fill) {
     check_return(f != NULL, "Frame data is NULL", );
 
     f->texture = tex;
-    f->margin = margin;
+    f->margins = margins;
+    f->edge_fill = edge_fill;
+    f->center_fill = center_fill;
     for(uint8 i = 0; i < 9; ++i) {
         f->uvs[i] = frame_box;
 
         switch(i % 3) { // Column UVs
             case 0: // Left column
-                f->uvs[i].dimensions.x = margin;
+                f->uvs[i].dimensions.x = margins.left;
             break;
             case 1: // Center column
-                f->uvs[i].position.x += margin;
-                f->uvs[i].dimensions.x -= margin * 2;
+                f->uvs[i].position.x += margins.left;
+                f->uvs[i].dimensions.x -= margins.left + margins.right;
             break;
             case 2: // Right column
-                f->uvs[i].position.x += f->uvs[i].dimensions.x - margin;
-                f->uvs[i].dimensions.x = margin;
+                f->uvs[i].position.x += f->uvs[i].dimensions.x - margins.right;
+                f->uvs[i].dimensions.x = margins.right;
             break;
         }
         switch(i / 3) { // Row UVs
             case 0: // Top row
-                f->uvs[i].dimensions.y = margin;
+                f->uvs[i].dimensions.y = margins.top;
             break;
             case 1: // Center row
-                f->uvs[i].position.y += margin;
-                f->uvs[i].dimensions.y -= margin * 2;
+                f->uvs[i].position.y += margins.top;
+                f->uvs[i].dimensions.y -= margins.top + margins.bottom;
             break;
             case 2: // Bottom column
-                f->uvs[i].position.y += f->uvs[i].dimensions.y - margin;
-                f->uvs[i].dimensions.y = margin;
+                f->uvs[i].position.y += f->uvs[i].dimensions.y - margins.bottom;
+                f->uvs[i].dimensions.y = margins.bottom;
             break;
         }
     }
 
     f->asset_path = NULL;
+    f->revision = 0;
 }
 void frame_data_cleanup(frame_data* f) {
     gltex_cleanup(&f->texture);
@@ -50,3 +58,24 @@ void frame_data_cleanup(frame_data* f) {
         sfree(f->asset_path);
     }
 }
+
+// Returns true if the frame data has a usable texture. Data that is still loading isn't ready.
+bool frame_data_is_ready(const frame_data* f) {
+    return f != NULL && f->texture.width != 0 && f->texture.height != 0;
+}
+
+// Returns true if any of the frame's slices are tiled
+bool frame_data_is_tiled(const frame_data* f) {
+    return f != NULL && (f->edge_fill == FRAME_FILL_TILE || f->center_fill == FRAME_FILL_TILE);
+}
+
+// Gets the box covering all 9 slices, in pixels
+aabb_2d frame_data_get_box(const frame_data* f) {
+    check_return(f != NULL, "Frame data is NULL", aabb_2d_zero);
+
+    aabb_2d box = aabb_2d_zero;
+    box.position = f->uvs[0].position;
+    box.dimensions = vec2_sub(vec2_add(f->uvs[8].position, f->uvs[8].dimensions), box.position);
+
+    return box;
+}
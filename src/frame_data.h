@@ -5,15 +5,52 @@
 #include "graphics/texture.h"
 #include "math/aabb.h"
 
+// How a frame's edges or center fill the space between its corners
+typedef enum frame_fill {
+    // The slice is stretched to cover the space
+    FRAME_FILL_STRETCH,
+    // The slice is repeated at its original size, and the last repeat is cut short
+    FRAME_FILL_TILE,
+} frame_fill;
+
+// The size of each of a frame's borders, in pixels
+typedef struct frame_margins {
+    uint16 left;
+    uint16 top;
+    uint16 right;
+    uint16 bottom;
+} frame_margins;
+
 typedef struct frame_data {
     gltex texture;
     aabb_2d uvs[9];
-    uint16 margin;
+    frame_margins margins;
+
+    frame_fill edge_fill;
+    frame_fill center_fill;
 
     char* asset_path;
+
+    // Incremented whenever the data is replaced in place, such as when it's reloaded,
+    // so that frames using it know to rebuild
+    uint32 revision;
 } frame_data;
 
+// Fills f with slices cut from frame_box, using the same margin on every side and stretched edges and center
 void frame_data_new_default(frame_data* f, gltex tex, aabb_2d frame_box, uint16 margin);
+
+// Fills f with slices cut from frame_box, using a separate margin for each side
+void frame_data_new(frame_data* f, gltex tex, aabb_2d frame_box, frame_margins margins, frame_fill edge_fill, frame_fill center_fill);
+
 void frame_data_cleanup(frame_data* f);
 
+// Returns true if the frame data has a usable texture. Data that is still loading isn't ready.
+bool frame_data_is_ready(const frame_data* f);
+
+// Returns true if any of the frame's slices are tiled
+bool frame_data_is_tiled(const frame_data* f);
+
+// Gets the box covering all 9 slices, in pixels
+aabb_2d frame_data_get_box(const frame_data* f);
+
 #endif // DF_UI_FRAME_DATA
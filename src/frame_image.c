@@ -0,0 +1,101 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_image.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
+#include "graphics/shader.h"
+
+#include <png.h>
+#include <string.h>
+
+// Creates a blank (transparent) image
+void frame_image_init(frame_image* image, uint16 width, uint16 height) {
+    check_return(image != NULL, "Image is NULL", );
+
+    image->width = width;
+    image->height = height;
+    image->pixels = scalloc((size_t)width * height * 4, 1);
+}
+
+// Decodes the png image at path. Returns true on success. This doesn't touch GL.
+bool frame_image_load(const char* path, frame_image* image) {
+    check_return(path != NULL, "Image path is NULL", false);
+    check_return(image != NULL, "Image is NULL", false);
+
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if(!png_image_begin_read_from_file(&png, path)) {
+        error("Failed to read image %s: %s", path, png.message);
+        return false;
+    }
+
+    png.format = PNG_FORMAT_RGBA;
+    image->pixels = salloc(PNG_IMAGE_SIZE(png));
+    if(!png_image_finish_read(&png, NULL, image->pixels, 0, NULL)) {
+        error("Failed to decode image %s: %s", path, png.message);
+        sfree(image->pixels);
+        png_image_free(&png);
+        return false;
+    }
+
+    image->width = png.width;
+    image->height = png.height;
+
+    return true;
+}
+
+// Encodes image as a png at path. Returns true on success.
+bool frame_image_save(const char* path, const frame_image* image) {
+    check_return(path != NULL, "Image path is NULL", false);
+    check_return(image != NULL && image->pixels != NULL, "Image is empty", false);
+
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = image->width;
+    png.height = image->height;
+    png.format = PNG_FORMAT_RGBA;
+
+    if(!png_image_write_to_file(&png, path, 0, image->pixels, 0, NULL)) {
+        error("Failed to write image %s: %s", path, png.message);
+        return false;
+    }
+
+    return true;
+}
+
+// Creates a GL texture from an image. path is stored as the texture's asset path, and may be NULL.
+gltex frame_image_upload(const frame_image* image, const char* path) {
+    gltex tex;
+    memset(&tex, 0, sizeof(tex));
+    check_return(image != NULL && image->pixels != NULL, "Image is empty", tex);
+
+    glGenTextures(1, &tex.handle);
+    glBindTexture(GL_TEXTURE_2D, tex.handle);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    tex.width = image->width;
+    tex.height = image->height;
+    tex.asset_path = path != NULL ? nstrdup(path) : NULL;
+
+    return tex;
+}
+
+// Frees an image's pixels
+void frame_image_cleanup(frame_image* image) {
+    check_return(image != NULL, "Image is NULL", );
+
+    sfree(image->pixels);
+    image->width = 0;
+    image->height = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef DF_UI_FRAME_IMAGE
+#define DF_UI_FRAME_IMAGE
+
+#include "core/types.h"
+#include "graphics/texture.h"
+
+// Decoded image pixels, in 8-bit RGBA
+typedef struct frame_image {
+    uint8* pixels;
+    uint16 width;
+    uint16 height;
+} frame_image;
+
+// Creates a blank (transparent) image
+void frame_image_init(frame_image* image, uint16 width, uint16 height);
+
+// Decodes the png image at path. Returns true on success. This doesn't touch GL.
+bool frame_image_load(const char* path, frame_image* image);
+
+// Encodes image as a png at path. Returns true on success.
+bool frame_image_save(const char* path, const frame_image* image);
+
+// Creates a GL texture from an image. path is stored as the texture's asset path, and may be NULL.
+gltex frame_image_upload(const frame_image* image, const char* path);
+
+// Frees an image's pixels
+void frame_image_cleanup(frame_image* image);
+
+#endif // DF_UI_FRAME_IMAGE
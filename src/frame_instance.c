@@ -0,0 +1,335 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_instance.h"
+#include "ui_stats.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "graphics/shader.h"
+
+#include <stddef.h>
+
+const char* frame_instance_vertex_source =
+    "#version 330 core\n"
+    "uniform mat4 u_transform;\n"
+    "uniform sampler2D u_texture;\n"
+    "in vec2 i_corner;\n"
+    "in vec4 i_axes;\n"
+    "in vec2 i_origin;\n"
+    "in vec2 i_dims;\n"
+    "in vec4 i_uv_box;\n"
+    "in vec4 i_margins;\n"
+    "out vec2 v_uv;\n"
+    "void main() {\n"
+    "    vec4 pos_x = vec4(-i_margins.x, 0.0, i_dims.x, i_dims.x + i_margins.z);\n"
+    "    vec4 pos_y = vec4(-i_margins.y, 0.0, i_dims.y, i_dims.y + i_margins.w);\n"
+    "    vec4 uv_x = i_uv_box.x + vec4(0.0, i_margins.x, i_uv_box.z - i_margins.z, i_uv_box.z);\n"
+    "    vec4 uv_y = i_uv_box.y + vec4(0.0, i_margins.y, i_uv_box.w - i_margins.w, i_uv_box.w);\n"
+    "    int column = int(i_corner.x);\n"
+    "    int row = int(i_corner.y);\n"
+    "    vec2 world = i_origin + i_axes.xy * pos_x[column] + i_axes.zw * pos_y[row];\n"
+    "    gl_Position = u_transform * vec4(world, 0.0, 1.0);\n"
+    "    v_uv = vec2(uv_x[column], uv_y[row]) / vec2(textureSize(u_texture, 0));\n"
+    "}\n";
+
+const char* frame_instance_fragment_source =
+    "#version 330 core\n"
+    "uniform sampler2D u_texture;\n"
+    "in vec2 v_uv;\n"
+    "out vec4 o_color;\n"
+    "void main() {\n"
+    "    o_color = texture(u_texture, v_uv);\n"
+    "}\n";
+
+// The number of indices in the shared grid mesh: 9 slices of 2 triangles each
+#define GRID_INDEX_COUNT 54
+
+// Fills instance with the record for a frame with the given data, dimensions and alignment, transformed by m
+bool frame_instance_build(const frame_data* data, vec2 dims, alignment_2d align, mat4 m, frame_instance* instance) {
+    check_return(instance != NULL, "Instance is NULL", false);
+
+    if(!frame_data_is_ready(data) || frame_data_is_tiled(data)) {
+        return false;
+    }
+
+    aabb_2d frame_box = {
+        .position = vec2_zero,
+        .dimensions = dims
+    };
+    vec2 offset = aabb_get_origin_2d(frame_box, align);
+    aabb_2d uv_box = frame_data_get_box(data);
+
+    // m is column-major, so its first two columns are the x and y axes, and its last is the translation
+    *instance = (frame_instance) {
+        .axes = { m.data[0], m.data[1], m.data[4], m.data[5] },
+        .origin = {
+            m.data[12] - m.data[0] * offset.x - m.data[4] * offset.y,
+            m.data[13] - m.data[1] * offset.x - m.data[5] * offset.y
+        },
+        .dims = { dims.x, dims.y },
+        .uv_box = { uv_box.position.x, uv_box.position.y, uv_box.dimensions.x, uv_box.dimensions.y },
+        .margins = data->margins
+    };
+
+    return true;
+}
+
+// Create a new, empty instance batch
+frame_instance_batch frame_instance_batch_new() {
+    frame_instance_batch b = mscalloc(1, struct frame_instance_batch);
+    b->groups = NULL;
+    b->group_count = 0;
+    b->group_capacity = 0;
+
+    // GL objects are created on the first flush
+    b->vao = 0;
+    b->grid_vbo = 0;
+    b->grid_ibo = 0;
+    b->instance_vbo = 0;
+    b->instance_capacity = 0;
+
+    return b;
+}
+
+// Frees the batch
+void _frame_instance_batch_free(frame_instance_batch b) {
+    check_return(b != NULL, "Batch is NULL", );
+
+    for(uint16 i = 0; i < b->group_capacity; ++i) {
+        sfree(b->groups[i].instances);
+    }
+    sfree(b->groups);
+
+    if(b->vao != 0) {
+        glDeleteBuffers(1, &b->instance_vbo);
+        glDeleteBuffers(1, &b->grid_ibo);
+        glDeleteBuffers(1, &b->grid_vbo);
+        glDeleteVertexArrays(1, &b->vao);
+    }
+
+    sfree(b);
+}
+
+// Finds the group for tex, creating it if it doesn't exist
+static frame_instance_group* get_group(frame_instance_batch b, gltex tex) {
+    for(uint16 i = 0; i < b->group_count; ++i) {
+        if(b->groups[i].texture.handle == tex.handle) {
+            return &b->groups[i];
+        }
+    }
+
+    if(b->group_count == b->group_capacity) {
+        uint16 capacity = b->group_capacity == 0 ? 4 : b->group_capacity * 2;
+        b->groups = srealloc(b->groups, capacity * sizeof(frame_instance_group));
+        for(uint16 i = b->group_capacity; i < capacity; ++i) {
+            b->groups[i] = (frame_instance_group) {
+                .instances = NULL,
+                .instance_count = 0,
+                .instance_capacity = 0
+            };
+        }
+        b->group_capacity = capacity;
+    }
+
+    // Groups past group_count keep their instance storage from previous frames
+    frame_instance_group* group = &b->groups[b->group_count++];
+    group->texture = tex;
+    group->instance_count = 0;
+
+    return group;
+}
+
+// Adds a frame to the batch, transformed by m. Returns false if the frame can't be instanced.
+bool frame_instance_batch_add(frame_instance_batch b, frame f, mat4 m) {
+    check_return(b != NULL, "Batch is NULL", false);
+    check_return(f != NULL, "Frame is NULL", false);
+
+    frame_instance instance;
+    if(!frame_instance_build(f->data, f->dims, f->align, m, &instance)) {
+        return false;
+    }
+
+    frame_instance_group* group = get_group(b, f->data->texture);
+    if(group->instance_count == group->instance_capacity) {
+        group->instance_capacity = group->instance_capacity == 0 ? 64 : group->instance_capacity * 2;
+        group->instances = srealloc(group->instances, group->instance_capacity * sizeof(frame_instance));
+    }
+
+    group->instances[group->instance_count++] = instance;
+
+    return true;
+}
+
+// Removes all frames from the batch, keeping allocated storage for reuse
+void frame_instance_batch_clear(frame_instance_batch b) {
+    check_return(b != NULL, "Batch is NULL", );
+
+    b->group_count = 0;
+}
+
+// Gets the number of texture groups in the batch
+uint16 frame_instance_batch_get_group_count(frame_instance_batch b) {
+    check_return(b != NULL, "Batch is NULL", 0);
+
+    return b->group_count;
+}
+
+// Gets a texture group in the batch
+const frame_instance_group* frame_instance_batch_get_group(frame_instance_batch b, uint16 index) {
+    check_return(b != NULL, "Batch is NULL", NULL);
+    check_return(index < b->group_count, "Group index %u is out of range", NULL, index);
+
+    return &b->groups[index];
+}
+
+// Gets the total number of instances in the batch
+uint32 frame_instance_batch_get_instance_count(frame_instance_batch b) {
+    check_return(b != NULL, "Batch is NULL", 0);
+
+    uint32 count = 0;
+    for(uint16 i = 0; i < b->group_count; ++i) {
+        count += b->groups[i].instance_count;
+    }
+
+    return count;
+}
+
+// Gets the number of bytes frame_instance_batch_flush will upload
+size_t frame_instance_batch_get_upload_size(frame_instance_batch b) {
+    return frame_instance_batch_get_instance_count(b) * sizeof(frame_instance);
+}
+
+// Creates the shared grid mesh. Vertex (column, row) sits on the column'th vertical and row'th horizontal slice line.
+static void create_grid(frame_instance_batch b) {
+    float corners[32];
+    for(uint8 row = 0; row < 4; ++row) {
+        for(uint8 column = 0; column < 4; ++column) {
+            corners[(row * 4 + column) * 2] = column;
+            corners[(row * 4 + column) * 2 + 1] = row;
+        }
+    }
+
+    // Same winding as build_box
+    GLubyte indices[GRID_INDEX_COUNT];
+    for(uint8 i = 0; i < 9; ++i) {
+        GLubyte top_left = (i / 3) * 4 + i % 3;
+        GLubyte* quad = indices + i * 6;
+        quad[0] = top_left;
+        quad[1] = top_left + 1;
+        quad[2] = top_left + 5;
+        quad[3] = top_left;
+        quad[4] = top_left + 5;
+        quad[5] = top_left + 4;
+    }
+
+    glGenVertexArrays(1, &b->vao);
+    glGenBuffers(1, &b->grid_vbo);
+    glGenBuffers(1, &b->grid_ibo);
+    glGenBuffers(1, &b->instance_vbo);
+
+    glBindVertexArray(b->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, b->grid_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b->grid_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Points an instance attribute at a field of frame_instance, starting at the record at base, if the shader uses it
+static void bind_instance_attrib(shader s, const char* name, GLint size, GLenum type, size_t offset, uint32 base) {
+    GLint loc = glGetAttribLocation(s.id, name);
+    if(loc == -1) {
+        return;
+    }
+
+    glEnableVertexAttribArray(loc);
+    glVertexAttribPointer(loc, size, type, GL_FALSE, sizeof(frame_instance), (void*)(base * sizeof(frame_instance) + offset));
+    glVertexAttribDivisor(loc, 1);
+}
+
+// Points every instance attribute at the records starting at base. Instanced draws always start from the
+// first instance without base-instance draws, so each group is drawn by moving the attributes to its records.
+static void bind_instance_attribs(shader s, uint32 base) {
+    bind_instance_attrib(s, "i_axes", 4, GL_FLOAT, offsetof(frame_instance, axes), base);
+    bind_instance_attrib(s, "i_origin", 2, GL_FLOAT, offsetof(frame_instance, origin), base);
+    bind_instance_attrib(s, "i_dims", 2, GL_FLOAT, offsetof(frame_instance, dims), base);
+    bind_instance_attrib(s, "i_uv_box", 4, GL_FLOAT, offsetof(frame_instance, uv_box), base);
+    bind_instance_attrib(s, "i_margins", 4, GL_UNSIGNED_SHORT, offsetof(frame_instance, margins), base);
+}
+
+// Draws each texture group with a single instanced draw call, then clears the batch
+void frame_instance_batch_flush(frame_instance_batch b, shader s, mat4 vp) {
+    check_return(b != NULL, "Batch is NULL", );
+
+    uint32 total = frame_instance_batch_get_instance_count(b);
+    if(total == 0) {
+        frame_instance_batch_clear(b);
+        return;
+    }
+
+    ui_stat_time_begin(UI_STAT_TIME_BATCH_FLUSH);
+
+    if(b->vao == 0) {
+        create_grid(b);
+    }
+
+    glUseProgram(s.id);
+    shader_bind_uniform_name(s, "u_transform", vp);
+
+    glBindVertexArray(b->vao);
+
+    GLint corner_loc = glGetAttribLocation(s.id, "i_corner");
+    if(corner_loc != -1) {
+        glBindBuffer(GL_ARRAY_BUFFER, b->grid_vbo);
+        glEnableVertexAttribArray(corner_loc);
+        glVertexAttribPointer(corner_loc, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    }
+
+    // Every group is uploaded back to back before anything is drawn, so no upload waits on a draw from the same buffer.
+    // The buffer is respecified each flush, letting the driver hand out fresh storage if the last frame's is still in use.
+    glBindBuffer(GL_ARRAY_BUFFER, b->instance_vbo);
+    if(total > b->instance_capacity) {
+        uint32 capacity = b->instance_capacity == 0 ? 64 : b->instance_capacity;
+        while(capacity < total) {
+            capacity *= 2;
+        }
+        b->instance_capacity = capacity;
+        ui_stat_add(UI_STAT_BUFFER_ALLOCATIONS, 1);
+    }
+    glBufferData(GL_ARRAY_BUFFER, b->instance_capacity * sizeof(frame_instance), NULL, GL_DYNAMIC_DRAW);
+
+    uint32 first = 0;
+    for(uint16 i = 0; i < b->group_count; ++i) {
+        frame_instance_group* group = &b->groups[i];
+        if(group->instance_count == 0) {
+            continue;
+        }
+
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(frame_instance), group->instance_count * sizeof(frame_instance), group->instances);
+        first += group->instance_count;
+    }
+    ui_stat_add(UI_STAT_UPLOAD_BYTES, total * sizeof(frame_instance));
+
+    first = 0;
+    for(uint16 i = 0; i < b->group_count; ++i) {
+        frame_instance_group* group = &b->groups[i];
+        if(group->instance_count == 0) {
+            continue;
+        }
+
+        bind_instance_attribs(s, first);
+        shader_bind_uniform_texture_name(s, "u_texture", group->texture, GL_TEXTURE0);
+        glDrawElementsInstanced(GL_TRIANGLES, GRID_INDEX_COUNT, GL_UNSIGNED_BYTE, (void*)0, group->instance_count);
+        ui_stat_add(UI_STAT_DRAW_CALLS, 1);
+        first += group->instance_count;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    ui_stat_time_end(UI_STAT_TIME_BATCH_FLUSH);
+
+    frame_instance_batch_clear(b);
+}
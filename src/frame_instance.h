@@ -0,0 +1,87 @@
+#ifndef DF_UI_FRAME_INSTANCE
+#define DF_UI_FRAME_INSTANCE
+
+#include "frame.h"
+
+#include "graphics/shader.hd"
+#include "math/matrix.hd"
+
+// A single frame in the instanced path. Instead of 54 vertices, each frame is described by this record,
+// and the shader expands a shared 4x4 grid mesh into the nine slices.
+typedef struct frame_instance {
+    // The 2D part of the frame's transform: its x and y axes, and its origin with alignment applied
+    float axes[4];
+    float origin[2];
+
+    // The size of the frame's center, in pixels
+    float dims[2];
+    // The box covering all 9 slices in the texture, in pixels
+    float uv_box[4];
+    frame_margins margins;
+} frame_instance;
+
+// A set of instances that share a texture
+typedef struct frame_instance_group {
+    gltex texture;
+
+    frame_instance* instances;
+    uint32 instance_count;
+    uint32 instance_capacity;
+} frame_instance_group;
+
+// Accumulates frames as instance records, grouped by texture, and draws each group with one instanced draw call.
+// Resizing a frame only changes its record, so nothing is regenerated on the CPU.
+// Tiled frames can't be expressed as a single record, and must be drawn with frame_batch or frame_draw instead.
+typedef struct frame_instance_batch {
+    frame_instance_group* groups;
+    uint16 group_count;
+    uint16 group_capacity;
+
+    // The shared grid mesh, and the stream of instance records
+    GLuint vao;
+    GLuint grid_vbo;
+    GLuint grid_ibo;
+    GLuint instance_vbo;
+    uint32 instance_capacity;
+}* frame_instance_batch;
+
+// Shader sources for drawing instance batches. Compile them with the application's shader loader.
+// The shader uses the u_transform and u_texture uniforms, like the other frame shaders.
+extern const char* frame_instance_vertex_source;
+extern const char* frame_instance_fragment_source;
+
+// Fills instance with the record for a frame with the given data, dimensions and alignment, transformed by m.
+// Only the 2D part of m is kept. Returns false if the data isn't ready or is tiled.
+// This doesn't touch GL.
+bool frame_instance_build(const frame_data* data, vec2 dims, alignment_2d align, mat4 m, frame_instance* instance);
+
+// Create a new, empty instance batch
+frame_instance_batch frame_instance_batch_new();
+
+// Frees the batch
+#define frame_instance_batch_free(b) { _frame_instance_batch_free(b); b = NULL; }
+void _frame_instance_batch_free(frame_instance_batch b);
+
+// Adds a frame to the batch, transformed by m. Returns false if the frame can't be instanced.
+// This doesn't touch GL, so batches can be built without a context.
+bool frame_instance_batch_add(frame_instance_batch b, frame f, mat4 m);
+
+// Removes all frames from the batch, keeping allocated storage for reuse
+void frame_instance_batch_clear(frame_instance_batch b);
+
+// Gets the number of texture groups in the batch
+uint16 frame_instance_batch_get_group_count(frame_instance_batch b);
+
+// Gets a texture group in the batch
+const frame_instance_group* frame_instance_batch_get_group(frame_instance_batch b, uint16 index);
+
+// Gets the total number of instances in the batch
+uint32 frame_instance_batch_get_instance_count(frame_instance_batch b);
+
+// Gets the number of bytes frame_instance_batch_flush will upload
+size_t frame_instance_batch_get_upload_size(frame_instance_batch b);
+
+// Draws each texture group with a single instanced draw call, then clears the batch
+void frame_instance_batch_flush(frame_instance_batch b, shader s, mat4 vp);
+
+#endif // DF_UI_FRAME_INSTANCE
@@ -8,6 +8,8 @@
 #include "resource/paths.h"
 #include "resource/texture_loader.h"
 
+#include <string.h>
+
 // Loads a frame from path
 void load_frame(const char* path, frame_data* f) {
     check_return(f != NULL, "Frame is NULL", );
@@ -31,6 +33,29 @@ void load_frame(const char* path, frame_data* f) {
     xmlFreeDoc(doc);
 }
 
+// Loads a frame's properties from path, without loading its texture. Returns true on success.
+// On success, texture_path is set to the resolved texture path, and must be freed.
+bool load_frame_properties(const char* path, frame_data* f, char** texture_path) {
+    xmlDocPtr doc = xmlReadFile(path, NULL, 0);
+    check_return(doc, "Failed to load frame at path %s", false, path);
+
+    bool success = false;
+    char* temp_path = NULL;
+    xmlNodePtr root = xml_match_name(xmlDocGetRootElement(doc), "frame");
+    if(root == NULL) {
+        error("Frame file %s is invalid", path);
+    } else if(xml_property_read(root, "path", &temp_path)) {
+        error("Frame file %s redirects to %s, this is not allowed", path, temp_path);
+        sfree(temp_path);
+    } else {
+        success = xml_read_frame_properties(root, path, f, texture_path);
+    }
+
+    xmlFreeDoc(doc);
+
+    return success;
+}
+
 // Saves a frame to path
 void save_frame(const char* path, const frame_data* f) {
     xmlTextWriter* writer = xmlNewTextWriterFilename(path, 0);
@@ -44,25 +69,68 @@ void save_frame(const char* path, const frame_data* f) {
     xmlFreeTextWriter(writer);
 }
 
-// Read a frame's data from xml. The frame can contain properties or a file reference.
-void xml_read_frame(xmlNodePtr node, frame_data* f, const char* path) {
+// Reads a fill mode property, leaving fill untouched if it's missing
+static void xml_read_fill(xmlNodePtr node, const char* name, frame_fill* fill) {
+    char* value = NULL;
+    if(!xml_property_read(node, name, &value)) {
+        return;
+    }
+
+    if(strcmp(value, "tile") == 0) {
+        *fill = FRAME_FILL_TILE;
+    } else if(strcmp(value, "stretch") == 0) {
+        *fill = FRAME_FILL_STRETCH;
+    } else {
+        error("Unknown frame fill mode %s, defaulting to stretch", value);
+    }
+
+    sfree(value);
+}
+
+// Read a frame's properties from xml into f, without loading its texture. f's texture is left empty.
+// On success, texture_path is set to the texture's path relative to the working directory, and must be freed.
+bool xml_read_frame_properties(xmlNodePtr node, const char* path, frame_data* f, char** texture_path) {
     uint16 margin = 0;
-    char* texture_path = NULL;
     aabb_2d box = aabb_2d_zero;
+    frame_fill edge_fill = FRAME_FILL_STRETCH;
+    frame_fill center_fill = FRAME_FILL_STRETCH;
+    *texture_path = NULL;
 
+    // Per-side margins override the shared one
     xml_property_read(node, "margin", &margin);
+    frame_margins margins = { .left = margin, .top = margin, .right = margin, .bottom = margin };
+    xml_property_read(node, "margin_left", &margins.left);
+    xml_property_read(node, "margin_top", &margins.top);
+    xml_property_read(node, "margin_right", &margins.right);
+    xml_property_read(node, "margin_bottom", &margins.bottom);
+
+    xml_read_fill(node, "edges", &edge_fill);
+    xml_read_fill(node, "center", &center_fill);
+
     xml_property_read(node, "position", &box.position);
     xml_property_read(node, "dimensions", &box.dimensions);
-    if(!xml_property_read(node, "texture", &texture_path)) {
+    if(!xml_property_read(node, "texture", texture_path)) {
         error("Can't load a frame without a texture");
+        return false;
+    }
+
+    *texture_path = combine_paths(get_folder(path), *texture_path, true);
+
+    frame_data_new(f, (gltex){ 0 }, box, margins, edge_fill, center_fill);
+
+    return true;
+}
+
+// Read a frame's data from xml. The frame can contain properties or a file reference.
+void xml_read_frame(xmlNodePtr node, frame_data* f, const char* path) {
+    char* texture_path = NULL;
+
+    if(!xml_read_frame_properties(node, path, f, &texture_path)) {
         return;
     }
 
-    texture_path = combine_paths(get_folder(path), texture_path, true);
-    gltex tex = load_texture_gl(texture_path);
+    f->texture = load_texture_gl(texture_path);
     sfree(texture_path);
-
-    frame_data_new_default(f, tex, box, margin);
 }
 
 // Write a frame's data to xml
@@ -74,15 +142,26 @@ void xml_write_frame(xmlTextWriterPtr writer, const frame_data* f, bool force_wr
     if(!force_write_properties && f->asset_path != NULL) {
         xml_property_write(writer, "path", f->asset_path);
     } else {
-        uint16 margin = 0;
-        aabb_2d box = aabb_2d_zero;
-
-        // TODO: Add support for varying boxes per-side
-        box.position = f->uvs[0].position;
-        box.dimensions = vec2_sub(vec2_add(f->uvs[8].position, f->uvs[8].dimensions), box.position);
-        margin = (uint16)f->uvs[0].dimensions.x;
+        aabb_2d box = frame_data_get_box(f);
+        frame_margins margins = f->margins;
+
+        if(margins.left == margins.top && margins.left == margins.right && margins.left == margins.bottom) {
+            xml_property_write(writer, "margin", margins.left);
+        } else {
+            xml_property_write(writer, "margin_left", margins.left);
+            xml_property_write(writer, "margin_top", margins.top);
+            xml_property_write(writer, "margin_right", margins.right);
+            xml_property_write(writer, "margin_bottom", margins.bottom);
+        }
+
+        // Stretching is the default, so it's left out to keep older files unchanged
+        if(f->edge_fill == FRAME_FILL_TILE) {
+            xml_property_write(writer, "edges", "tile");
+        }
+        if(f->center_fill == FRAME_FILL_TILE) {
+            xml_property_write(writer, "center", "tile");
+        }
 
-        xml_property_write(writer, "margin", margin);
         xml_property_write(writer, "position", box.position);
         xml_property_write(writer, "dimensions", box.dimensions);
         xml_property_write(writer, "texture", f->texture.asset_path);
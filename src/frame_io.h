@@ -7,9 +7,17 @@
 // Loads a frame from path
 void load_frame(const char* path, frame_data* f);
 
+// Loads a frame's properties from path into f, without loading its texture. Returns true on success.
+// On success, texture_path is set to the resolved texture path, and must be freed.
+bool load_frame_properties(const char* path, frame_data* f, char** texture_path);
+
 // Saves a frame to path
 void save_frame(const char* path, const frame_data* f);
 
+// Read a frame's properties from xml into f, without loading its texture. f's texture is left empty.
+// On success, texture_path is set to the texture's path relative to the working directory, and must be freed.
+bool xml_read_frame_properties(xmlNodePtr node, const char* path, frame_data* f, char** texture_path);
+
 // Read a frame's data from xml. The frame can contain properties or a file reference.
 void xml_read_frame(xmlNodePtr node, frame_data* f, const char* path);
 
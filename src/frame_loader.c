@@ -0,0 +1,274 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_loader.h"
+#include "frame_io.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
+
+#include <string.h>
+
+static bool default_decode(const char* path, frame_image* image, void* user) {
+    return frame_image_load(path, image);
+}
+static gltex default_upload(const char* path, const frame_image* image, void* user) {
+    return frame_image_upload(image, path);
+}
+
+// Frees a request, removing it from the loader's list of owned requests. The loader's lock must be held.
+static void free_request(frame_loader l, frame_load_handle h) {
+    if(h->prev_owned != NULL) {
+        h->prev_owned->next_owned = h->next_owned;
+    } else {
+        l->owned_head = h->next_owned;
+    }
+    if(h->next_owned != NULL) {
+        h->next_owned->prev_owned = h->prev_owned;
+    }
+
+    sfree(h->path);
+    sfree(h->texture_path);
+    sfree(h->image.pixels);
+    sfree(h);
+}
+
+// Appends h to the list with the given head and tail
+static void push_request(frame_load_handle* head, frame_load_handle* tail, frame_load_handle h) {
+    h->next = NULL;
+    if(*tail == NULL) {
+        *head = h;
+    } else {
+        (*tail)->next = h;
+    }
+    *tail = h;
+}
+
+// Removes the first request from the list with the given head and tail, or returns NULL if it's empty
+static frame_load_handle pop_request(frame_load_handle* head, frame_load_handle* tail) {
+    frame_load_handle h = *head;
+    if(h != NULL) {
+        *head = h->next;
+        if(*head == NULL) {
+            *tail = NULL;
+        }
+        h->next = NULL;
+    }
+
+    return h;
+}
+
+static void* frame_loader_worker(void* data) {
+    frame_loader l = data;
+
+    pthread_mutex_lock(&l->lock);
+    while(true) {
+        while(!l->is_stopping && l->queue_head == NULL) {
+            pthread_cond_wait(&l->wake, &l->lock);
+        }
+        if(l->is_stopping) {
+            break;
+        }
+
+        frame_load_handle h = pop_request(&l->queue_head, &l->queue_tail);
+        bool is_released = h->is_released;
+        ++l->active_count;
+        pthread_mutex_unlock(&l->lock);
+
+        bool success = false;
+        if(!is_released) {
+            success = load_frame_properties(h->path, &h->data, &h->texture_path)
+                   && l->decode(h->texture_path, &h->image, l->image_data);
+        }
+
+        pthread_mutex_lock(&l->lock);
+        --l->active_count;
+        if(h->is_released) {
+            free_request(l, h);
+        } else if(success) {
+            h->state = FRAME_LOAD_DECODED;
+            push_request(&l->decoded_head, &l->decoded_tail, h);
+        } else {
+            h->state = FRAME_LOAD_FAILED;
+        }
+    }
+    pthread_mutex_unlock(&l->lock);
+
+    return NULL;
+}
+
+// Create a new loader with thread_count worker threads. Images are decoded with libpng, and uploaded with GL.
+frame_loader frame_loader_new(uint16 thread_count) {
+    check_return(thread_count != 0, "Frame loader needs at least one thread", NULL);
+
+    // libxml2 must be initialized on one thread before it's used from several
+    xmlInitParser();
+
+    frame_loader l = mscalloc(1, struct frame_loader);
+    pthread_mutex_init(&l->lock, NULL);
+    pthread_cond_init(&l->wake, NULL);
+    l->decode = default_decode;
+    l->upload = default_upload;
+    l->image_data = NULL;
+
+    l->threads = scalloc(thread_count, sizeof(pthread_t));
+    for(uint16 i = 0; i < thread_count; ++i) {
+        if(pthread_create(&l->threads[i], NULL, frame_loader_worker, l) != 0) {
+            error("Failed to start frame loader thread %u", i);
+            break;
+        }
+        ++l->thread_count;
+    }
+
+    if(l->thread_count == 0) {
+        _frame_loader_free(l);
+        return NULL;
+    }
+
+    return l;
+}
+
+// Stops the workers and frees the loader. Any outstanding handles become invalid.
+void _frame_loader_free(frame_loader l) {
+    check_return(l != NULL, "Frame loader is NULL", );
+
+    pthread_mutex_lock(&l->lock);
+    l->is_stopping = true;
+    pthread_cond_broadcast(&l->wake);
+    pthread_mutex_unlock(&l->lock);
+
+    for(uint16 i = 0; i < l->thread_count; ++i) {
+        pthread_join(l->threads[i], NULL);
+    }
+
+    // This includes finished and failed loads whose handles were never released
+    while(l->owned_head != NULL) {
+        free_request(l, l->owned_head);
+    }
+
+    pthread_cond_destroy(&l->wake);
+    pthread_mutex_destroy(&l->lock);
+    sfree(l->threads);
+    sfree(l);
+}
+
+// Replace the functions used to decode and upload images. This must be done before any loads are started.
+void frame_loader_set_image_funcs(frame_loader l, frame_image_decode_func decode, frame_image_upload_func upload, void* user) {
+    check_return(l != NULL, "Frame loader is NULL", );
+    check_return(decode != NULL && upload != NULL, "Image functions can't be NULL", );
+
+    pthread_mutex_lock(&l->lock);
+    l->decode = decode;
+    l->upload = upload;
+    l->image_data = user;
+    pthread_mutex_unlock(&l->lock);
+}
+
+// Start loading the frame at path into f. f is cleared immediately, so frames using it are skipped until it's ready.
+frame_load_handle frame_loader_load(frame_loader l, const char* path, frame_data* f) {
+    check_return(l != NULL, "Frame loader is NULL", NULL);
+    check_return(path != NULL, "Frame path is NULL", NULL);
+    check_return(f != NULL, "Frame is NULL", NULL);
+
+    memset(f, 0, sizeof(frame_data));
+
+    frame_load_handle h = mscalloc(1, struct frame_load_request);
+    h->path = nstrdup(path);
+    h->target = f;
+    h->state = FRAME_LOAD_PENDING;
+
+    pthread_mutex_lock(&l->lock);
+    h->next_owned = l->owned_head;
+    if(l->owned_head != NULL) {
+        l->owned_head->prev_owned = h;
+    }
+    l->owned_head = h;
+    push_request(&l->queue_head, &l->queue_tail, h);
+    pthread_cond_signal(&l->wake);
+    pthread_mutex_unlock(&l->lock);
+
+    return h;
+}
+
+// Finish up to budget decoded loads by uploading their textures. Must be called on the thread that owns the GL context.
+// Returns the number of loads finished.
+uint16 frame_loader_update(frame_loader l, uint16 budget) {
+    check_return(l != NULL, "Frame loader is NULL", 0);
+
+    uint16 finished = 0;
+    while(finished < budget) {
+        pthread_mutex_lock(&l->lock);
+        frame_load_handle h = pop_request(&l->decoded_head, &l->decoded_tail);
+
+        // Cancelled loads don't count towards the budget, since they don't upload anything
+        if(h != NULL && h->is_released) {
+            free_request(l, h);
+            pthread_mutex_unlock(&l->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&l->lock);
+
+        if(h == NULL) {
+            break;
+        }
+
+        gltex tex = l->upload(h->texture_path, &h->image, l->image_data);
+        sfree(h->image.pixels);
+        h->image.pixels = NULL;
+
+        if(tex.handle != 0) {
+            *h->target = h->data;
+            h->target->texture = tex;
+            h->target->asset_path = nstrdup(h->path);
+        } else {
+            error("Failed to upload texture %s for frame %s", h->texture_path, h->path);
+        }
+
+        pthread_mutex_lock(&l->lock);
+        h->state = tex.handle != 0 ? FRAME_LOAD_READY : FRAME_LOAD_FAILED;
+        pthread_mutex_unlock(&l->lock);
+
+        ++finished;
+    }
+
+    return finished;
+}
+
+// Get the state of a load
+frame_load_state frame_loader_get_state(frame_loader l, frame_load_handle h) {
+    check_return(l != NULL, "Frame loader is NULL", FRAME_LOAD_FAILED);
+    check_return(h != NULL, "Load handle is NULL", FRAME_LOAD_FAILED);
+
+    pthread_mutex_lock(&l->lock);
+    frame_load_state state = h->state;
+    pthread_mutex_unlock(&l->lock);
+
+    return state;
+}
+
+// Returns true if no loads are waiting for a worker or being processed by one
+bool frame_loader_is_idle(frame_loader l) {
+    check_return(l != NULL, "Frame loader is NULL", true);
+
+    pthread_mutex_lock(&l->lock);
+    bool is_idle = l->queue_head == NULL && l->active_count == 0;
+    pthread_mutex_unlock(&l->lock);
+
+    return is_idle;
+}
+
+// Release a load handle. If the load hasn't finished, it's cancelled and its target is left untouched.
+void frame_loader_release(frame_loader l, frame_load_handle h) {
+    check_return(l != NULL, "Frame loader is NULL", );
+    check_return(h != NULL, "Load handle is NULL", );
+
+    pthread_mutex_lock(&l->lock);
+    if(h->state == FRAME_LOAD_PENDING || h->state == FRAME_LOAD_DECODED) {
+        // A worker or frame_loader_update still holds this, and will free it when it gets to it
+        h->is_released = true;
+    } else {
+        free_request(l, h);
+    }
+    pthread_mutex_unlock(&l->lock);
+}
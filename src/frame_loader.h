@@ -0,0 +1,97 @@
+#ifndef DF_UI_FRAME_LOADER
+#define DF_UI_FRAME_LOADER
+
+#include "frame_data.h"
+#include "frame_image.h"
+
+#include <pthread.h>
+
+// Decodes the image at path. Called on a worker thread. Returns true on success.
+// The pixels must be allocated with salloc, and are freed by the loader.
+typedef bool (*frame_image_decode_func)(const char* path, frame_image* image, void* user);
+// Creates a texture from a decoded image. Called on the main thread from frame_loader_update.
+typedef gltex (*frame_image_upload_func)(const char* path, const frame_image* image, void* user);
+
+typedef enum frame_load_state {
+    // Waiting for, or being processed by, a worker
+    FRAME_LOAD_PENDING,
+    // Parsed and decoded, waiting for its texture to be uploaded
+    FRAME_LOAD_DECODED,
+    // Finished, and the target frame data is usable
+    FRAME_LOAD_READY,
+    // Loading, decoding or uploading failed, and the target frame data was left cleared
+    FRAME_LOAD_FAILED,
+} frame_load_state;
+
+// A single asynchronous load. Owned by the loader until it's released.
+typedef struct frame_load_request {
+    char* path;
+    frame_data* target;
+    frame_load_state state;
+    bool is_released;
+
+    // Results from the worker. data is complete apart from its texture.
+    frame_data data;
+    char* texture_path;
+    frame_image image;
+
+    struct frame_load_request* next;
+    // Every request the loader still owns is kept in one list, so that it can free them all
+    struct frame_load_request* prev_owned;
+    struct frame_load_request* next_owned;
+}* frame_load_handle;
+
+// Loads frames on a pool of worker threads. File reading, xml parsing and image decoding happen on the workers,
+// while texture uploads are done on the main thread by frame_loader_update, a limited number per call.
+typedef struct frame_loader {
+    pthread_t* threads;
+    uint16 thread_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool is_stopping;
+
+    // Requests waiting for a worker
+    frame_load_handle queue_head;
+    frame_load_handle queue_tail;
+    // Requests waiting for their texture to be uploaded
+    frame_load_handle decoded_head;
+    frame_load_handle decoded_tail;
+    // Requests that a worker is currently processing
+    uint32 active_count;
+    // Every request that hasn't been freed, whatever its state
+    frame_load_handle owned_head;
+
+    frame_image_decode_func decode;
+    frame_image_upload_func upload;
+    void* image_data;
+}* frame_loader;
+
+// Create a new loader with thread_count worker threads. Images are decoded with libpng, and uploaded with GL.
+frame_loader frame_loader_new(uint16 thread_count);
+
+// Stops the workers and frees the loader. Any outstanding handles become invalid.
+#define frame_loader_free(l) { _frame_loader_free(l); l = NULL; }
+void _frame_loader_free(frame_loader l);
+
+// Replace the functions used to decode and upload images. This must be done before any loads are started.
+void frame_loader_set_image_funcs(frame_loader l, frame_image_decode_func decode, frame_image_upload_func upload, void* user);
+
+// Start loading the frame at path into f. f is cleared immediately, so frames using it are skipped until it's ready.
+frame_load_handle frame_loader_load(frame_loader l, const char* path, frame_data* f);
+
+// Finish up to budget decoded loads by uploading their textures. Must be called on the thread that owns the GL context.
+// Returns the number of loads finished.
+uint16 frame_loader_update(frame_loader l, uint16 budget);
+
+// Get the state of a load
+frame_load_state frame_loader_get_state(frame_loader l, frame_load_handle h);
+
+// Returns true if no loads are waiting for a worker or being processed by one
+bool frame_loader_is_idle(frame_loader l);
+
+// Release a load handle. If the load hasn't finished, it's cancelled and its target is left untouched.
+// Like frame_loader_update, this must be called on the main thread.
+void frame_loader_release(frame_loader l, frame_load_handle h);
+
+#endif // DF_UI_FRAME_LOADER
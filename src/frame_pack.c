@@ -0,0 +1,301 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_pack.h"
+#include "frame_io.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
+#include "resource/texture_loader.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(aabb_2d) == sizeof(float) * 4, "Frame packs store aabb_2d directly, and expect it to be 4 floats");
+
+// A growable buffer of NUL-terminated strings
+typedef struct string_table {
+    char* data;
+    uint32 length;
+    uint32 capacity;
+} string_table;
+
+// Appends str to the table, returning its offset within the table
+static uint32 string_table_add(string_table* t, const char* str) {
+    uint32 len = strlen(str) + 1;
+    if(t->length + len > t->capacity) {
+        uint32 capacity = t->capacity == 0 ? 1024 : t->capacity;
+        while(capacity < t->length + len) {
+            capacity *= 2;
+        }
+        t->data = srealloc(t->data, capacity);
+        t->capacity = capacity;
+    }
+
+    uint32 offset = t->length;
+    memcpy(t->data + offset, str, len);
+    t->length += len;
+
+    return offset;
+}
+
+// Reads a frame file into a pack record, leaving the string offsets relative to the string table
+static bool read_frame_record(const char* path, frame_pack_record* record, string_table* strings) {
+    char* texture_path = NULL;
+    frame_data f;
+    if(!load_frame_properties(path, &f, &texture_path)) {
+        return false;
+    }
+
+    memcpy(record->uvs, f.uvs, sizeof(record->uvs));
+    record->margins = f.margins;
+    record->edge_fill = f.edge_fill;
+    record->center_fill = f.center_fill;
+    record->reserved = 0;
+    record->texture_path_offset = string_table_add(strings, texture_path);
+    record->asset_path_offset = string_table_add(strings, path);
+
+    sfree(texture_path);
+
+    return true;
+}
+
+// A frame's asset path, used to sort the path index
+typedef struct path_index_entry {
+    const char* path;
+    uint32 index;
+} path_index_entry;
+
+static int compare_path_index_entries(const void* a, const void* b) {
+    const path_index_entry* entry_a = a;
+    const path_index_entry* entry_b = b;
+
+    int order = strcmp(entry_a->path, entry_b->path);
+    if(order != 0) {
+        return order;
+    }
+
+    // Duplicate paths are kept in build order, so that finding one gets the first
+    return (entry_a->index > entry_b->index) - (entry_a->index < entry_b->index);
+}
+
+// Compiles the frame files in frame_paths into a frame pack at path. Returns true on success.
+// Texture paths are stored resolved, the same way load_frame resolves them.
+bool frame_pack_build(const char* path, const char* const* frame_paths, uint32 count) {
+    check_return(path != NULL, "Frame pack path is NULL", false);
+    check_return(frame_paths != NULL || count == 0, "Frame path list is NULL", false);
+
+    frame_pack_record* records = scalloc(count == 0 ? 1 : count, sizeof(frame_pack_record));
+    string_table strings = { .data = NULL, .length = 0, .capacity = 0 };
+
+    bool success = true;
+    for(uint32 i = 0; i < count && success; ++i) {
+        success = read_frame_record(frame_paths[i], &records[i], &strings);
+    }
+
+    uint32* path_index = scalloc(count == 0 ? 1 : count, sizeof(uint32));
+    if(success) {
+        path_index_entry* entries = scalloc(count == 0 ? 1 : count, sizeof(path_index_entry));
+        for(uint32 i = 0; i < count; ++i) {
+            entries[i] = (path_index_entry){ .path = frame_paths[i], .index = i };
+        }
+        qsort(entries, count, sizeof(path_index_entry), compare_path_index_entries);
+        for(uint32 i = 0; i < count; ++i) {
+            path_index[i] = entries[i].index;
+        }
+        sfree(entries);
+    }
+
+    if(success) {
+        uint32 index_offset = sizeof(frame_pack_header) + count * sizeof(frame_pack_record);
+        frame_pack_header header = {
+            .magic = { FRAME_PACK_MAGIC[0], FRAME_PACK_MAGIC[1], FRAME_PACK_MAGIC[2], FRAME_PACK_MAGIC[3] },
+            .version = FRAME_PACK_VERSION,
+            .frame_count = count,
+            .index_offset = index_offset,
+            .strings_offset = index_offset + count * sizeof(uint32)
+        };
+
+        // Make string offsets relative to the start of the file, so they can be used directly once mapped
+        for(uint32 i = 0; i < count; ++i) {
+            records[i].texture_path_offset += header.strings_offset;
+            records[i].asset_path_offset += header.strings_offset;
+        }
+
+        FILE* file = fopen(path, "wb");
+        if(file == NULL) {
+            error("Failed to open path %s for writing", path);
+            success = false;
+        } else {
+            success = fwrite(&header, sizeof(header), 1, file) == 1
+                   && (count == 0 || fwrite(records, sizeof(frame_pack_record), count, file) == count)
+                   && (count == 0 || fwrite(path_index, sizeof(uint32), count, file) == count)
+                   && (strings.length == 0 || fwrite(strings.data, 1, strings.length, file) == strings.length);
+            success = (fclose(file) == 0) && success;
+
+            if(!success) {
+                error("Failed to write frame pack %s", path);
+            }
+        }
+    }
+
+    sfree(records);
+    sfree(path_index);
+    sfree(strings.data);
+
+    return success;
+}
+
+// Checks that a string offset lies within the pack, and the string is terminated
+static bool validate_string(const uint8* data, size_t size, uint32 strings_offset, uint32 offset) {
+    return offset >= strings_offset && offset < size && memchr(data + offset, '\0', size - offset) != NULL;
+}
+
+// Opens a frame pack by memory-mapping it. Returns NULL if the file is missing or invalid.
+frame_pack frame_pack_open(const char* path) {
+    check_return(path != NULL, "Frame pack path is NULL", NULL);
+
+    int fd = open(path, O_RDONLY);
+    check_return(fd != -1, "Failed to open frame pack %s", NULL, path);
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(frame_pack_header)) {
+        close(fd);
+        error("Frame pack %s is invalid", path);
+        return NULL;
+    }
+
+    size_t size = st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    check_return(data != MAP_FAILED, "Failed to map frame pack %s", NULL, path);
+
+    const frame_pack_header* header = data;
+    bool valid = memcmp(header->magic, FRAME_PACK_MAGIC, 4) == 0
+              && header->version == FRAME_PACK_VERSION
+              && header->index_offset == sizeof(frame_pack_header) + (size_t)header->frame_count * sizeof(frame_pack_record)
+              && header->strings_offset == header->index_offset + (size_t)header->frame_count * sizeof(uint32)
+              && header->strings_offset <= size;
+
+    const frame_pack_record* records = (const frame_pack_record*)((const uint8*)data + sizeof(frame_pack_header));
+    const uint32* path_index = (const uint32*)((const uint8*)data + header->index_offset);
+    for(uint32 i = 0; valid && i < header->frame_count; ++i) {
+        valid = validate_string(data, size, header->strings_offset, records[i].texture_path_offset)
+             && validate_string(data, size, header->strings_offset, records[i].asset_path_offset)
+             && path_index[i] < header->frame_count;
+    }
+
+    if(!valid) {
+        munmap(data, size);
+        error("Frame pack %s is invalid", path);
+        return NULL;
+    }
+
+    frame_pack p = mscalloc(1, struct frame_pack);
+    p->data = data;
+    p->size = size;
+    p->header = header;
+    p->records = records;
+    p->path_index = path_index;
+
+    return p;
+}
+
+// Closes a frame pack. Pointers into the pack become invalid.
+void _frame_pack_close(frame_pack p) {
+    check_return(p != NULL, "Frame pack is NULL", );
+
+    munmap((void*)p->data, p->size);
+    sfree(p);
+}
+
+// Gets the number of frames in the pack
+uint32 frame_pack_get_count(frame_pack p) {
+    check_return(p != NULL, "Frame pack is NULL", 0);
+
+    return p->header->frame_count;
+}
+
+// Gets the asset path of the frame at position i in the path index
+static const char* get_indexed_path(frame_pack p, uint32 i) {
+    return (const char*)p->data + p->records[p->path_index[i]].asset_path_offset;
+}
+
+// Finds a frame by the path of the file it was built from, with a binary search of the pack's path index.
+// Returns CONTAINER_INDEX_INVALID if it isn't in the pack.
+uint32 frame_pack_find(frame_pack p, const char* asset_path) {
+    check_return(p != NULL, "Frame pack is NULL", CONTAINER_INDEX_INVALID);
+    check_return(asset_path != NULL, "Asset path is NULL", CONTAINER_INDEX_INVALID);
+
+    // Find the first path that isn't less than asset_path, so duplicates give the first frame built
+    uint32 low = 0;
+    uint32 high = p->header->frame_count;
+    while(low < high) {
+        uint32 mid = low + (high - low) / 2;
+        if(strcmp(get_indexed_path(p, mid), asset_path) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if(low < p->header->frame_count && strcmp(get_indexed_path(p, low), asset_path) == 0) {
+        return p->path_index[low];
+    }
+
+    return CONTAINER_INDEX_INVALID;
+}
+
+// Gets the 9 UV boxes of a frame. This points directly into the mapped file.
+const aabb_2d* frame_pack_get_uvs(frame_pack p, uint32 index) {
+    check_return(p != NULL, "Frame pack is NULL", NULL);
+    check_return(index < p->header->frame_count, "Frame index %u is out of range", NULL, index);
+
+    return p->records[index].uvs;
+}
+
+// Gets the margins of a frame
+frame_margins frame_pack_get_margins(frame_pack p, uint32 index) {
+    check_return(p != NULL, "Frame pack is NULL", (frame_margins){ 0 });
+    check_return(index < p->header->frame_count, "Frame index %u is out of range", (frame_margins){ 0 }, index);
+
+    return p->records[index].margins;
+}
+
+// Gets the resolved texture path of a frame. This points directly into the mapped file.
+const char* frame_pack_get_texture_path(frame_pack p, uint32 index) {
+    check_return(p != NULL, "Frame pack is NULL", NULL);
+    check_return(index < p->header->frame_count, "Frame index %u is out of range", NULL, index);
+
+    return (const char*)p->data + p->records[index].texture_path_offset;
+}
+
+// Gets the path of the file a frame was built from. This points directly into the mapped file.
+const char* frame_pack_get_asset_path(frame_pack p, uint32 index) {
+    check_return(p != NULL, "Frame pack is NULL", NULL);
+    check_return(index < p->header->frame_count, "Frame index %u is out of range", NULL, index);
+
+    return (const char*)p->data + p->records[index].asset_path_offset;
+}
+
+// Loads a frame from the pack, including its texture
+void frame_pack_load_frame(frame_pack p, uint32 index, frame_data* f) {
+    check_return(p != NULL, "Frame pack is NULL", );
+    check_return(f != NULL, "Frame is NULL", );
+    check_return(index < p->header->frame_count, "Frame index %u is out of range", , index);
+
+    const frame_pack_record* record = &p->records[index];
+
+    f->texture = load_texture_gl(frame_pack_get_texture_path(p, index));
+    memcpy(f->uvs, record->uvs, sizeof(f->uvs));
+    f->margins = record->margins;
+    f->edge_fill = record->edge_fill;
+    f->center_fill = record->center_fill;
+    f->asset_path = nstrdup(frame_pack_get_asset_path(p, index));
+}
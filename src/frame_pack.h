@@ -0,0 +1,80 @@
+#ifndef DF_UI_FRAME_PACK
+#define DF_UI_FRAME_PACK
+
+#include "frame_data.h"
+
+#include <stddef.h>
+
+// Frame packs are precompiled binary collections of frames, built from frame xml files.
+// They're memory-mapped when opened, and read in place without any parsing.
+//
+// Layout (native byte order):
+//   frame_pack_header
+//   frame_pack_record[frame_count]
+//   uint32[frame_count] record indices, sorted by asset path
+//   string table of NUL-terminated paths, referenced by offset from the start of the file
+
+#define FRAME_PACK_MAGIC "DFFP"
+#define FRAME_PACK_VERSION 3
+
+typedef struct frame_pack_header {
+    char magic[4];
+    uint32 version;
+    uint32 frame_count;
+    uint32 index_offset;
+    uint32 strings_offset;
+} frame_pack_header;
+
+typedef struct frame_pack_record {
+    aabb_2d uvs[9];
+    frame_margins margins;
+    uint8 edge_fill;
+    uint8 center_fill;
+    uint16 reserved;
+    uint32 texture_path_offset;
+    uint32 asset_path_offset;
+} frame_pack_record;
+
+typedef struct frame_pack {
+    const uint8* data;
+    size_t size;
+
+    const frame_pack_header* header;
+    const frame_pack_record* records;
+    const uint32* path_index;
+}* frame_pack;
+
+// Compiles the frame files in frame_paths into a frame pack at path. Returns true on success.
+// Texture paths are stored resolved, the same way load_frame resolves them.
+bool frame_pack_build(const char* path, const char* const* frame_paths, uint32 count);
+
+// Opens a frame pack by memory-mapping it. Returns NULL if the file is missing or invalid.
+frame_pack frame_pack_open(const char* path);
+
+// Closes a frame pack. Pointers into the pack become invalid.
+#define frame_pack_close(p) { _frame_pack_close(p); p = NULL; }
+void _frame_pack_close(frame_pack p);
+
+// Gets the number of frames in the pack
+uint32 frame_pack_get_count(frame_pack p);
+
+// Finds a frame by the path of the file it was built from, with a binary search of the pack's path index.
+// Returns CONTAINER_INDEX_INVALID if it isn't in the pack.
+uint32 frame_pack_find(frame_pack p, const char* asset_path);
+
+// Gets the 9 UV boxes of a frame. This points directly into the mapped file.
+const aabb_2d* frame_pack_get_uvs(frame_pack p, uint32 index);
+
+// Gets the margins of a frame
+frame_margins frame_pack_get_margins(frame_pack p, uint32 index);
+
+// Gets the resolved texture path of a frame. This points directly into the mapped file.
+const char* frame_pack_get_texture_path(frame_pack p, uint32 index);
+
+// Gets the path of the file a frame was built from. This points directly into the mapped file.
+const char* frame_pack_get_asset_path(frame_pack p, uint32 index);
+
+// Loads a frame from the pack, including its texture
+void frame_pack_load_frame(frame_pack p, uint32 index, frame_data* f);
+
+#endif // DF_UI_FRAME_PACK
@@ -0,0 +1,249 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_theme.h"
+#include "frame_io.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
+#include "resource/paths.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Finds the frame element in a skin
+static xmlNodePtr get_skin_frame(xmlNodePtr skin) {
+    for(xmlNodePtr child = skin->children; child != NULL; child = child->next) {
+        if(child->type == XML_ELEMENT_NODE && xmlStrEqual(child->name, (const xmlChar*)"frame")) {
+            return child;
+        }
+    }
+
+    return NULL;
+}
+
+// Reads a skin's frame. Frames may reference a separate frame file, relative to the theme, which is loaded in full.
+static bool read_skin_frame(xmlNodePtr node, const char* path, frame_data* f, char** texture_path) {
+    char* frame_path = NULL;
+    if(!xml_property_read(node, "path", &frame_path)) {
+        return xml_read_frame_properties(node, path, f, texture_path);
+    }
+
+    frame_path = combine_paths(get_folder(path), frame_path, true);
+    bool success = load_frame_properties(frame_path, f, texture_path);
+    sfree(frame_path);
+
+    return success;
+}
+
+// Reads one skin from the reader's current element, adding it to the theme
+static void read_skin(frame_theme t, xmlTextReaderPtr reader, const char* path) {
+    // Only this skin's subtree is built, and it's freed as the reader moves past it
+    xmlNodePtr skin = xmlTextReaderExpand(reader);
+    check_return(skin != NULL, "Failed to read a skin from theme %s", , path);
+    check_return(xmlStrEqual(skin->name, (const xmlChar*)"skin"), "Unexpected %s element in theme %s", , (const char*)skin->name, path);
+
+    char* name = NULL;
+    check_return(xml_property_read(skin, "name", &name), "Skin without a name in theme %s", , path);
+
+    xmlNodePtr node = get_skin_frame(skin);
+    frame_theme_skin entry = { .name = name, .order = t->skin_count };
+    if(node == NULL || !read_skin_frame(node, path, &entry.data, &entry.texture_path)) {
+        error("Failed to read skin %s from theme %s", name, path);
+        sfree(name);
+        return;
+    }
+
+    if(t->textures != NULL) {
+        entry.data.texture = frame_cache_acquire_texture(t->textures, entry.texture_path);
+    } else {
+        entry.data.texture.asset_path = entry.texture_path;
+    }
+
+    if(t->skin_count == t->skin_capacity) {
+        t->skin_capacity = max(t->skin_capacity * 2, 16u);
+        t->skins = srealloc(t->skins, t->skin_capacity * sizeof(frame_theme_skin));
+    }
+    t->skins[t->skin_count++] = entry;
+}
+
+// Orders skins by name, and skins with the same name by their place in the file
+static int compare_skins(const void* a, const void* b) {
+    const frame_theme_skin* first = a;
+    const frame_theme_skin* second = b;
+
+    int order = strcmp(first->name, second->name);
+    if(order != 0) {
+        return order;
+    }
+    return first->order < second->order ? -1 : first->order > second->order;
+}
+
+static void release_skin(frame_theme t, frame_theme_skin* skin) {
+    if(t->textures != NULL) {
+        frame_cache_release_texture(t->textures, skin->texture_path);
+    }
+    sfree(skin->texture_path);
+    sfree(skin->name);
+}
+
+// Loads the theme at path
+frame_theme frame_theme_load(const char* path, frame_cache textures) {
+    check_return(path != NULL, "Theme path is NULL", NULL);
+
+    xmlTextReaderPtr reader = xmlReaderForFile(path, NULL, 0);
+    check_return(reader != NULL, "Failed to open theme at path %s", NULL, path);
+
+    int result = xmlTextReaderRead(reader);
+    if(result != 1 || !xmlStrEqual(xmlTextReaderConstName(reader), (const xmlChar*)"theme")) {
+        error("Theme file %s is invalid", path);
+        xmlFreeTextReader(reader);
+        return NULL;
+    }
+
+    frame_theme t = mscalloc(1, struct frame_theme);
+    t->skins = NULL;
+    t->skin_count = 0;
+    t->skin_capacity = 0;
+    t->textures = textures;
+
+    // Move into the theme's children, then step from skin to skin without descending into them
+    result = xmlTextReaderRead(reader);
+    while(result == 1) {
+        if(xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT && xmlTextReaderDepth(reader) == 1) {
+            read_skin(t, reader, path);
+            result = xmlTextReaderNext(reader);
+        } else {
+            result = xmlTextReaderRead(reader);
+        }
+    }
+
+    xmlFreeTextReader(reader);
+    if(result != 0) {
+        error("Failed to parse theme %s", path);
+        frame_theme_free(t);
+        return NULL;
+    }
+
+    // Only the first skin with each name is kept
+    qsort(t->skins, t->skin_count, sizeof(frame_theme_skin), compare_skins);
+    uint32 kept = 0;
+    for(uint32 i = 0; i < t->skin_count; ++i) {
+        if(kept > 0 && strcmp(t->skins[kept - 1].name, t->skins[i].name) == 0) {
+            error("Theme %s has more than one skin named %s, so only the first is used", path, t->skins[i].name);
+            release_skin(t, &t->skins[i]);
+            continue;
+        }
+        t->skins[kept++] = t->skins[i];
+    }
+    t->skin_count = kept;
+
+    return t;
+}
+
+// Frees the theme, releasing its textures
+void _frame_theme_free(frame_theme t) {
+    check_return(t != NULL, "Theme is NULL", );
+
+    for(uint32 i = 0; i < t->skin_count; ++i) {
+        release_skin(t, &t->skins[i]);
+    }
+
+    sfree(t->skins);
+    sfree(t);
+}
+
+// Saves every skin in the theme to path
+bool frame_theme_save(frame_theme t, const char* path) {
+    check_return(t != NULL, "Theme is NULL", false);
+
+    xmlTextWriterPtr writer = frame_theme_write_begin(path);
+    if(writer == NULL) {
+        return false;
+    }
+
+    for(uint32 i = 0; i < t->skin_count; ++i) {
+        frame_theme_write_skin(writer, t->skins[i].name, &t->skins[i].data);
+    }
+    frame_theme_write_end(writer);
+
+    return true;
+}
+
+// Get the number of skins in the theme
+uint32 frame_theme_get_count(frame_theme t) {
+    check_return(t != NULL, "Theme is NULL", 0);
+
+    return t->skin_count;
+}
+
+// Get a skin's name or frame by index
+const char* frame_theme_get_name(frame_theme t, uint32 index) {
+    check_return(t != NULL, "Theme is NULL", NULL);
+    check_return(index < t->skin_count, "Skin index %u is out of range", NULL, index);
+
+    return t->skins[index].name;
+}
+frame_data* frame_theme_get(frame_theme t, uint32 index) {
+    check_return(t != NULL, "Theme is NULL", NULL);
+    check_return(index < t->skin_count, "Skin index %u is out of range", NULL, index);
+
+    return &t->skins[index].data;
+}
+
+// Find a skin's frame by name
+frame_data* frame_theme_find(frame_theme t, const char* name) {
+    check_return(t != NULL, "Theme is NULL", NULL);
+    check_return(name != NULL, "Skin name is NULL", NULL);
+
+    uint32 low = 0;
+    uint32 high = t->skin_count;
+    while(low < high) {
+        uint32 mid = low + (high - low) / 2;
+        int order = strcmp(t->skins[mid].name, name);
+        if(order == 0) {
+            return &t->skins[mid].data;
+        } else if(order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+// Start writing a theme to path
+xmlTextWriterPtr frame_theme_write_begin(const char* path) {
+    check_return(path != NULL, "Theme path is NULL", NULL);
+
+    xmlTextWriterPtr writer = xmlNewTextWriterFilename(path, 0);
+    check_return(writer, "Failed to open path %s for writing", NULL, path);
+
+    xmlTextWriterStartDocument(writer, NULL, "ISO-8859-1", NULL);
+    xmlTextWriterStartElement(writer, (xmlChar*)"theme");
+
+    return writer;
+}
+
+// Write a skin to a theme started with frame_theme_write_begin
+void frame_theme_write_skin(xmlTextWriterPtr writer, const char* name, const frame_data* f) {
+    check_return(writer != NULL, "Theme writer is NULL", );
+    check_return(name != NULL, "Skin name is NULL", );
+    check_return(f != NULL, "Frame is NULL", );
+
+    xmlTextWriterStartElement(writer, (xmlChar*)"skin");
+    xml_property_write(writer, "name", name);
+    xml_write_frame(writer, f, true);
+    xmlTextWriterEndElement(writer);
+}
+
+// Finish and close a theme started with frame_theme_write_begin
+void frame_theme_write_end(xmlTextWriterPtr writer) {
+    check_return(writer != NULL, "Theme writer is NULL", );
+
+    xmlTextWriterEndElement(writer);
+    xmlTextWriterEndDocument(writer);
+    xmlFreeTextWriter(writer);
+}
@@ -0,0 +1,69 @@
+#ifndef DF_UI_FRAME_THEME
+#define DF_UI_FRAME_THEME
+
+#include "frame_cache.h"
+#include "frame_data.h"
+#include "resource/xmlutil.h"
+
+// Themes hold many named frames in a single xml file:
+//   <theme>
+//     <skin name="button"><frame margin="4" position="0 0" dimensions="32 32" texture="ui.png"/></skin>
+//     ...
+//   </theme>
+// Each skin's frame is written by xml_write_frame, so it can also reference a separate frame file with path,
+// which is relative to the theme.
+// Themes are read with a streaming reader, so only one skin is parsed into a tree at a time, however large the file is.
+
+// A frame loaded from a theme
+typedef struct frame_theme_skin {
+    char* name;
+    frame_data data;
+    // The resolved path of the frame's texture
+    char* texture_path;
+    // The skin's place in the file. Of several skins with the same name, only the first is kept.
+    uint32 order;
+} frame_theme_skin;
+
+typedef struct frame_theme {
+    // Sorted by name
+    frame_theme_skin* skins;
+    uint32 skin_count;
+    uint32 skin_capacity;
+
+    // The cache textures were acquired from, or NULL if they weren't loaded
+    frame_cache textures;
+}* frame_theme;
+
+// Loads the theme at path. Returns NULL if the file is missing or invalid.
+// If textures is non-NULL, each skin's texture is acquired from it, and it must outlive the theme.
+// Otherwise textures are left empty, apart from their asset path.
+frame_theme frame_theme_load(const char* path, frame_cache textures);
+
+// Frees the theme, releasing its textures
+#define frame_theme_free(t) { _frame_theme_free(t); t = NULL; }
+void _frame_theme_free(frame_theme t);
+
+// Saves every skin in the theme to path
+bool frame_theme_save(frame_theme t, const char* path);
+
+// Get the number of skins in the theme
+uint32 frame_theme_get_count(frame_theme t);
+
+// Get a skin's name or frame by index. Skins are ordered by name.
+const char* frame_theme_get_name(frame_theme t, uint32 index);
+frame_data* frame_theme_get(frame_theme t, uint32 index);
+
+// Find a skin's frame by name. Returns NULL if there isn't one.
+frame_data* frame_theme_find(frame_theme t, const char* name);
+
+// Start writing a theme to path. Skins are streamed to the file as they're added, so nothing has to be
+// collected up front. Returns NULL if the file can't be opened.
+xmlTextWriterPtr frame_theme_write_begin(const char* path);
+
+// Write a skin to a theme started with frame_theme_write_begin
+void frame_theme_write_skin(xmlTextWriterPtr writer, const char* name, const frame_data* f);
+
+// Finish and close a theme started with frame_theme_write_begin
+void frame_theme_write_end(xmlTextWriterPtr writer);
+
+#endif // DF_UI_FRAME_THEME
@@ -0,0 +1,280 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "frame_watch.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#define FRAME_WATCH_INOTIFY
+#endif
+
+// Create a watcher for the files loaded through c
+frame_watcher frame_watcher_new(frame_cache c, bool poll_only) {
+    check_return(c != NULL, "Frame cache is NULL", NULL);
+
+    frame_watcher w = mscalloc(1, struct frame_watcher);
+    w->cache = c;
+    // Make sure the first update syncs with the cache
+    w->generation = c->generation - 1;
+    w->files = array_mnew_ordered(frame_watch_file*, 16);
+    w->folders = array_mnew_ordered(frame_watch_folder*, 4);
+    w->inotify_fd = -1;
+
+#ifdef FRAME_WATCH_INOTIFY
+    if(!poll_only) {
+        w->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(w->inotify_fd == -1) {
+            error("Failed to start inotify (%s), polling frame files instead", strerror(errno));
+        }
+    }
+#endif
+
+    return w;
+}
+
+// Frees the watcher
+void _frame_watcher_free(frame_watcher w) {
+    check_return(w != NULL, "Frame watcher is NULL", );
+
+    array_foreach(w->files, it) {
+        frame_watch_file* file = array_iter_data(it, frame_watch_file*);
+        sfree(file->path);
+        sfree(file);
+    }
+    array_foreach(w->folders, it) {
+        sfree(array_iter_data(it, frame_watch_folder*));
+    }
+
+    if(w->inotify_fd != -1) {
+        // Closing the descriptor removes all of its watches
+        close(w->inotify_fd);
+    }
+
+    array_free(w->files);
+    array_free(w->folders);
+    sfree(w);
+}
+
+// Returns true if the watcher polls files rather than using inotify
+bool frame_watcher_is_polling(frame_watcher w) {
+    check_return(w != NULL, "Frame watcher is NULL", true);
+
+    return w->inotify_fd == -1;
+}
+
+// Records the file's current state, returning true if it differs from the last one recorded
+static bool stat_file(frame_watch_file* file) {
+    struct stat st;
+    if(stat(file->path, &st) != 0) {
+        // Editors may briefly remove a file while saving it. Treat it as changed once it's back.
+        file->mtime = (struct timespec){ 0 };
+        file->size = -1;
+        return false;
+    }
+
+    bool changed = st.st_mtim.tv_sec != file->mtime.tv_sec || st.st_mtim.tv_nsec != file->mtime.tv_nsec || st.st_size != file->size;
+    file->mtime = st.st_mtim;
+    file->size = st.st_size;
+
+    return changed;
+}
+
+#ifdef FRAME_WATCH_INOTIFY
+// Watches the folder containing file. Folders are watched rather than files, since editors often save by
+// replacing the file, which would silently drop a watch on the file itself.
+static void watch_folder(frame_watcher w, frame_watch_file* file) {
+    char* folder = NULL;
+    if(file->name == file->path) {
+        folder = nstrdup(".");
+    } else {
+        size_t len = max((size_t)(file->name - file->path) - 1, (size_t)1);
+        folder = salloc(len + 1);
+        memcpy(folder, file->path, len);
+        folder[len] = '\0';
+    }
+
+    file->wd = inotify_add_watch(w->inotify_fd, folder, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if(file->wd == -1) {
+        error("Failed to watch %s for changes: %s", folder, strerror(errno));
+        sfree(folder);
+        return;
+    }
+    sfree(folder);
+
+    // inotify returns the same descriptor for a folder that's already watched
+    array_foreach(w->folders, it) {
+        frame_watch_folder* entry = array_iter_data(it, frame_watch_folder*);
+        if(entry->wd == file->wd) {
+            ++entry->refs;
+            return;
+        }
+    }
+
+    frame_watch_folder* entry = mscalloc(1, frame_watch_folder);
+    entry->wd = file->wd;
+    entry->refs = 1;
+    array_add(w->folders, entry);
+}
+
+static void unwatch_folder(frame_watcher w, int wd) {
+    array_foreach(w->folders, it) {
+        frame_watch_folder* entry = array_iter_data(it, frame_watch_folder*);
+        if(entry->wd != wd) {
+            continue;
+        }
+
+        if(--entry->refs == 0) {
+            inotify_rm_watch(w->inotify_fd, wd);
+            array_remove_iter(w->folders, &it);
+            sfree(entry);
+        }
+        return;
+    }
+}
+#endif
+
+// Marks the file at path as present, starting to watch it if it's new
+static void sync_file(frame_watcher w, const char* path, bool is_texture) {
+    array_foreach(w->files, it) {
+        frame_watch_file* file = array_iter_data(it, frame_watch_file*);
+        if(file->is_texture == is_texture && strcmp(file->path, path) == 0) {
+            file->is_present = true;
+            return;
+        }
+    }
+
+    frame_watch_file* file = mscalloc(1, frame_watch_file);
+    file->path = nstrdup(path);
+    const char* slash = strrchr(file->path, '/');
+    file->name = slash != NULL ? slash + 1 : file->path;
+    file->is_texture = is_texture;
+    file->wd = -1;
+    file->is_changed = false;
+    file->is_present = true;
+
+#ifdef FRAME_WATCH_INOTIFY
+    if(w->inotify_fd != -1) {
+        watch_folder(w, file);
+    }
+#endif
+    if(w->inotify_fd == -1) {
+        stat_file(file);
+    }
+
+    array_add(w->files, file);
+}
+
+// Brings the watched files in line with the cache's frames and textures
+static void sync_files(frame_watcher w) {
+    if(w->generation == w->cache->generation) {
+        return;
+    }
+    w->generation = w->cache->generation;
+
+    array_foreach(w->files, it) {
+        array_iter_data(it, frame_watch_file*)->is_present = false;
+    }
+    array_foreach(w->cache->frames, it) {
+        sync_file(w, array_iter_data(it, frame_cache_frame*)->path, false);
+    }
+    array_foreach(w->cache->textures, it) {
+        sync_file(w, array_iter_data(it, frame_cache_texture*)->path, true);
+    }
+
+    array_foreach(w->files, it) {
+        frame_watch_file* file = array_iter_data(it, frame_watch_file*);
+        if(file->is_present) {
+            continue;
+        }
+
+#ifdef FRAME_WATCH_INOTIFY
+        if(file->wd != -1) {
+            unwatch_folder(w, file->wd);
+        }
+#endif
+        array_remove_iter(w->files, &it);
+        sfree(file->path);
+        sfree(file);
+    }
+}
+
+#ifdef FRAME_WATCH_INOTIFY
+// Drains pending inotify events, marking the files they name as changed
+static void read_events(frame_watcher w) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while(true) {
+        ssize_t len = read(w->inotify_fd, buffer, sizeof(buffer));
+        if(len <= 0) {
+            if(len == -1 && errno != EAGAIN) {
+                error("Failed to read file change events: %s", strerror(errno));
+            }
+            return;
+        }
+
+        for(char* ptr = buffer; ptr < buffer + len; ) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            // Some events were dropped, so anything could have changed
+            bool overflowed = (event->mask & IN_Q_OVERFLOW) != 0;
+            if(!overflowed && event->len == 0) {
+                continue;
+            }
+
+            array_foreach(w->files, it) {
+                frame_watch_file* file = array_iter_data(it, frame_watch_file*);
+                if(overflowed || (file->wd == event->wd && strcmp(file->name, event->name) == 0)) {
+                    file->is_changed = true;
+                }
+            }
+        }
+    }
+}
+#endif
+
+// Reload every watched file that has changed since the last update
+uint32 frame_watcher_update(frame_watcher w) {
+    check_return(w != NULL, "Frame watcher is NULL", 0);
+
+    sync_files(w);
+
+#ifdef FRAME_WATCH_INOTIFY
+    if(w->inotify_fd != -1) {
+        read_events(w);
+    }
+#endif
+    if(w->inotify_fd == -1) {
+        array_foreach(w->files, it) {
+            frame_watch_file* file = array_iter_data(it, frame_watch_file*);
+            file->is_changed = stat_file(file);
+        }
+    }
+
+    // Textures go first, so a reloaded frame that switches to a changed texture doesn't get the stale one
+    uint32 reloaded = 0;
+    array_foreach(w->files, it) {
+        frame_watch_file* file = array_iter_data(it, frame_watch_file*);
+        if(file->is_changed && file->is_texture && frame_cache_reload_texture(w->cache, file->path)) {
+            ++reloaded;
+        }
+    }
+    array_foreach(w->files, it) {
+        frame_watch_file* file = array_iter_data(it, frame_watch_file*);
+        if(file->is_changed && !file->is_texture && frame_cache_reload(w->cache, file->path)) {
+            ++reloaded;
+        }
+        file->is_changed = false;
+    }
+
+    return reloaded;
+}
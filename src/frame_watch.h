@@ -0,0 +1,64 @@
+#ifndef DF_UI_FRAME_WATCH
+#define DF_UI_FRAME_WATCH
+
+#include "frame_cache.h"
+
+#include "core/container/array.h"
+
+#include <sys/types.h>
+#include <time.h>
+
+// A frame or texture file loaded through the watched cache
+typedef struct frame_watch_file {
+    char* path;
+    // Points into path, after its folder
+    const char* name;
+    bool is_texture;
+
+    // The inotify watch on the file's folder, or -1 when polling
+    int wd;
+    // The file's state when it was last checked, when polling
+    struct timespec mtime;
+    off_t size;
+
+    bool is_changed;
+    bool is_present;
+} frame_watch_file;
+
+// An inotify watch on a folder, shared by every watched file in it
+typedef struct frame_watch_folder {
+    int wd;
+    uint32 refs;
+} frame_watch_folder;
+
+// Watches the files loaded through a frame cache, and reloads them when they change on disk.
+// Only the changed frames are re-read, and only frames using them are rebuilt, the next time they're drawn.
+// On Linux, changes are picked up with inotify. Elsewhere, or if inotify isn't available, files are polled instead.
+typedef struct frame_watcher {
+    frame_cache cache;
+    // The cache's generation when the watched files were last synced with it
+    uint32 generation;
+    array files;
+    array folders;
+
+    // -1 when polling
+    int inotify_fd;
+}* frame_watcher;
+
+// Create a watcher for the files loaded through c. If poll_only is true, files are polled even if inotify is available.
+// The cache must outlive the watcher.
+frame_watcher frame_watcher_new(frame_cache c, bool poll_only);
+
+// Frees the watcher
+#define frame_watcher_free(w) { _frame_watcher_free(w); w = NULL; }
+void _frame_watcher_free(frame_watcher w);
+
+// Returns true if the watcher polls files rather than using inotify
+bool frame_watcher_is_polling(frame_watcher w);
+
+// Reload every watched file that has changed since the last update. This never blocks.
+// Must be called on the thread that owns the GL context, since textures may be reloaded.
+// Returns the number of files reloaded.
+uint32 frame_watcher_update(frame_watcher w);
+
+#endif // DF_UI_FRAME_WATCH
@@ -1,6 +1,10 @@
 #include "layout.h"
 #include "layout_element.h"
+#include "layout_index.h"
+#include "layout_pool.h"
+#include "ui_stats.h"
 
+#include "core/check.h"
 #include "core/log/log.h"
 
 // Initialize a new layout
@@ -11,38 +15,302 @@ void layout_init(layout* l, vec2 bounds, layout_type type) {
             .position = vec2_zero,
             .dimensions = bounds
         },
-        .align = ALIGN_DEFAULT
+        .align = ALIGN_DEFAULT,
+        .parent = NULL,
+        .sublayout = l
     };
     l->children = array_mnew_ordered(layout_element*, 4);
     l->type = type;
+
+    l->columns = 1;
+    l->spacing = vec2_zero;
+    l->wrap = false;
+
+    l->solved_bounds = l->bounds.calculated_bounds;
+    l->is_dirty = true;
+    l->has_dirty_child = false;
+    l->solve_count = 0;
+    l->was_solved = false;
+    l->was_visited = false;
+    l->damage = NULL;
+    l->index = NULL;
+}
+
+static void layout_release(void* data) {
+    layout_cleanup(data);
+}
+
+// Create a new layout in an arena. It's cleaned up along with the arena, and must not be passed to layout_cleanup.
+layout* layout_new_in(ui_arena a, vec2 bounds, layout_type type) {
+    check_return(a != NULL, "Arena is NULL", NULL);
+
+    layout* l = ui_arena_mnew(a, layout);
+    layout_init(l, bounds, type);
+    ui_arena_defer(a, layout_release, l);
+
+    return l;
+}
+
+// Adds an element to a layout's children. The bookkeeping fields are reset, so that elements
+// that were never initialized aren't mistaken for ones that are already indexed or reported.
+static void layout_attach(layout* l, layout_element* elem) {
+    array_add(l->children, elem);
+    elem->parent = l;
+    elem->damage_bounds = aabb_2d_zero;
+    elem->index = NULL;
+    elem->indexed_bounds = aabb_2d_zero;
+
+    layout_mark_dirty(l);
 }
 
 // Add a new element to a layout
 void layout_add_element(layout* l, layout_element* elem) {
-    array_add(l->children, elem);
+    check_return(l != NULL, "Layout is NULL", );
+    check_return(elem != NULL, "Layout element is NULL", );
+
+    elem->sublayout = NULL;
+    layout_attach(l, elem);
 }
 
-// Update a layout, recalculating the bounds of its children
-void layout_update(layout* l) {
+// Add a nested layout to a layout. The child is updated along with its parent.
+void layout_add_layout(layout* l, layout* child) {
+    check_return(l != NULL, "Layout is NULL", );
+    check_return(child != NULL, "Child layout is NULL", );
+
+    layout_attach(l, &child->bounds);
+
+    // The child may have been changed before it had a parent to notify
+    if(child->is_dirty || child->has_dirty_child) {
+        layout_mark_dirty(child);
+    }
+}
+
+// Set the number of columns in a grid layout
+void layout_set_columns(layout* l, uint16 columns) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    l->columns = columns;
+    layout_mark_dirty(l);
+}
+
+// Set the gap between cells or elements in grid and flex layouts
+void layout_set_spacing(layout* l, vec2 spacing) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    l->spacing = spacing;
+    layout_mark_dirty(l);
+}
+
+// Set whether a flex layout wraps elements onto new lines
+void layout_set_wrap(layout* l, bool wrap) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    l->wrap = wrap;
+    layout_mark_dirty(l);
+}
+
+// Set the damage tracker that elements report to when they move or resize
+void layout_set_damage(layout* l, ui_damage d) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    l->damage = d;
+}
+
+// Marks a layout and every layout nested in it as dirty
+static void layout_mark_tree_dirty(layout* l) {
+    layout_mark_dirty(l);
+    array_foreach(l->children, it) {
+        layout_element* elem = array_iter_data(it, layout_element*);
+        if(elem->sublayout != NULL) {
+            layout_mark_tree_dirty(elem->sublayout);
+        }
+    }
+}
+
+// Set the hit-test index that this layout's elements are kept in
+void layout_set_index(layout* l, layout_index idx) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    l->index = idx;
+
+    // Every element needs to be filed, including those of nested layouts that wouldn't otherwise be solved
+    layout_mark_tree_dirty(l);
+}
+
+// Mark a layout as needing its children re-solved, and notify its parents
+void layout_mark_dirty(layout* l) {
+    l->is_dirty = true;
+
+    for(layout* p = l->bounds.parent; p != NULL && !p->has_dirty_child; p = p->bounds.parent) {
+        p->has_dirty_child = true;
+    }
+}
+
+static bool bounds_equal(aabb_2d a, aabb_2d b) {
+    return a.position.x == b.position.x && a.position.y == b.position.y
+        && a.dimensions.x == b.dimensions.x && a.dimensions.y == b.dimensions.y;
+}
+
+static layout_element* get_child(layout* l, uint32 index) {
+    return *(layout_element**)array_get(l->children, index);
+}
+
+// Gets the component of v along the vertical or horizontal axis
+static float get_axis(vec2 v, bool vertical) {
+    return vertical ? v.y : v.x;
+}
+static void set_axis(vec2* v, bool vertical, float value) {
+    if(vertical) {
+        v->y = value;
+    } else {
+        v->x = value;
+    }
+}
+
+// Applies flex size limits to size. A max_size of 0 means there is no maximum.
+static float limit_size(float size, float min_size, float max_size) {
+    if(max_size > 0) {
+        size = min(size, max_size);
+    }
+    return max(size, min_size);
+}
+
+// Attach an element to an area based on its alignment, shrinking it to fit
+static void place_in_area(layout_element* elem, aabb_2d area) {
+    aabb_2d box = {
+        .position = vec2_zero,
+        .dimensions = vec2_add(elem->requested_dims, vec2_mul(elem->padding, 2))
+    };
+
+    box.dimensions.x = clamp(box.dimensions.x, 0, area.dimensions.x);
+    box.dimensions.y = clamp(box.dimensions.y, 0, area.dimensions.y);
+    aabb_2d bounds = aabb_align_box_2d(box, area, elem->align);
+
+    elem->calculated_bounds = (aabb_2d) {
+        .position=vec2_add(bounds.position, elem->padding),
+        .dimensions=vec2_sub(box.dimensions, vec2_mul(elem->padding, 2))
+    };
+}
+
+// Grid layout type: The layout is split into equally-sized cells, filled left-to-right then top-to-bottom.
+// Each child attaches to its cell based on its alignment.
+static void layout_solve_grid(layout* l) {
+    uint32 count = array_get_length(l->children);
+    if(count == 0) {
+        return;
+    }
+
+    uint16 columns = l->columns == 0 ? 1 : l->columns;
+    uint32 rows = (count + columns - 1) / columns;
+    aabb_2d area = l->bounds.calculated_bounds;
+    vec2 cell = {
+        .x = max((area.dimensions.x - l->spacing.x * (columns - 1)) / columns, 0),
+        .y = max((area.dimensions.y - l->spacing.y * (rows - 1)) / rows, 0)
+    };
+
+    for(uint32 i = 0; i < count; ++i) {
+        aabb_2d cell_box = {
+            .position = {
+                .x = area.position.x + (i % columns) * (cell.x + l->spacing.x),
+                .y = area.position.y + (i / columns) * (cell.y + l->spacing.y)
+            },
+            .dimensions = cell
+        };
+        place_in_area(get_child(l, i), cell_box);
+    }
+}
+
+// Flex layout types: Children are placed in lines along the main axis. Each line's free space is shared
+// between children by their grow weights, and overflow is taken from them by their shrink weights scaled
+// by their size. If wrapping is enabled, children that don't fit start a new line.
+// Each child is visited twice: once to measure its line, and once to place it.
+// Size limits are applied after distributing space, and leftover space isn't redistributed.
+static void layout_solve_flex(layout* l, bool vertical) {
+    aabb_2d area = l->bounds.calculated_bounds;
+    float main_start = get_axis(area.position, vertical);
+    float main_size = get_axis(area.dimensions, vertical);
+    float cross_end = get_axis(area.position, !vertical) + get_axis(area.dimensions, !vertical);
+    float main_spacing = get_axis(l->spacing, vertical);
+    float cross_spacing = get_axis(l->spacing, !vertical);
+
+    uint32 count = array_get_length(l->children);
+    float cross_counter = get_axis(area.position, !vertical);
+    uint32 line_start = 0;
+    while(line_start < count) {
+        // Measure: find where the line ends, and total up its sizes and weights
+        float used = 0;
+        float grow_total = 0;
+        float shrink_total = 0;
+        float line_cross = 0;
+        uint32 line_end = line_start;
+        for(; line_end < count; ++line_end) {
+            layout_element* elem = get_child(l, line_end);
+            float base = limit_size(get_axis(elem->requested_dims, vertical), get_axis(elem->min_dims, vertical), get_axis(elem->max_dims, vertical));
+            float size = base + get_axis(elem->padding, vertical) * 2;
+            if(line_end != line_start) {
+                size += main_spacing;
+                if(l->wrap && used + size > main_size) {
+                    break;
+                }
+            }
+
+            used += size;
+            grow_total += elem->grow;
+            shrink_total += elem->shrink * base;
+
+            float cross = limit_size(get_axis(elem->requested_dims, !vertical), get_axis(elem->min_dims, !vertical), get_axis(elem->max_dims, !vertical));
+            line_cross = max(line_cross, cross + get_axis(elem->padding, !vertical) * 2);
+        }
+
+        // Without wrapping, the single line fills the layout
+        if(!l->wrap) {
+            line_cross = cross_end - cross_counter;
+        }
+        line_cross = clamp(line_cross, 0, max(cross_end - cross_counter, 0));
+
+        // Place: share out the free space and position each child
+        float free_space = main_size - used;
+        float main_counter = main_start;
+        for(uint32 i = line_start; i < line_end; ++i) {
+            layout_element* elem = get_child(l, i);
+            float min_main = get_axis(elem->min_dims, vertical);
+            float max_main = get_axis(elem->max_dims, vertical);
+            float pad_main = get_axis(elem->padding, vertical);
+            float pad_cross = get_axis(elem->padding, !vertical);
+
+            float size = limit_size(get_axis(elem->requested_dims, vertical), min_main, max_main);
+            if(free_space > 0 && grow_total > 0) {
+                size += free_space * elem->grow / grow_total;
+            } else if(free_space < 0 && shrink_total > 0) {
+                size += free_space * elem->shrink * size / shrink_total;
+            }
+            size = max(limit_size(size, min_main, max_main), 0);
+
+            float cross = limit_size(get_axis(elem->requested_dims, !vertical), get_axis(elem->min_dims, !vertical), get_axis(elem->max_dims, !vertical));
+            cross = clamp(cross, 0, max(line_cross - pad_cross * 2, 0));
+
+            aabb_2d box = aabb_2d_zero;
+            set_axis(&box.position, vertical, main_counter + pad_main);
+            set_axis(&box.position, !vertical, cross_counter + pad_cross);
+            set_axis(&box.dimensions, vertical, size);
+            set_axis(&box.dimensions, !vertical, cross);
+            elem->calculated_bounds = box;
+
+            main_counter += size + pad_main * 2 + main_spacing;
+        }
+
+        cross_counter += line_cross + cross_spacing;
+        line_start = line_end;
+    }
+}
+
+// Recalculate the bounds of a layout's direct children
+static void layout_solve(layout* l) {
     switch(l->type) {
         // Free layout type: Children don't interact, and attach to the layout based on their alignment
         case LAYOUT_FREE:
             array_foreach(l->children, it) {
-                layout_element* elem = array_iter_data(it, layout_element*);
-
-                aabb_2d box = {
-                    .position = vec2_zero,
-                    .dimensions = vec2_add(elem->requested_dims, vec2_mul(elem->padding, 2))
-                };
-
-                box.dimensions.x = clamp(box.dimensions.x, 0, l->bounds.calculated_bounds.dimensions.x);
-                box.dimensions.y = clamp(box.dimensions.y, 0, l->bounds.calculated_bounds.dimensions.y);
-                aabb_2d bounds = aabb_align_box_2d(box, l->bounds.calculated_bounds, elem->align);
-            
-                elem->calculated_bounds = (aabb_2d) {
-                    .position=vec2_add(bounds.position, elem->padding),
-                    .dimensions=vec2_sub(box.dimensions, vec2_mul(elem->padding, 2))
-                };
+                place_in_area(array_iter_data(it, layout_element*), l->bounds.calculated_bounds);
             }
         break;
         // Horizontal layout type: Children are placed next to each other in a horizontal line, and resize proportionally if the line overflows
@@ -125,10 +393,188 @@ void layout_update(layout* l) {
                 }
             }
         } break;
+        case LAYOUT_GRID:
+            layout_solve_grid(l);
+        break;
+        case LAYOUT_FLEX_HORIZONTAL:
+            layout_solve_flex(l, false);
+        break;
+        case LAYOUT_FLEX_VERTICAL:
+            layout_solve_flex(l, true);
+        break;
+    }
+}
+
+// Reports the old and new bounds of every element that moved or resized in the last solve
+static void layout_report_damage(layout* l, ui_damage d) {
+    array_foreach(l->children, it) {
+        layout_element* elem = array_iter_data(it, layout_element*);
+
+        // Nested layouts aren't drawn themselves, and report their own children
+        if(elem->sublayout != NULL || bounds_equal(elem->calculated_bounds, elem->damage_bounds)) {
+            continue;
+        }
+
+        ui_damage_add(d, elem->damage_bounds);
+        ui_damage_add(d, elem->calculated_bounds);
+        elem->damage_bounds = elem->calculated_bounds;
+    }
+}
+
+// Files every element in the index, which only moves the ones whose bounds changed
+static void layout_update_index(layout* l, layout_index idx) {
+    array_foreach(l->children, it) {
+        layout_element* elem = array_iter_data(it, layout_element*);
+
+        // Nested layouts index their own children
+        if(elem->sublayout == NULL) {
+            layout_index_update(idx, elem);
+        }
+    }
+}
+
+// Solves l if it's dirty or its bounds have changed, without visiting nested layouts.
+// Returns true if nested layouts need to be visited.
+static bool layout_update_node(layout* l) {
+    // If a parent moved or resized this layout, its children need to follow
+    if(!bounds_equal(l->bounds.calculated_bounds, l->solved_bounds)) {
+        l->is_dirty = true;
+    }
+
+    l->was_solved = l->is_dirty;
+    l->solve_count = 0;
+    if(l->was_solved) {
+        layout_solve(l);
+        l->solved_bounds = l->bounds.calculated_bounds;
+        l->is_dirty = false;
+        l->solve_count = array_get_length(l->children);
+    }
+
+    // After a solve any nested layout may have new bounds, otherwise only dirty ones need visiting
+    bool visit_children = l->was_solved || l->has_dirty_child;
+    l->has_dirty_child = false;
+
+    return visit_children;
+}
+
+// Reports the results of solving l to its damage tracker and index
+static void layout_report_solve(layout* l, ui_damage damage, layout_index idx) {
+    if(!l->was_solved) {
+        return;
+    }
+
+    if(damage != NULL) {
+        layout_report_damage(l, damage);
+    }
+    if(idx != NULL) {
+        layout_update_index(l, idx);
     }
 }
 
+// Update a layout and any nested layouts that need it, returning the number of elements re-solved
+static uint32 layout_update_tree(layout* l, ui_damage damage, layout_index idx) {
+    if(l->damage != NULL) {
+        damage = l->damage;
+    }
+    if(l->index != NULL) {
+        idx = l->index;
+    }
+
+    bool visit_children = layout_update_node(l);
+    layout_report_solve(l, damage, idx);
+
+    uint32 count = l->solve_count;
+    if(visit_children) {
+        array_foreach(l->children, it) {
+            layout_element* elem = array_iter_data(it, layout_element*);
+            if(elem->sublayout != NULL) {
+                count += layout_update_tree(elem->sublayout, damage, idx);
+            }
+        }
+    }
+
+    l->solve_count = count;
+    return count;
+}
+
+// Update a layout, recalculating the bounds of its children.
+// Only dirty layouts and layouts whose bounds have changed are re-solved.
+void layout_update(layout* l) {
+    ui_stat_time_begin(UI_STAT_TIME_LAYOUT_UPDATE);
+
+    uint32 count = layout_update_tree(l, NULL, NULL);
+
+    ui_stat_time_end(UI_STAT_TIME_LAYOUT_UPDATE);
+    ui_stat_add(UI_STAT_LAYOUT_SOLVES, count);
+}
+
+// Solves one layout on a pool worker, and queues the nested layouts that need visiting.
+// Each layout only writes to its own children, so siblings never touch the same data.
+static void layout_update_task(layout* l, layout_pool p, uint16 worker) {
+    l->was_visited = true;
+    if(!layout_update_node(l)) {
+        return;
+    }
+
+    array_foreach(l->children, it) {
+        layout_element* elem = array_iter_data(it, layout_element*);
+        if(elem->sublayout != NULL) {
+            layout_pool_push(p, worker, elem->sublayout);
+        }
+    }
+}
+
+// Walks the layouts visited by a parallel update in the same order as layout_update_tree,
+// so that damage and index updates happen exactly as they would have serially
+static uint32 layout_finish_tree(layout* l, ui_damage damage, layout_index idx) {
+    if(l->damage != NULL) {
+        damage = l->damage;
+    }
+    if(l->index != NULL) {
+        idx = l->index;
+    }
+
+    l->was_visited = false;
+    layout_report_solve(l, damage, idx);
+
+    uint32 count = l->solve_count;
+    array_foreach(l->children, it) {
+        layout_element* elem = array_iter_data(it, layout_element*);
+        if(elem->sublayout != NULL && elem->sublayout->was_visited) {
+            count += layout_finish_tree(elem->sublayout, damage, idx);
+        }
+    }
+
+    l->solve_count = count;
+    return count;
+}
+
+// Update a layout like layout_update, solving independent nested layouts on a pool of threads
+void layout_update_parallel(layout* l, layout_pool p) {
+    check_return(l != NULL, "Layout is NULL", );
+    check_return(p != NULL, "Layout pool is NULL", );
+
+    ui_stat_time_begin(UI_STAT_TIME_LAYOUT_UPDATE);
+
+    layout_pool_run(p, l, layout_update_task);
+    uint32 count = layout_finish_tree(l, NULL, NULL);
+
+    ui_stat_time_end(UI_STAT_TIME_LAYOUT_UPDATE);
+    ui_stat_add(UI_STAT_LAYOUT_SOLVES, count);
+}
+
+// Get the number of elements that were re-solved by the last update, including nested layouts
+uint32 layout_get_solve_count(const layout* l) {
+    return l->solve_count;
+}
+
 // Cleanup a layout, freeing resources
 void layout_cleanup(layout* l) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    // Children can outlive the layout, and mustn't mark it dirty once it's gone
+    array_foreach(l->children, it) {
+        array_iter_data(it, layout_element*)->parent = NULL;
+    }
     array_free(l->children);
 }
@@ -3,31 +3,104 @@
 #include "core/container/array.h"
 
 #include "layout_element.h"
+#include "ui_arena.h"
+#include "ui_damage.h"
+
+struct layout_pool;
 
 // Represents the way elements are arranged in a layout
 typedef enum layout_type {
     LAYOUT_FREE,
     LAYOUT_STACK_HORIZONTAL,
     LAYOUT_STACK_VERTICAL,
+    LAYOUT_GRID,
+    LAYOUT_FLEX_HORIZONTAL,
+    LAYOUT_FLEX_VERTICAL,
 } layout_type;
 
-// Represents a set of layout elements in a particular arrangement
+// Represents a set of layout elements in a particular arrangement.
+// Layouts can be nested by adding a layout's bounds to another layout.
 typedef struct layout {
     array children;
     layout_element bounds;
     layout_type type;
+
+    // Grid layouts: the number of columns. 0 is treated as 1.
+    uint16 columns;
+    // Grid and flex layouts: the gap between neighbouring cells or elements
+    vec2 spacing;
+    // Flex layouts: whether elements that don't fit move onto a new line
+    bool wrap;
+
+    // The bounds that the children were last solved against
+    aabb_2d solved_bounds;
+    // Set when this layout's children need to be re-solved
+    bool is_dirty;
+    // Set when a nested layout somewhere below this one is dirty
+    bool has_dirty_child;
+
+    // The number of elements that were re-solved by the last update, including nested layouts
+    uint32 solve_count;
+    // Whether the last update re-solved this layout's children, and whether a parallel update
+    // has visited this layout but not yet reported its results
+    bool was_solved;
+    bool was_visited;
+
+    // If set, elements that move or resize are reported here. Nested layouts without their own tracker use their parent's.
+    ui_damage damage;
+    // If set, elements are kept in this hit-test index. Nested layouts without their own index use their parent's.
+    struct layout_index* index;
 } layout;
 
 // Initialize a new layout
 void layout_init(layout* l, vec2 bounds, layout_type type);
 
-// Add a new element to a layout
+// Create a new layout in an arena. It's cleaned up along with the arena, and must not be passed to layout_cleanup.
+layout* layout_new_in(ui_arena a, vec2 bounds, layout_type type);
+
+// Add a new element to a layout. The element must not already be in a layout.
+// Its parent, nested layout and index fields are set here, but its inputs (requested_dims, padding, align
+// and the flex fields) are read as-is, so elements that weren't zero-allocated should be set up with
+// layout_element_init first. After writing requested_dims or padding directly instead of through the
+// layout_element_set_ functions, call layout_element_mark_dirty so that the layout is re-solved.
 void layout_add_element(layout* l, layout_element* elem);
 
-// Update a layout, recalculating the bounds of its children
+// Add a nested layout to a layout. The child is updated along with its parent.
+void layout_add_layout(layout* l, layout* child);
+
+// Set the number of columns in a grid layout
+void layout_set_columns(layout* l, uint16 columns);
+
+// Set the gap between cells or elements in grid and flex layouts
+void layout_set_spacing(layout* l, vec2 spacing);
+
+// Set whether a flex layout wraps elements onto new lines
+void layout_set_wrap(layout* l, bool wrap);
+
+// Set the damage tracker that elements report their old and new bounds to when they move or resize.
+// Bounds are reported as they're calculated, so layouts using this should be in screen space.
+void layout_set_damage(layout* l, ui_damage d);
+
+// Set the hit-test index that this layout's elements are kept in as they're solved.
+// Elements are added on the next solve, and only re-filed when their bounds change after that.
+void layout_set_index(layout* l, struct layout_index* idx);
+
+// Mark a layout as needing its children re-solved, and notify its parents
+void layout_mark_dirty(layout* l);
+
+// Update a layout, recalculating the bounds of its children.
+// Only dirty layouts and layouts whose bounds have changed are re-solved.
 void layout_update(layout* l);
 
-// Cleanup a layout, freeing resources
+// Update a layout like layout_update, solving nested layouts on a pool of threads.
+// Once a layout is solved, each of its nested layouts can be solved independently of its siblings.
+// The results, solve counts, damage and index updates are identical to layout_update.
+void layout_update_parallel(layout* l, struct layout_pool* p);
+
+// Get the number of elements that were re-solved by the last update, including nested layouts
+uint32 layout_get_solve_count(const layout* l);
+
+// Cleanup a layout, freeing resources. Its children are detached, and can be added to another layout.
 void layout_cleanup(layout* l);
 
 #endif
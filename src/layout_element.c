@@ -0,0 +1,95 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "layout_element.h"
+#include "layout.h"
+
+#include "core/check.h"
+
+// Initializes an element with the given requested dimensions
+void layout_element_init(layout_element* elem, vec2 requested_dims) {
+    check_return(elem != NULL, "Layout element is NULL", );
+
+    *elem = (layout_element) {
+        .requested_dims = requested_dims,
+        .padding = vec2_zero,
+        .calculated_bounds = aabb_2d_zero,
+        .align = ALIGN_DEFAULT,
+        .grow = 0,
+        .shrink = 0,
+        .min_dims = vec2_zero,
+        .max_dims = vec2_zero,
+        .parent = NULL,
+        .sublayout = NULL,
+        .index = NULL
+    };
+}
+
+// Sets the requested dimensions of an element, marking its layout as dirty
+void layout_element_set_requested_dims(layout_element* elem, vec2 dims) {
+    check_return(elem != NULL, "Layout element is NULL", );
+
+    if(dims.x == elem->requested_dims.x && dims.y == elem->requested_dims.y) {
+        return;
+    }
+
+    elem->requested_dims = dims;
+    layout_element_mark_dirty(elem);
+}
+
+// Sets the padding of an element, marking its layout as dirty
+void layout_element_set_padding(layout_element* elem, vec2 padding) {
+    check_return(elem != NULL, "Layout element is NULL", );
+
+    if(padding.x == elem->padding.x && padding.y == elem->padding.y) {
+        return;
+    }
+
+    elem->padding = padding;
+    layout_element_mark_dirty(elem);
+}
+
+// Sets the alignment of an element, marking its layout as dirty
+void layout_element_set_align(layout_element* elem, alignment_2d align) {
+    check_return(elem != NULL, "Layout element is NULL", );
+    check_return(align <= ALIGN_LAST, "Invalid element alignment 0x%x", , align);
+
+    if(align == elem->align) {
+        return;
+    }
+
+    elem->align = align;
+    layout_element_mark_dirty(elem);
+}
+
+// Sets the flex grow and shrink weights of an element, marking its layout as dirty
+void layout_element_set_flex(layout_element* elem, float grow, float shrink) {
+    check_return(elem != NULL, "Layout element is NULL", );
+    check_return(grow >= 0 && shrink >= 0, "Flex weights can't be negative", );
+
+    elem->grow = grow;
+    elem->shrink = shrink;
+    layout_element_mark_dirty(elem);
+}
+
+// Sets the flex size limits of an element, marking its layout as dirty
+void layout_element_set_size_limits(layout_element* elem, vec2 min_dims, vec2 max_dims) {
+    check_return(elem != NULL, "Layout element is NULL", );
+
+    elem->min_dims = min_dims;
+    elem->max_dims = max_dims;
+    layout_element_mark_dirty(elem);
+}
+
+// Marks the layout containing an element as needing an update.
+// Call this after changing an element's fields directly.
+void layout_element_mark_dirty(layout_element* elem) {
+    check_return(elem != NULL, "Layout element is NULL", );
+
+    if(elem->parent != NULL) {
+        layout_mark_dirty(elem->parent);
+    } else if(elem->sublayout != NULL) {
+        // Root layouts have no parent to re-solve them, so they re-solve their own children
+        layout_mark_dirty(elem->sublayout);
+    }
+}
@@ -4,12 +4,58 @@
 #include "math/aabb.h"
 #include "frame.h"
 
+struct layout;
+struct layout_index;
+
 // Represents a single element in a larger UI layout
 typedef struct layout_element {
     vec2 requested_dims;
     vec2 padding;
     aabb_2d calculated_bounds;
     alignment_2d align;
+
+    // Used by flex layouts: the share of free space this element takes when its line has room left,
+    // and the share of overflow it gives up when its line is too long. 0 keeps the requested size.
+    float grow;
+    float shrink;
+    // Used by flex layouts: limits on the element's size. A max of 0 on an axis means there is no limit.
+    vec2 min_dims;
+    vec2 max_dims;
+
+    // The layout containing this element, or NULL if it hasn't been added to one
+    struct layout* parent;
+    // If this element is the bounds of a nested layout, that layout. Otherwise NULL.
+    struct layout* sublayout;
+
+    // The bounds last reported to its layout's damage tracker
+    aabb_2d damage_bounds;
+
+    // The hit-test index this element is in, if any, and the bounds it's filed under
+    struct layout_index* index;
+    aabb_2d indexed_bounds;
 } layout_element;
 
+// Initializes an element with the given requested dimensions, no padding, the default alignment and no flex weights or limits.
+// Elements on the stack or from salloc should be initialized before they're added to a layout.
+void layout_element_init(layout_element* elem, vec2 requested_dims);
+
+// Sets the requested dimensions of an element, marking its layout as dirty
+void layout_element_set_requested_dims(layout_element* elem, vec2 dims);
+
+// Sets the padding of an element, marking its layout as dirty
+void layout_element_set_padding(layout_element* elem, vec2 padding);
+
+// Sets the alignment of an element, marking its layout as dirty
+void layout_element_set_align(layout_element* elem, alignment_2d align);
+
+// Sets the flex grow and shrink weights of an element, marking its layout as dirty
+void layout_element_set_flex(layout_element* elem, float grow, float shrink);
+
+// Sets the flex size limits of an element, marking its layout as dirty
+void layout_element_set_size_limits(layout_element* elem, vec2 min_dims, vec2 max_dims);
+
+// Marks the layout containing an element as needing an update.
+// Call this after changing an element's fields directly.
+void layout_element_mark_dirty(layout_element* elem);
+
 #endif // DF_UI_LAYOUT_ELEMENT
@@ -0,0 +1,309 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "layout_flat.h"
+#include "ui_stats.h"
+
+#include "core/check.h"
+#include "core/log/log.h"
+#include "core/memory/alloc.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// Initialize a new flat layout
+void layout_flat_init(layout_flat* l, vec2 bounds, layout_type type) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    *l = (layout_flat) {
+        .bounds = {
+            .position = vec2_zero,
+            .dimensions = bounds
+        },
+        .type = type,
+        .count = 0,
+        .capacity = 0,
+    };
+}
+
+// Add a new element to a flat layout, returning its index
+uint32 layout_flat_add_element(layout_flat* l, vec2 requested_dims, vec2 padding, alignment_2d align) {
+    check_return(l != NULL, "Layout is NULL", 0);
+
+    if(l->count == l->capacity) {
+        l->capacity = l->capacity == 0 ? 16 : l->capacity * 2;
+
+        l->requested_w = srealloc(l->requested_w, l->capacity * sizeof(float));
+        l->requested_h = srealloc(l->requested_h, l->capacity * sizeof(float));
+        l->padding_x   = srealloc(l->padding_x,   l->capacity * sizeof(float));
+        l->padding_y   = srealloc(l->padding_y,   l->capacity * sizeof(float));
+        l->align       = srealloc(l->align,       l->capacity * sizeof(alignment_2d));
+        l->x           = srealloc(l->x,           l->capacity * sizeof(float));
+        l->y           = srealloc(l->y,           l->capacity * sizeof(float));
+        l->w           = srealloc(l->w,           l->capacity * sizeof(float));
+        l->h           = srealloc(l->h,           l->capacity * sizeof(float));
+        l->advance     = srealloc(l->advance,     l->capacity * sizeof(float));
+    }
+
+    uint32 i = l->count++;
+    l->requested_w[i] = requested_dims.x;
+    l->requested_h[i] = requested_dims.y;
+    l->padding_x[i] = padding.x;
+    l->padding_y[i] = padding.y;
+    l->align[i] = align;
+    l->x[i] = 0;
+    l->y[i] = 0;
+    l->w[i] = 0;
+    l->h[i] = 0;
+
+    return i;
+}
+
+// Remove all elements from a flat layout, keeping its storage
+void layout_flat_clear(layout_flat* l) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    l->count = 0;
+}
+
+// out[i] = clamp(req[i], 0, limit - pad[i] * 2)
+// The vector path computes min(max(v, 0), hi), which only matches clamp when hi >= 0,
+// so elements with a negative upper limit are redone with clamp to keep results identical.
+static void clamp_dims(const float* req, const float* pad, float limit, float* out, uint32 count) {
+    uint32 i = 0;
+#if defined(__AVX__)
+    const __m256 zero8 = _mm256_setzero_ps();
+    const __m256 two8 = _mm256_set1_ps(2);
+    const __m256 limit8 = _mm256_set1_ps(limit);
+    for(; i + 8 <= count; i += 8) {
+        __m256 hi = _mm256_sub_ps(limit8, _mm256_mul_ps(_mm256_loadu_ps(pad + i), two8));
+        __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(req + i), zero8), hi);
+        _mm256_storeu_ps(out + i, v);
+    }
+#endif
+#if defined(__SSE__)
+    const __m128 zero4 = _mm_setzero_ps();
+    const __m128 two4 = _mm_set1_ps(2);
+    const __m128 limit4 = _mm_set1_ps(limit);
+    for(; i + 4 <= count; i += 4) {
+        __m128 hi = _mm_sub_ps(limit4, _mm_mul_ps(_mm_loadu_ps(pad + i), two4));
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(req + i), zero4), hi);
+        _mm_storeu_ps(out + i, v);
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = clamp(req[i], 0, limit - pad[i] * 2);
+    }
+
+#if defined(__SSE__)
+    for(i = 0; i < count; ++i) {
+        if(limit - pad[i] * 2 < 0) {
+            out[i] = clamp(req[i], 0, limit - pad[i] * 2);
+        }
+    }
+#endif
+}
+
+// out[i] = a[i] + pad[i] * 2
+static void add_padding(const float* a, const float* pad, float* out, uint32 count) {
+    uint32 i = 0;
+#if defined(__AVX__)
+    const __m256 two8 = _mm256_set1_ps(2);
+    for(; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_mul_ps(_mm256_loadu_ps(pad + i), two8));
+        _mm256_storeu_ps(out + i, v);
+    }
+#endif
+#if defined(__SSE__)
+    const __m128 two4 = _mm_set1_ps(2);
+    for(; i + 4 <= count; i += 4) {
+        __m128 v = _mm_add_ps(_mm_loadu_ps(a + i), _mm_mul_ps(_mm_loadu_ps(pad + i), two4));
+        _mm_storeu_ps(out + i, v);
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = a[i] + pad[i] * 2;
+    }
+}
+
+// out[i] = a[i] + b[i]
+static void add_arrays(const float* a, const float* b, float* out, uint32 count) {
+    uint32 i = 0;
+#if defined(__AVX__)
+    for(; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+#endif
+#if defined(__SSE__)
+    for(; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+// out[i] = a[i] + s
+static void add_scalar(const float* a, float s, float* out, uint32 count) {
+    uint32 i = 0;
+#if defined(__AVX__)
+    const __m256 s8 = _mm256_set1_ps(s);
+    for(; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), s8));
+    }
+#endif
+#if defined(__SSE__)
+    const __m128 s4 = _mm_set1_ps(s);
+    for(; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), s4));
+    }
+#endif
+    for(; i < count; ++i) {
+        out[i] = a[i] + s;
+    }
+}
+
+// a[i] *= s
+static void scale_array(float* a, float s, uint32 count) {
+    uint32 i = 0;
+#if defined(__AVX__)
+    const __m256 s8 = _mm256_set1_ps(s);
+    for(; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(a + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), s8));
+    }
+#endif
+#if defined(__SSE__)
+    const __m128 s4 = _mm_set1_ps(s);
+    for(; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(a + i, _mm_mul_ps(_mm_loadu_ps(a + i), s4));
+    }
+#endif
+    for(; i < count; ++i) {
+        a[i] *= s;
+    }
+}
+
+// Replaces each advance with the running position before it, starting at start. Returns the final position.
+// This stays scalar and in order, since reassociating the sum would change the rounding.
+static float exclusive_scan(float* advance, float start, uint32 count) {
+    float counter = start;
+    for(uint32 i = 0; i < count; ++i) {
+        float a = advance[i];
+        advance[i] = counter;
+        counter += a;
+    }
+
+    return counter;
+}
+
+// Places elements one after another along a single axis, shrinking them if they overflow.
+// main_* refer to the stacking axis, and cross_* to the other one.
+static void layout_flat_stack(layout_flat* l, float main_start, float main_size, float cross_start, float cross_size,
+        const float* main_req, const float* main_pad, const float* cross_req, const float* cross_pad,
+        float* main_pos, float* main_dims, float* cross_pos, float* cross_dims) {
+    uint32 count = l->count;
+
+    // Cross axis: every element starts at the edge of the layout
+    add_scalar(cross_pad, cross_start, cross_pos, count);
+    clamp_dims(cross_req, cross_pad, cross_size, cross_dims, count);
+
+    // Main axis: each element is placed after the previous one
+    clamp_dims(main_req, main_pad, main_size, main_dims, count);
+    add_padding(main_dims, main_pad, l->advance, count);
+    float counter = exclusive_scan(l->advance, main_start, count);
+    add_arrays(l->advance, main_pad, main_pos, count);
+
+    if(counter - main_start > main_size) {
+        float ratio = main_size / (counter - main_start);
+
+        scale_array(main_dims, ratio, count);
+        add_padding(main_dims, main_pad, l->advance, count);
+        exclusive_scan(l->advance, main_start, count);
+        add_arrays(l->advance, main_pad, main_pos, count);
+    }
+}
+
+// Update a flat layout, recalculating the bounds of its elements
+void layout_flat_update(layout_flat* l) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    ui_stat_time_begin(UI_STAT_TIME_LAYOUT_UPDATE);
+
+    switch(l->type) {
+        // Free layout type: Children don't interact, and attach to the layout based on their alignment
+        case LAYOUT_FREE:
+            for(uint32 i = 0; i < l->count; ++i) {
+                vec2 padding = { .x = l->padding_x[i], .y = l->padding_y[i] };
+                vec2 requested_dims = { .x = l->requested_w[i], .y = l->requested_h[i] };
+
+                aabb_2d box = {
+                    .position = vec2_zero,
+                    .dimensions = vec2_add(requested_dims, vec2_mul(padding, 2))
+                };
+
+                box.dimensions.x = clamp(box.dimensions.x, 0, l->bounds.dimensions.x);
+                box.dimensions.y = clamp(box.dimensions.y, 0, l->bounds.dimensions.y);
+                aabb_2d bounds = aabb_align_box_2d(box, l->bounds, l->align[i]);
+
+                vec2 position = vec2_add(bounds.position, padding);
+                vec2 dimensions = vec2_sub(box.dimensions, vec2_mul(padding, 2));
+                l->x[i] = position.x;
+                l->y[i] = position.y;
+                l->w[i] = dimensions.x;
+                l->h[i] = dimensions.y;
+            }
+        break;
+        // Horizontal layout type: Children are placed next to each other in a horizontal line, and resize proportionally if the line overflows
+        case LAYOUT_STACK_HORIZONTAL:
+            layout_flat_stack(l, l->bounds.position.x, l->bounds.dimensions.x, l->bounds.position.y, l->bounds.dimensions.y,
+                    l->requested_w, l->padding_x, l->requested_h, l->padding_y,
+                    l->x, l->w, l->y, l->h);
+        break;
+        // Vertical layout type: Children are placed next to each other in a vertical line, and resize proportionally if the line overflows
+        case LAYOUT_STACK_VERTICAL:
+            layout_flat_stack(l, l->bounds.position.y, l->bounds.dimensions.y, l->bounds.position.x, l->bounds.dimensions.x,
+                    l->requested_h, l->padding_y, l->requested_w, l->padding_x,
+                    l->y, l->h, l->x, l->w);
+        break;
+        default:
+            error("Flat layouts don't support layout type %d", l->type);
+        break;
+    }
+
+    ui_stat_time_end(UI_STAT_TIME_LAYOUT_UPDATE);
+    ui_stat_add(UI_STAT_LAYOUT_SOLVES, l->count);
+}
+
+// Get the calculated bounds of an element
+aabb_2d layout_flat_get_bounds(const layout_flat* l, uint32 index) {
+    check_return(l != NULL, "Layout is NULL", aabb_2d_zero);
+    check_return(index < l->count, "Element index %u is out of range", aabb_2d_zero, index);
+
+    return (aabb_2d) {
+        .position = { .x = l->x[index], .y = l->y[index] },
+        .dimensions = { .x = l->w[index], .y = l->h[index] }
+    };
+}
+
+// Cleanup a flat layout, freeing resources
+void layout_flat_cleanup(layout_flat* l) {
+    check_return(l != NULL, "Layout is NULL", );
+
+    sfree(l->requested_w);
+    sfree(l->requested_h);
+    sfree(l->padding_x);
+    sfree(l->padding_y);
+    sfree(l->align);
+    sfree(l->x);
+    sfree(l->y);
+    sfree(l->w);
+    sfree(l->h);
+    sfree(l->advance);
+
+    l->count = 0;
+    l->capacity = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef DF_UI_LAYOUT_FLAT
+#define DF_UI_LAYOUT_FLAT
+#include "core/types.h"
+#include "math/aabb.h"
+#include "math/alignment.h"
+
+#include "layout.h"
+
+// A layout that stores its elements in flat structure-of-arrays storage instead of
+// pointing to separate layout_elements. This is intended for very large layouts
+// (eg. long lists or inventory grids) where chasing a pointer per element is slow.
+// Results are identical to a layout with the same elements.
+typedef struct layout_flat {
+    aabb_2d bounds;
+    layout_type type;
+
+    uint32 count;
+    uint32 capacity;
+
+    // Element inputs
+    float* requested_w;
+    float* requested_h;
+    float* padding_x;
+    float* padding_y;
+    alignment_2d* align;
+
+    // Calculated bounds
+    float* x;
+    float* y;
+    float* w;
+    float* h;
+
+    // Scratch space for the distance each element advances a stack
+    float* advance;
+} layout_flat;
+
+// Initialize a new flat layout
+void layout_flat_init(layout_flat* l, vec2 bounds, layout_type type);
+
+// Add a new element to a flat layout, returning its index
+uint32 layout_flat_add_element(layout_flat* l, vec2 requested_dims, vec2 padding, alignment_2d align);
+
+// Remove all elements from a flat layout, keeping its storage
+void layout_flat_clear(layout_flat* l);
+
+// Update a flat layout, recalculating the bounds of its elements
+void layout_flat_update(layout_flat* l);
+
+// Get the calculated bounds of an element
+aabb_2d layout_flat_get_bounds(const layout_flat* l, uint32 index);
+
+// Cleanup a flat layout, freeing resources
+void layout_flat_cleanup(layout_flat* l);
+
+#endif // DF_UI_LAYOUT_FLAT
@@ -0,0 +1,210 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "layout_index.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+
+#include <math.h>
+
+// A range of cells, inclusive
+typedef struct cell_range {
+    uint16 first_column;
+    uint16 first_row;
+    uint16 last_column;
+    uint16 last_row;
+} cell_range;
+
+// Create an index covering area, split into cells of cell_size
+layout_index layout_index_new(aabb_2d area, vec2 cell_size) {
+    check_return(cell_size.x > 0 && cell_size.y > 0, "Layout index cells must have a size", NULL);
+
+    layout_index idx = mscalloc(1, struct layout_index);
+    idx->area = area;
+    idx->cell_size = cell_size;
+    idx->columns = (uint16)max(ceilf(area.dimensions.x / cell_size.x), 1);
+    idx->rows = (uint16)max(ceilf(area.dimensions.y / cell_size.y), 1);
+    idx->cells = scalloc((size_t)idx->columns * idx->rows, sizeof(layout_index_cell));
+    idx->element_count = 0;
+
+    return idx;
+}
+
+// Frees the index
+void _layout_index_free(layout_index idx) {
+    check_return(idx != NULL, "Layout index is NULL", );
+
+    layout_index_clear(idx);
+    for(uint32 i = 0; i < (uint32)idx->columns * idx->rows; ++i) {
+        sfree(idx->cells[i].elements);
+    }
+    sfree(idx->cells);
+    sfree(idx);
+}
+
+// Gets the cell coordinate of position along one axis, clamped to the grid
+static uint16 get_cell(float position, float start, float size, uint16 count) {
+    float cell = floorf((position - start) / size);
+    return (uint16)max(min(cell, count - 1), 0);
+}
+
+static cell_range get_cell_range(layout_index idx, aabb_2d box) {
+    return (cell_range) {
+        .first_column = get_cell(box.position.x, idx->area.position.x, idx->cell_size.x, idx->columns),
+        .first_row = get_cell(box.position.y, idx->area.position.y, idx->cell_size.y, idx->rows),
+        .last_column = get_cell(box.position.x + box.dimensions.x, idx->area.position.x, idx->cell_size.x, idx->columns),
+        .last_row = get_cell(box.position.y + box.dimensions.y, idx->area.position.y, idx->cell_size.y, idx->rows)
+    };
+}
+
+static layout_index_cell* get_cell_at(layout_index idx, uint16 column, uint16 row) {
+    return &idx->cells[(uint32)row * idx->columns + column];
+}
+
+static void insert_element(layout_index idx, layout_element* elem) {
+    cell_range range = get_cell_range(idx, elem->calculated_bounds);
+    for(uint16 row = range.first_row; row <= range.last_row; ++row) {
+        for(uint16 column = range.first_column; column <= range.last_column; ++column) {
+            layout_index_cell* cell = get_cell_at(idx, column, row);
+            if(cell->count == cell->capacity) {
+                cell->capacity = max(cell->capacity * 2, 4);
+                cell->elements = srealloc(cell->elements, cell->capacity * sizeof(layout_element*));
+            }
+            cell->elements[cell->count++] = elem;
+        }
+    }
+
+    elem->index = idx;
+    elem->indexed_bounds = elem->calculated_bounds;
+    ++idx->element_count;
+}
+
+static void remove_element(layout_index idx, layout_element* elem) {
+    cell_range range = get_cell_range(idx, elem->indexed_bounds);
+    for(uint16 row = range.first_row; row <= range.last_row; ++row) {
+        for(uint16 column = range.first_column; column <= range.last_column; ++column) {
+            layout_index_cell* cell = get_cell_at(idx, column, row);
+            for(uint32 i = 0; i < cell->count; ++i) {
+                if(cell->elements[i] == elem) {
+                    cell->elements[i] = cell->elements[--cell->count];
+                    break;
+                }
+            }
+        }
+    }
+
+    elem->index = NULL;
+    --idx->element_count;
+}
+
+void layout_index_update(layout_index idx, layout_element* elem) {
+    check_return(idx != NULL, "Layout index is NULL", );
+    check_return(elem != NULL, "Layout element is NULL", );
+
+    if(elem->index == idx) {
+        aabb_2d a = elem->indexed_bounds;
+        aabb_2d b = elem->calculated_bounds;
+        if(a.position.x == b.position.x && a.position.y == b.position.y && a.dimensions.x == b.dimensions.x && a.dimensions.y == b.dimensions.y) {
+            return;
+        }
+        remove_element(idx, elem);
+    } else if(elem->index != NULL) {
+        remove_element(elem->index, elem);
+    }
+
+    insert_element(idx, elem);
+}
+
+void layout_index_remove(layout_index idx, layout_element* elem) {
+    check_return(idx != NULL, "Layout index is NULL", );
+    check_return(elem != NULL, "Layout element is NULL", );
+    check_return(elem->index == idx, "Layout element isn't in this index", );
+
+    remove_element(idx, elem);
+}
+
+void layout_index_clear(layout_index idx) {
+    check_return(idx != NULL, "Layout index is NULL", );
+
+    // Elements can span several cells, so they're detached as they're seen and skipped after that
+    for(uint32 i = 0; i < (uint32)idx->columns * idx->rows; ++i) {
+        layout_index_cell* cell = &idx->cells[i];
+        for(uint32 j = 0; j < cell->count; ++j) {
+            cell->elements[j]->index = NULL;
+        }
+        cell->count = 0;
+    }
+    idx->element_count = 0;
+}
+
+uint32 layout_index_get_count(layout_index idx) {
+    check_return(idx != NULL, "Layout index is NULL", 0);
+
+    return idx->element_count;
+}
+
+static bool contains_point(aabb_2d box, vec2 point) {
+    return point.x >= box.position.x && point.x <= box.position.x + box.dimensions.x &&
+           point.y >= box.position.y && point.y <= box.position.y + box.dimensions.y;
+}
+
+static bool overlaps(aabb_2d a, aabb_2d b) {
+    return a.position.x <= b.position.x + b.dimensions.x && b.position.x <= a.position.x + a.dimensions.x &&
+           a.position.y <= b.position.y + b.dimensions.y && b.position.y <= a.position.y + a.dimensions.y;
+}
+
+layout_element* layout_index_query_point(layout_index idx, vec2 point) {
+    check_return(idx != NULL, "Layout index is NULL", NULL);
+
+    layout_index_cell* cell = get_cell_at(idx,
+                                          get_cell(point.x, idx->area.position.x, idx->cell_size.x, idx->columns),
+                                          get_cell(point.y, idx->area.position.y, idx->cell_size.y, idx->rows));
+
+    layout_element* found = NULL;
+    float found_area = 0;
+    for(uint32 i = 0; i < cell->count; ++i) {
+        layout_element* elem = cell->elements[i];
+        if(!contains_point(elem->indexed_bounds, point)) {
+            continue;
+        }
+
+        float area = elem->indexed_bounds.dimensions.x * elem->indexed_bounds.dimensions.y;
+        if(found == NULL || area < found_area) {
+            found = elem;
+            found_area = area;
+        }
+    }
+
+    return found;
+}
+
+uint32 layout_index_query_rect(layout_index idx, aabb_2d box, layout_element** out, uint32 out_size) {
+    check_return(idx != NULL, "Layout index is NULL", 0);
+
+    uint32 count = 0;
+    cell_range query = get_cell_range(idx, box);
+    for(uint16 row = query.first_row; row <= query.last_row; ++row) {
+        for(uint16 column = query.first_column; column <= query.last_column; ++column) {
+            layout_index_cell* cell = get_cell_at(idx, column, row);
+            for(uint32 i = 0; i < cell->count; ++i) {
+                layout_element* elem = cell->elements[i];
+
+                // Elements spanning several cells are only reported from the first cell they share with the query
+                cell_range range = get_cell_range(idx, elem->indexed_bounds);
+                if(column != max(range.first_column, query.first_column) || row != max(range.first_row, query.first_row)) {
+                    continue;
+                }
+
+                if(overlaps(elem->indexed_bounds, box)) {
+                    if(count < out_size) {
+                        out[count] = elem;
+                    }
+                    ++count;
+                }
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,56 @@
+#ifndef DF_UI_LAYOUT_INDEX
+#define DF_UI_LAYOUT_INDEX
+#include "core/types.h"
+#include "math/aabb.h"
+
+#include "layout_element.h"
+
+// The elements overlapping one cell of a layout index
+typedef struct layout_index_cell {
+    layout_element** elements;
+    uint32 count;
+    uint32 capacity;
+} layout_index_cell;
+
+// A uniform grid over the calculated bounds of layout elements, for hit-testing.
+// Layouts with an index keep it up to date as they're solved, only moving the elements whose bounds changed.
+// Queries see elements where they were when they were last indexed.
+// Elements beyond the grid's area are kept in its edge cells, so queries anywhere are still exact.
+typedef struct layout_index {
+    aabb_2d area;
+    vec2 cell_size;
+    uint16 columns;
+    uint16 rows;
+    layout_index_cell* cells;
+
+    uint32 element_count;
+}* layout_index;
+
+// Create an index covering area, split into cells of cell_size.
+// Cells around the size of a typical element work best.
+layout_index layout_index_new(aabb_2d area, vec2 cell_size);
+
+// Frees the index. Elements are left untouched.
+#define layout_index_free(idx) { _layout_index_free(idx); idx = NULL; }
+void _layout_index_free(layout_index idx);
+
+// Add an element to the index, or move it if its bounds have changed since it was indexed
+void layout_index_update(layout_index idx, layout_element* elem);
+
+// Remove an element from the index. Elements must be removed before they're freed.
+void layout_index_remove(layout_index idx, layout_element* elem);
+
+// Remove every element from the index
+void layout_index_clear(layout_index idx);
+
+// Get the number of elements in the index
+uint32 layout_index_get_count(layout_index idx);
+
+// Find the element under point. If several overlap, the smallest is returned. Returns NULL if there's none.
+layout_element* layout_index_query_point(layout_index idx, vec2 point);
+
+// Find the elements overlapping box. Up to out_size are written to out, each once.
+// Returns the total number found, which may be more than out_size.
+uint32 layout_index_query_rect(layout_index idx, aabb_2d box, layout_element** out, uint32 out_size);
+
+#endif // DF_UI_LAYOUT_INDEX
@@ -0,0 +1,188 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "layout_pool.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+
+#include <sched.h>
+
+static void push_back(layout_pool_queue* q, struct layout* l) {
+    pthread_mutex_lock(&q->lock);
+    if(q->tail == q->capacity) {
+        // Reclaim the space before head before growing
+        if(q->head > 0) {
+            for(uint32 i = q->head; i < q->tail; ++i) {
+                q->layouts[i - q->head] = q->layouts[i];
+            }
+            q->tail -= q->head;
+            q->head = 0;
+        }
+        if(q->tail == q->capacity) {
+            q->capacity = max(q->capacity * 2, 64);
+            q->layouts = srealloc(q->layouts, q->capacity * sizeof(struct layout*));
+        }
+    }
+    q->layouts[q->tail++] = l;
+    pthread_mutex_unlock(&q->lock);
+}
+
+// Takes the most recently pushed layout, which is most likely to still be in cache
+static struct layout* pop_back(layout_pool_queue* q) {
+    struct layout* l = NULL;
+
+    pthread_mutex_lock(&q->lock);
+    if(q->tail > q->head) {
+        l = q->layouts[--q->tail];
+    }
+    if(q->tail == q->head) {
+        q->head = q->tail = 0;
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return l;
+}
+
+// Takes the oldest layout, which is usually the root of the largest remaining subtree
+static struct layout* steal_front(layout_pool_queue* q) {
+    struct layout* l = NULL;
+
+    pthread_mutex_lock(&q->lock);
+    if(q->tail > q->head) {
+        l = q->layouts[q->head++];
+    }
+    if(q->tail == q->head) {
+        q->head = q->tail = 0;
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return l;
+}
+
+// Processes layouts until the run is finished, stealing from other workers when out of work
+static void run_worker(layout_pool p, uint16 worker) {
+    uint16 queue_count = p->queue_count;
+
+    while(atomic_load(&p->pending) > 0) {
+        struct layout* l = pop_back(&p->queues[worker]);
+        for(uint16 i = 1; l == NULL && i < queue_count; ++i) {
+            l = steal_front(&p->queues[(worker + i) % queue_count]);
+        }
+
+        if(l == NULL) {
+            // Everything left is being processed, and may still produce more work
+            sched_yield();
+            continue;
+        }
+
+        p->func(l, p, worker);
+        atomic_fetch_sub(&p->pending, 1);
+    }
+}
+
+static void* layout_pool_thread(void* data) {
+    layout_pool_worker* w = data;
+    layout_pool p = w->pool;
+
+    uint64 generation = 0;
+    while(true) {
+        pthread_mutex_lock(&p->lock);
+        while(!p->is_stopping && p->generation == generation) {
+            pthread_cond_wait(&p->wake, &p->lock);
+        }
+        if(p->is_stopping) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        generation = p->generation;
+        pthread_mutex_unlock(&p->lock);
+
+        run_worker(p, w->index);
+    }
+
+    return NULL;
+}
+
+// Create a pool with thread_count worker threads, in addition to the calling thread
+layout_pool layout_pool_new(uint16 thread_count) {
+    layout_pool p = mscalloc(1, struct layout_pool);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->wake, NULL);
+    atomic_init(&p->pending, 0);
+
+    // Queues exist for every requested thread, so the calling thread's queue doesn't depend on how many started.
+    // Without any threads, runs still work on the calling thread alone.
+    p->queue_count = thread_count + 1;
+    p->queues = scalloc(p->queue_count, sizeof(layout_pool_queue));
+    for(uint16 i = 0; i < p->queue_count; ++i) {
+        pthread_mutex_init(&p->queues[i].lock, NULL);
+    }
+
+    p->threads = scalloc(thread_count, sizeof(pthread_t));
+    p->workers = scalloc(thread_count, sizeof(layout_pool_worker));
+    for(uint16 i = 0; i < thread_count; ++i) {
+        p->workers[i] = (layout_pool_worker){ .pool = p, .index = i };
+        if(pthread_create(&p->threads[i], NULL, layout_pool_thread, &p->workers[i]) != 0) {
+            error("Failed to start layout pool thread %u", i);
+            break;
+        }
+        ++p->thread_count;
+    }
+
+    return p;
+}
+
+// Stops the workers and frees the pool
+void _layout_pool_free(layout_pool p) {
+    check_return(p != NULL, "Layout pool is NULL", );
+
+    pthread_mutex_lock(&p->lock);
+    p->is_stopping = true;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+
+    for(uint16 i = 0; i < p->thread_count; ++i) {
+        pthread_join(p->threads[i], NULL);
+    }
+
+    for(uint16 i = 0; i < p->queue_count; ++i) {
+        pthread_mutex_destroy(&p->queues[i].lock);
+        sfree(p->queues[i].layouts);
+    }
+
+    pthread_cond_destroy(&p->wake);
+    pthread_mutex_destroy(&p->lock);
+    sfree(p->queues);
+    sfree(p->workers);
+    sfree(p->threads);
+    sfree(p);
+}
+
+void layout_pool_run(layout_pool p, struct layout* root, layout_pool_func func) {
+    check_return(p != NULL, "Layout pool is NULL", );
+    check_return(root != NULL, "Layout is NULL", );
+    check_return(func != NULL, "Layout pool function is NULL", );
+
+    uint16 self = p->queue_count - 1;
+    p->func = func;
+    atomic_store(&p->pending, 1);
+    push_back(&p->queues[self], root);
+
+    if(p->thread_count > 0) {
+        pthread_mutex_lock(&p->lock);
+        ++p->generation;
+        pthread_cond_broadcast(&p->wake);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    run_worker(p, self);
+}
+
+void layout_pool_push(layout_pool p, uint16 worker, struct layout* l) {
+    check_return(p != NULL, "Layout pool is NULL", );
+
+    // Counted before it's visible, so the run can't be seen as finished in between
+    atomic_fetch_add(&p->pending, 1);
+    push_back(&p->queues[worker], l);
+}
@@ -0,0 +1,65 @@
+#ifndef DF_UI_LAYOUT_POOL
+#define DF_UI_LAYOUT_POOL
+#include "core/types.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+struct layout;
+struct layout_pool;
+
+// Processes one layout on a pool worker. Any follow-up work is added with layout_pool_push.
+typedef void (*layout_pool_func)(struct layout* l, struct layout_pool* p, uint16 worker);
+
+// A worker's deque of layouts. The owner takes from the back, and other workers steal from the front.
+typedef struct layout_pool_queue {
+    struct layout** layouts;
+    uint32 head;
+    uint32 tail;
+    uint32 capacity;
+    pthread_mutex_t lock;
+} layout_pool_queue;
+
+// Passed to each worker thread
+typedef struct layout_pool_worker {
+    struct layout_pool* pool;
+    uint16 index;
+} layout_pool_worker;
+
+// A work-stealing pool of threads for solving layouts.
+// The thread calling layout_pool_run takes part too, as the last worker.
+typedef struct layout_pool {
+    pthread_t* threads;
+    layout_pool_worker* workers;
+    uint16 thread_count;
+
+    // One per requested thread, plus one for the calling thread, which is always the last
+    layout_pool_queue* queues;
+    uint16 queue_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool is_stopping;
+    // Incremented for each run, to wake the workers
+    uint64 generation;
+
+    // The current run's function, and the number of layouts that are queued or being processed
+    layout_pool_func func;
+    atomic_uint pending;
+}* layout_pool;
+
+// Create a pool with thread_count worker threads, in addition to the calling thread
+layout_pool layout_pool_new(uint16 thread_count);
+
+// Stops the workers and frees the pool
+#define layout_pool_free(p) { _layout_pool_free(p); p = NULL; }
+void _layout_pool_free(layout_pool p);
+
+// Runs func on root and everything pushed from it, returning once all of it is done.
+// Runs can't overlap, and only one thread may start them.
+void layout_pool_run(layout_pool p, struct layout* root, layout_pool_func func);
+
+// Queues l to be processed during the current run. worker is the worker that func was called on.
+void layout_pool_push(layout_pool p, uint16 worker, struct layout* l);
+
+#endif // DF_UI_LAYOUT_POOL
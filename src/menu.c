@@ -1,37 +1,488 @@
 #include "menu.h"
 
 #include "core/check.h"
+#include "core/memory/alloc.h"
+#include "core/stringutil.h"
 #include "graphics/font.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "frame.h"
+#include "ui_stats.h"
+
+static bool menu_font_get_glyph(void* data, uint32 c, menu_glyph* out) {
+    glyph* g = font_get_glyph((font)data, c);
+    if(g == NULL) {
+        return false;
+    }
+
+    out->texture_bounds = g->texture_bounds;
+    out->bearing = g->bearing;
+    out->advance = g->advance;
+    return true;
+}
+
+static vec2 menu_font_get_atlas_size(void* data) {
+    gltex atlas = font_get_texture((font)data);
+    return (vec2){ .x = atlas.width, .y = atlas.height };
+}
+
+// Gets a glyph source that reads from a font
+static menu_glyph_source menu_get_font_glyphs(font fnt) {
+    return (menu_glyph_source) {
+        .get_glyph = menu_font_get_glyph,
+        .get_atlas_size = menu_font_get_atlas_size,
+        .line_height = font_get_height(fnt),
+        .data = fnt
+    };
+}
+
+static void menu_init(menu m, font fnt, menu_glyph_source glyphs) {
+    m->entries = array_mnew_ordered(menu_entry, 8);
+    m->fnt = fnt;
+    m->glyphs = glyphs;
+    m->line_height = glyphs.line_height;
+    m->label_align = ALIGN_DEFAULT;
+    m->dims = vec2_zero;
+    m->dims_valid = true;
+    m->is_damaged = true;
+    m->damage_cursor = CONTAINER_INDEX_INVALID;
+    ui_buffer_init(&m->draw_buffer);
+}
+
+// The lazily built submenus of a menu tree, with their total estimated size
+struct menu_lazy_cache {
+    menu* menus;
+    uint32 count;
+    uint32 capacity;
+
+    size_t budget;
+    size_t used;
+    uint64 tick;
+};
+
+// Stops tracking a lazily built submenu
+static void menu_lazy_cache_remove(menu m) {
+    struct menu_lazy_cache* c = m->lazy_cache;
+    for(uint32 i = 0; i < c->count; ++i) {
+        if(c->menus[i] == m) {
+            c->menus[i] = c->menus[--c->count];
+            c->used -= m->lazy_size;
+            return;
+        }
+    }
+}
+
+static void menu_release(void* data);
+static void menu_lazy_touch(menu sub);
+
+// Frees an entry's label and any submenu it owns
+static void menu_release_entry(menu_entry* entry) {
+    if(entry->label != NULL) {
+        text_free(entry->label, false);
+    }
+    sfree(entry->str);
+    if(entry->owns_submenu) {
+        menu_release(entry->submenu);
+        sfree(entry->submenu);
+    }
+}
+
+// Releases the resources of a menu that live outside of its own allocation
+static void menu_release(void* data) {
+    menu m = data;
+
+    if(m->lazy_cache != NULL && m->parent != NULL) {
+        menu_lazy_cache_remove(m);
+    }
+
+    menu_invalidate_search(m);
+    sfree(m->draw_verts);
+    sfree(m->row_starts);
+    ui_buffer_cleanup(&m->draw_buffer);
+
+    if(m->is_virtual) {
+        for(uint16 i = 0; i < m->viewport_size; ++i) {
+            if(m->window_texts[i] != NULL) {
+                text_free(m->window_texts[i], false);
+            }
+        }
+        sfree(m->window_texts);
+        sfree(m->window_indices);
+    } else {
+        array_foreach(m->entries, iter) {
+            menu_release_entry(iter.data);
+        }
+        array_free(m->entries);
+    }
+
+    // Submenus are released first, since they're tracked by the cache
+    if(m->owns_lazy_cache) {
+        sfree(m->lazy_cache->menus);
+        sfree(m->lazy_cache);
+    }
+}
+
 menu menu_new(font fnt) {
     check_return(fnt != NULL, "Font is NULL", NULL);
 
     menu m = mscalloc(1, struct menu);
-    m->entries = array_mnew_ordered(menu_entry, 8);
+    menu_init(m, fnt, menu_get_font_glyphs(fnt));
+
+    return m;
+}
+
+menu menu_new_with_glyphs(menu_glyph_source glyphs) {
+    check_return(glyphs.get_glyph != NULL && glyphs.get_atlas_size != NULL, "Glyph source functions can't be NULL", NULL);
+
+    menu m = mscalloc(1, struct menu);
+    menu_init(m, NULL, glyphs);
+
+    return m;
+}
+
+menu menu_new_in(ui_arena a, font fnt) {
+    check_return(a != NULL, "Arena is NULL", NULL);
+    check_return(fnt != NULL, "Font is NULL", NULL);
+
+    menu m = ui_arena_mnew(a, struct menu);
+    menu_init(m, fnt, menu_get_font_glyphs(fnt));
+    m->in_arena = true;
+    ui_arena_defer(a, menu_release, m);
+
+    return m;
+}
+
+menu menu_new_in_with_glyphs(ui_arena a, menu_glyph_source glyphs) {
+    check_return(a != NULL, "Arena is NULL", NULL);
+    check_return(glyphs.get_glyph != NULL && glyphs.get_atlas_size != NULL, "Glyph source functions can't be NULL", NULL);
+
+    menu m = ui_arena_mnew(a, struct menu);
+    menu_init(m, NULL, glyphs);
+    m->in_arena = true;
+    ui_arena_defer(a, menu_release, m);
+
+    return m;
+}
+
+menu menu_new_virtual(font fnt, container_index count, uint16 viewport_size, menu_label_func get_label, void* user, menu_activate_event* event) {
+    check_return(fnt != NULL, "Font is NULL", NULL);
+    check_return(get_label != NULL, "Label callback is NULL", NULL);
+    check_return(viewport_size != 0, "Virtual menu viewport can't be empty", NULL);
+
+    menu m = mscalloc(1, struct menu);
+    m->entries = NULL;
     m->fnt = fnt;
+    m->glyphs = menu_get_font_glyphs(fnt);
+    m->line_height = m->glyphs.line_height;
+    m->label_align = ALIGN_DEFAULT;
+
+    m->is_virtual = true;
+    m->virtual_count = count;
+    m->get_label = get_label;
+    m->label_data = user;
+    bind_event(m->virtual_activate, event);
+
+    m->viewport_size = viewport_size;
+    m->window_start = 0;
+    m->window_texts = scalloc(viewport_size, sizeof(text));
+    m->window_indices = scalloc(viewport_size, sizeof(container_index));
+    m->is_damaged = true;
+    m->damage_cursor = CONTAINER_INDEX_INVALID;
+    ui_buffer_init(&m->draw_buffer);
+    for(uint16 i = 0; i < viewport_size; ++i) {
+        m->window_indices[i] = CONTAINER_INDEX_INVALID;
+    }
 
     return m;
 }
 
+// Gets the number of entries in a virtual menu's visible window
+static container_index menu_get_window_length(menu m) {
+    if(m->window_start >= m->virtual_count) {
+        return 0;
+    }
+
+    return min(m->viewport_size, m->virtual_count - m->window_start);
+}
+
+// Scrolls a virtual menu's window as little as possible to keep the cursor visible
+static void menu_scroll_to_cursor(menu m) {
+    if(!m->is_virtual || m->cursor == CONTAINER_INDEX_INVALID) {
+        return;
+    }
+
+    if(m->cursor < m->window_start) {
+        m->window_start = m->cursor;
+        m->is_damaged = true;
+    } else if(m->cursor >= m->window_start + m->viewport_size) {
+        m->window_start = m->cursor - m->viewport_size + 1;
+        m->is_damaged = true;
+    }
+}
+
+void menu_set_entry_count(menu m, container_index count) {
+    check_return(m != NULL, "Menu is NULL", );
+    check_return(m->is_virtual, "Can't set the entry count of a non-virtual menu", );
+
+    m->virtual_count = count;
+    m->window_start = 0;
+    for(uint16 i = 0; i < m->viewport_size; ++i) {
+        m->window_indices[i] = CONTAINER_INDEX_INVALID;
+    }
+    menu_invalidate_search(m);
+    m->is_damaged = true;
+
+    if(m->cursor >= count) {
+        m->cursor = count == 0 ? 0 : count - 1;
+    }
+    menu_scroll_to_cursor(m);
+}
+container_index menu_get_entry_count(menu m) {
+    check_return(m != NULL, "Menu is NULL", 0);
+
+    return m->is_virtual ? m->virtual_count : array_get_length(m->entries);
+}
+
+// Creates the text for a label, or returns NULL if the menu has no font
+static text menu_new_label(menu m, const char* str) {
+    if(m->fnt == NULL) {
+        return NULL;
+    }
+
+    text t = text_new(m->fnt, str);
+    text_set_align(t, m->label_align);
+    ui_stat_add(UI_STAT_TEXT_CREATIONS, 1);
+
+    return t;
+}
+
+// Measures a label from the menu's glyphs, the same way menu_build_vertices lays it out
+static vec2 menu_measure_label(menu m, const char* str) {
+    if(str == NULL || *str == '\0') {
+        return vec2_zero;
+    }
+
+    vec2 bounds = { .x = 0, .y = m->line_height };
+    float width = 0;
+    for(const char* c = str; *c != '\0'; ++c) {
+        menu_glyph g;
+        if(*c == '\n') {
+            width = 0;
+            bounds.y += m->line_height;
+        } else if(m->glyphs.get_glyph(m->glyphs.data, (unsigned char)*c, &g)) {
+            width += g.advance;
+            bounds.x = max(bounds.x, width);
+        }
+    }
+
+    return bounds;
+}
+
+// Gets the bounds of a label, from its text if it has one
+static vec2 menu_get_label_bounds(menu m, text label, const char* str) {
+    return label != NULL ? text_get_bounds(label) : menu_measure_label(m, str);
+}
+
+text menu_get_label(menu m, container_index index) {
+    check_return(m != NULL, "Menu is NULL", NULL);
+
+    if(!m->is_virtual) {
+        if(m->is_evicted) {
+            menu_lazy_touch(m);
+        }
+        menu_entry* entry = array_get(m->entries, index);
+        return entry != NULL ? entry->label : NULL;
+    }
+
+    if(index < m->window_start || index >= m->window_start + menu_get_window_length(m)) {
+        return NULL;
+    }
+
+    // Reuse whatever text is in this entry's slot, since it belongs to an entry that scrolled out
+    uint16 slot = index % m->viewport_size;
+    if(m->window_indices[slot] != index) {
+        const char* label = m->get_label(index, m->label_data);
+        if(m->window_texts[slot] == NULL) {
+            m->window_texts[slot] = menu_new_label(m, label);
+        } else {
+            text_set_str(m->window_texts[slot], label);
+        }
+        m->window_indices[slot] = index;
+    }
+
+    return m->window_texts[slot];
+}
+
+// Gets the space taken up by an entry with the given label bounds at index
+static vec2 menu_get_entry_extent(menu m, vec2 label_bounds, container_index index) {
+    return (vec2) {
+        .x = label_bounds.x + index * m->offset.x,
+        .y = label_bounds.y + index * (m->offset.y + m->line_height)
+    };
+}
+
+// Grows the cached dims to cover an entry's extent, counting the entries at each edge
+static void menu_dims_add(menu m, vec2 extent) {
+    if(extent.x > m->dims.x) {
+        m->dims.x = extent.x;
+        m->dims_count_x = 1;
+    } else if(extent.x == m->dims.x) {
+        ++m->dims_count_x;
+    }
+
+    if(extent.y > m->dims.y) {
+        m->dims.y = extent.y;
+        m->dims_count_y = 1;
+    } else if(extent.y == m->dims.y) {
+        ++m->dims_count_y;
+    }
+}
+
+// Takes an entry's extent out of the cached dims. If it was the last one at an edge, the dims need to be recalculated.
+static void menu_dims_remove(menu m, vec2 extent) {
+    if(extent.x == m->dims.x && m->dims_count_x > 0 && --m->dims_count_x == 0) {
+        m->dims_valid = false;
+    }
+    if(extent.y == m->dims.y && m->dims_count_y > 0 && --m->dims_count_y == 0) {
+        m->dims_valid = false;
+    }
+}
+
+// Recalculates the cached dims from every entry's label bounds
+static void menu_recalculate_dims(menu m) {
+    m->dims = vec2_zero;
+    m->dims_count_x = m->dims_count_y = 0;
+    array_foreach(m->entries, iter) {
+        menu_entry* entry = iter.data;
+        menu_dims_add(m, menu_get_entry_extent(m, entry->label_bounds, iter.index));
+    }
+    m->dims_valid = true;
+}
+
 container_index menu_add_entry(menu m, const char* label, menu submenu, menu_activate_event* event) {
     check_return(m != NULL, "Menu is NULL", CONTAINER_INDEX_INVALID);
+    check_return(!m->is_virtual, "Can't add entries to a virtual menu", CONTAINER_INDEX_INVALID);
 
     menu_entry entry = {
-        .label = text_new(m->fnt, label),
+        .label = menu_new_label(m, label),
+        .str = nstrdup(label != NULL ? label : ""),
         .submenu = submenu,
     };
+    entry.label_bounds = menu_get_label_bounds(m, entry.label, entry.str);
 
     bind_event(entry.activate, event);
 
     array_add(m->entries, entry);
+    container_index index = array_get_length(m->entries) - 1;
+    menu_invalidate_search(m);
+    m->is_damaged = true;
+
+    if(m->dims_valid) {
+        menu_dims_add(m, menu_get_entry_extent(m, entry.label_bounds, index));
+    }
+
+    return index;
+}
+
+container_index menu_add_lazy_entry(menu m, const char* label, menu_build_func build, void* user, menu_activate_event* event) {
+    check_return(build != NULL, "Submenu builder is NULL", CONTAINER_INDEX_INVALID);
+
+    container_index index = menu_add_entry(m, label, NULL, event);
+    if(index == CONTAINER_INDEX_INVALID) {
+        return CONTAINER_INDEX_INVALID;
+    }
+
+    menu_entry* entry = array_get(m->entries, index);
+    entry->build = build;
+    entry->build_data = user;
+
+    return index;
+}
+
+void menu_set_entry_label(menu m, container_index index, const char* label) {
+    check_return(m != NULL, "Menu is NULL", );
+    check_return(!m->is_virtual, "Can't relabel entries in a virtual menu", );
+
+    menu_entry* entry = array_get(m->entries, index);
+    check_return(entry != NULL, "Menu entry %u doesn't exist", , index);
+
+    vec2 old_extent = menu_get_entry_extent(m, entry->label_bounds, index);
+    sfree(entry->str);
+    entry->str = nstrdup(label != NULL ? label : "");
+    if(entry->label != NULL) {
+        text_set_str(entry->label, entry->str);
+    }
+    menu_invalidate_search(m);
+    m->is_damaged = true;
+    entry->label_bounds = menu_get_label_bounds(m, entry->label, entry->str);
+    vec2 extent = menu_get_entry_extent(m, entry->label_bounds, index);
+
+    if(m->dims_valid) {
+        // If this entry was the last one at an edge and shrank, another entry may define that edge now
+        menu_dims_remove(m, old_extent);
+        if(m->dims_valid) {
+            menu_dims_add(m, extent);
+        } else {
+            menu_recalculate_dims(m);
+        }
+    }
+}
 
-    return array_get_length(m->entries) - 1;
+void menu_remove_entry(menu m, container_index index) {
+    check_return(m != NULL, "Menu is NULL", );
+    check_return(!m->is_virtual, "Can't remove entries from a virtual menu", );
+    check_return(index < array_get_length(m->entries), "Menu entry %u doesn't exist", , index);
+
+    bool dims_valid = m->dims_valid;
+    menu_entry* removed = array_get(m->entries, index);
+    if(m->dims_valid) {
+        menu_dims_remove(m, menu_get_entry_extent(m, removed->label_bounds, index));
+    }
+
+    array_foreach(m->entries, iter) {
+        if(iter.index == index) {
+            menu_release_entry(iter.data);
+            array_remove_iter(m->entries, &iter);
+            break;
+        }
+    }
+
+    // Every entry after this one has moved up a row, so only their extents change
+    container_index entry_count = array_get_length(m->entries);
+    for(container_index i = index; i < entry_count && m->dims_valid; ++i) {
+        menu_entry* entry = array_get(m->entries, i);
+        menu_dims_remove(m, menu_get_entry_extent(m, entry->label_bounds, i + 1));
+    }
+    for(container_index i = index; i < entry_count && m->dims_valid; ++i) {
+        menu_entry* entry = array_get(m->entries, i);
+        menu_dims_add(m, menu_get_entry_extent(m, entry->label_bounds, i));
+    }
+    if(dims_valid && !m->dims_valid) {
+        menu_recalculate_dims(m);
+    }
+    menu_invalidate_search(m);
+    m->is_damaged = true;
+
+    if(m->cursor != CONTAINER_INDEX_INVALID && m->cursor >= entry_count) {
+        m->cursor = entry_count == 0 ? 0 : entry_count - 1;
+    }
+}
+
+void menu_set_offset(menu m, vec3 offset) {
+    check_return(m != NULL, "Menu is NULL", );
+
+    m->offset = offset;
+    m->dims_valid = false;
+    m->is_damaged = true;
 }
 
 container_index menu_set_cursor(menu m, container_index index) {
     check_return(m != NULL, "Menu is NULL", CONTAINER_INDEX_INVALID);
-    
-    if(index < array_get_length(m->entries))
+
+    if(index < menu_get_entry_count(m))
     {
         m->cursor = index;
     }
@@ -40,39 +491,350 @@ container_index menu_set_cursor(menu m, container_index index) {
         m->cursor = CONTAINER_INDEX_INVALID;
     }
 
+    menu_scroll_to_cursor(m);
+
     return m->cursor;
 }
 container_index menu_move_cursor(menu m, int16 offset) {
     check_return(m != NULL, "Menu is NULL", CONTAINER_INDEX_INVALID);
 
-    container_index entry_count = array_get_length(m->entries);
+    container_index entry_count = menu_get_entry_count(m);
     if(entry_count == 0) {
         return CONTAINER_INDEX_INVALID;
     }
-    
-    if(offset < 0 && m->cursor < -offset) {
-        if(!m->can_wrap) {
-            m->cursor = 0;
-        } else {
-            do {
-                offset += entry_count;
-            } while(m->cursor < -offset);
-            m->cursor += offset;
-        }
-    } else if(offset > 0 && m->cursor + offset >= entry_count) {
-        if(!m->can_wrap) {
-            m->cursor = entry_count - 1;
-        } else {
-            do {
-                offset -= entry_count;
-            } while(m->cursor + offset > entry_count);
-            m->cursor += offset;
+
+    int64 target = (m->cursor == CONTAINER_INDEX_INVALID ? 0 : (int64)m->cursor) + offset;
+    if(m->can_wrap) {
+        target %= (int64)entry_count;
+        if(target < 0) {
+            target += entry_count;
         }
     } else {
-        m->cursor += offset;
+        target = max(min(target, (int64)entry_count - 1), 0);
+    }
+    m->cursor = (container_index)target;
+
+    menu_scroll_to_cursor(m);
+
+    return m->cursor;
+}
+
+container_index menu_move_page(menu m, int16 pages) {
+    check_return(m != NULL, "Menu is NULL", CONTAINER_INDEX_INVALID);
+
+    container_index entry_count = menu_get_entry_count(m);
+    if(entry_count == 0) {
+        return CONTAINER_INDEX_INVALID;
+    }
+
+    int64 page_size = m->page_size;
+    if(page_size == 0) {
+        page_size = m->is_virtual ? m->viewport_size : MENU_DEFAULT_PAGE_SIZE;
     }
+
+    int64 target = (m->cursor == CONTAINER_INDEX_INVALID ? 0 : (int64)m->cursor) + pages * page_size;
+    m->cursor = (container_index)max(min(target, (int64)entry_count - 1), 0);
+
+    menu_scroll_to_cursor(m);
+
     return m->cursor;
 }
+
+void menu_set_page_size(menu m, uint16 size) {
+    check_return(m != NULL, "Menu is NULL", );
+
+    m->page_size = size;
+}
+
+static int compare_search_keys(const void* a, const void* b) {
+    const menu_search_key* key_a = a;
+    const menu_search_key* key_b = b;
+
+    int result = strcasecmp(key_a->label, key_b->label);
+    if(result != 0) {
+        return result;
+    }
+
+    // Entries with the same label are kept in menu order
+    return (key_a->index > key_b->index) - (key_a->index < key_b->index);
+}
+
+// Builds the sorted label index if entries have changed since it was last built
+static void menu_build_search(menu m) {
+    if(m->search_valid) {
+        return;
+    }
+
+    container_index count = menu_get_entry_count(m);
+    m->search_count = count;
+    m->search_valid = true;
+    m->search_length = 0;
+    m->search_first = 0;
+    m->search_end = count;
+
+    // Without entries there's nothing to index, and the buffers are kept for when there are
+    if(count == 0) {
+        return;
+    }
+
+    m->search_keys = srealloc(m->search_keys, count * sizeof(menu_search_key));
+    m->search_ranks = srealloc(m->search_ranks, count * sizeof(container_index));
+
+    // Copy every label into one buffer. Keys point into it once it's done growing.
+    size_t length = 0;
+    size_t capacity = 0;
+    for(container_index i = 0; i < count; ++i) {
+        const char* label = NULL;
+        if(m->is_virtual) {
+            label = m->get_label(i, m->label_data);
+        } else {
+            label = ((menu_entry*)array_get(m->entries, i))->str;
+        }
+        if(label == NULL) {
+            label = "";
+        }
+
+        size_t label_length = strlen(label) + 1;
+        if(length + label_length > capacity) {
+            capacity = max(capacity * 2, length + label_length);
+            m->search_strings = srealloc(m->search_strings, capacity);
+        }
+        memcpy(m->search_strings + length, label, label_length);
+
+        m->search_keys[i].label_offset = length;
+        m->search_keys[i].index = i;
+        length += label_length;
+    }
+
+    for(container_index i = 0; i < count; ++i) {
+        m->search_keys[i].label = m->search_strings + m->search_keys[i].label_offset;
+    }
+
+    qsort(m->search_keys, count, sizeof(menu_search_key), compare_search_keys);
+    for(container_index i = 0; i < count; ++i) {
+        m->search_ranks[m->search_keys[i].index] = i;
+    }
+}
+
+// Finds the first key in [first, end) whose label's first length characters compare at least (or above, if upper) prefix
+static container_index menu_search_bound(menu m, container_index first, container_index end, const char* prefix, uint8 length, bool upper) {
+    while(first < end) {
+        container_index mid = first + (end - first) / 2;
+        int result = strncasecmp(m->search_keys[mid].label, prefix, length);
+        if(result < 0 || (upper && result == 0)) {
+            first = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+
+    return first;
+}
+
+container_index menu_search_type(menu m, char c) {
+    check_return(m != NULL, "Menu is NULL", CONTAINER_INDEX_INVALID);
+
+    menu_build_search(m);
+    if(m->search_length >= MENU_SEARCH_MAX) {
+        return CONTAINER_INDEX_INVALID;
+    }
+
+    // Labels starting with the longer prefix are a subrange of those starting with the current one
+    char prefix[MENU_SEARCH_MAX + 1];
+    memcpy(prefix, m->search_prefix, m->search_length);
+    prefix[m->search_length] = c;
+    uint8 length = m->search_length + 1;
+
+    container_index first = menu_search_bound(m, m->search_first, m->search_end, prefix, length, false);
+    container_index end = menu_search_bound(m, first, m->search_end, prefix, length, true);
+    if(first == end) {
+        return CONTAINER_INDEX_INVALID;
+    }
+
+    memcpy(m->search_prefix, prefix, length);
+    m->search_prefix[length] = '\0';
+    m->search_length = length;
+    m->search_first = first;
+    m->search_end = end;
+
+    return menu_set_cursor(m, m->search_keys[first].index);
+}
+
+void menu_search_reset(menu m) {
+    check_return(m != NULL, "Menu is NULL", );
+
+    m->search_length = 0;
+    m->search_prefix[0] = '\0';
+    m->search_first = 0;
+    m->search_end = m->search_count;
+}
+
+container_index menu_jump_to_letter(menu m, char c) {
+    check_return(m != NULL, "Menu is NULL", CONTAINER_INDEX_INVALID);
+
+    menu_build_search(m);
+
+    container_index first = menu_search_bound(m, 0, m->search_count, &c, 1, false);
+    container_index end = menu_search_bound(m, first, m->search_count, &c, 1, true);
+    if(first == end) {
+        return CONTAINER_INDEX_INVALID;
+    }
+
+    // Move to the label after the cursor's in sorted order, if the cursor is already on this letter
+    container_index rank = first;
+    if(m->cursor < m->search_count) {
+        container_index cursor_rank = m->search_ranks[m->cursor];
+        if(cursor_rank >= first && cursor_rank < end) {
+            rank = cursor_rank + 1 < end ? cursor_rank + 1 : first;
+        }
+    }
+
+    return menu_set_cursor(m, m->search_keys[rank].index);
+}
+
+void menu_invalidate_search(menu m) {
+    check_return(m != NULL, "Menu is NULL", );
+
+    sfree(m->search_keys);
+    sfree(m->search_ranks);
+    sfree(m->search_strings);
+    m->search_keys = NULL;
+    m->search_ranks = NULL;
+    m->search_strings = NULL;
+    m->search_count = 0;
+    m->search_valid = false;
+    menu_search_reset(m);
+}
+// Estimates the memory used by a menu, counting a quad for each character of its labels
+static size_t menu_estimate_size(menu m) {
+    size_t size = sizeof(struct menu) + m->draw_capacity * sizeof(vt_pt) + m->row_capacity * sizeof(uint32);
+    if(m->is_virtual) {
+        return size + m->viewport_size * (sizeof(text) + sizeof(container_index));
+    }
+
+    array_foreach(m->entries, iter) {
+        menu_entry* entry = iter.data;
+        size += sizeof(menu_entry);
+        if(entry->str != NULL) {
+            size += strlen(entry->str) * 6 * sizeof(vt_pt);
+        }
+    }
+
+    return size;
+}
+
+// Checks whether m is active, or a parent of active
+static bool menu_is_open(menu m, menu active) {
+    for(menu p = active; p != NULL; p = p->parent) {
+        if(p == m) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Frees the texts and vertices of a lazily built submenu. The menu itself stays alive, so pointers to it stay valid.
+static void menu_evict(menu m) {
+    array_foreach(m->entries, iter) {
+        menu_entry* entry = iter.data;
+        if(entry->label != NULL) {
+            text_free(entry->label, false);
+            entry->label = NULL;
+        }
+    }
+
+    menu_invalidate_search(m);
+    sfree(m->draw_verts);
+    sfree(m->row_starts);
+    m->draw_verts = NULL;
+    m->row_starts = NULL;
+    m->draw_count = m->draw_capacity = 0;
+    m->row_count = m->row_capacity = 0;
+    ui_buffer_cleanup(&m->draw_buffer);
+    ui_buffer_init(&m->draw_buffer);
+
+    m->lazy_cache->used -= m->lazy_size;
+    m->lazy_size = 0;
+    m->is_evicted = true;
+    m->is_damaged = true;
+}
+
+// Evicts the least recently used submenus until the cache fits its budget, keeping the ones that are open
+static void menu_lazy_cache_evict(struct menu_lazy_cache* c, menu active) {
+    while(c->budget != 0 && c->used > c->budget) {
+        menu oldest = NULL;
+        for(uint32 i = 0; i < c->count; ++i) {
+            menu candidate = c->menus[i];
+            if(candidate->is_evicted || menu_is_open(candidate, active)) {
+                continue;
+            }
+            if(oldest == NULL || candidate->last_used < oldest->last_used) {
+                oldest = candidate;
+            }
+        }
+
+        if(oldest == NULL) {
+            return;
+        }
+        menu_evict(oldest);
+    }
+}
+
+// Marks a lazily built submenu as the most recently used, recreating its texts if it was evicted
+static void menu_lazy_touch(menu sub) {
+    struct menu_lazy_cache* c = sub->lazy_cache;
+
+    if(sub->is_evicted) {
+        array_foreach(sub->entries, iter) {
+            menu_entry* entry = iter.data;
+            if(entry->label == NULL) {
+                entry->label = menu_new_label(sub, entry->str);
+            }
+        }
+        sub->is_evicted = false;
+    }
+
+    // Submenus can grow after they're built, so their size is refreshed whenever they're opened
+    size_t size = menu_estimate_size(sub);
+    c->used = c->used - sub->lazy_size + size;
+    sub->lazy_size = size;
+    sub->last_used = ++c->tick;
+    menu_lazy_cache_evict(c, sub);
+}
+
+// Gets an entry's submenu, building it if needed, and marks it as the most recently used
+static menu menu_open_submenu(menu m, menu_entry* entry) {
+    if(entry->build == NULL) {
+        return entry->submenu;
+    }
+
+    menu sub = entry->submenu;
+    struct menu_lazy_cache* c = m->lazy_cache;
+    if(sub == NULL) {
+        sub = m->fnt != NULL ? menu_new(m->fnt) : menu_new_with_glyphs(m->glyphs);
+        sub->parent = m;
+        sub->lazy_cache = c;
+        entry->submenu = sub;
+        entry->owns_submenu = true;
+        entry->build(sub, entry->build_data);
+
+        if(c != NULL) {
+            if(c->count == c->capacity) {
+                c->capacity = max(c->capacity * 2, 8);
+                c->menus = srealloc(c->menus, c->capacity * sizeof(menu));
+            }
+            c->menus[c->count++] = sub;
+        }
+    }
+
+    if(c != NULL) {
+        menu_lazy_touch(sub);
+    }
+
+    return sub;
+}
+
 menu menu_activate(menu m) {
     check_return(m != NULL, "Menu is NULL", NULL);
 
@@ -81,6 +843,15 @@ menu menu_activate(menu m) {
         return NULL;
     }
 
+    if(m->is_virtual)
+    {
+        if(m->cursor < m->virtual_count)
+        {
+            call_event(m->virtual_activate, m);
+        }
+        return NULL;
+    }
+
     menu_entry* entry = array_get(m->entries, m->cursor);
 
     if(entry == NULL)
@@ -88,61 +859,366 @@ menu menu_activate(menu m) {
         return NULL;
     }
 
+    // Lazy submenus are built before the event, so that it can see them
+    if(entry->build != NULL) {
+        menu submenu = menu_open_submenu(m, entry);
+        call_event(entry->activate, m);
+        return submenu;
+    }
+
     call_event(entry->activate, m);
 
     return entry->submenu;
 }
+
+menu menu_get_submenu(menu m, container_index index) {
+    check_return(m != NULL, "Menu is NULL", NULL);
+
+    menu_entry* entry = menu_get_entry(m, index);
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    return menu_open_submenu(m, entry);
+}
+
+void menu_set_lazy_budget(menu m, size_t budget) {
+    check_return(m != NULL, "Menu is NULL", );
+
+    if(m->lazy_cache == NULL) {
+        m->lazy_cache = mscalloc(1, struct menu_lazy_cache);
+        m->owns_lazy_cache = true;
+    }
+    m->lazy_cache->budget = budget;
+}
+
+size_t menu_get_lazy_usage(menu m) {
+    check_return(m != NULL, "Menu is NULL", 0);
+
+    return m->lazy_cache != NULL ? m->lazy_cache->used : 0;
+}
+
 menu_entry* menu_get_entry(menu m, container_index index) {
+    check_return(m != NULL, "Menu is NULL", NULL);
+
+    if(m->is_virtual) {
+        return NULL;
+    }
+
     return array_get(m->entries, index);
 }
 
 void menu_clear(menu m) {
     check_return(m != NULL, "Menu is NULL", );
 
+    if(m->is_virtual) {
+        menu_set_entry_count(m, 0);
+        m->cursor = 0;
+        return;
+    }
+
     array_foreach(m->entries, iter) {
-        menu_entry* entry = iter.data;
-        text_free(entry->label, false);
+        menu_release_entry(iter.data);
         array_remove_iter(m->entries, &iter);
     }
 
     m->cursor = 0;
+    m->dims = vec2_zero;
+    m->dims_count_x = m->dims_count_y = 0;
+    m->dims_valid = true;
+    menu_invalidate_search(m);
+    m->is_damaged = true;
+}
+
+// Draws a label at the position of row in the menu
+static void menu_draw_label(menu m, text label, container_index row, shader s, mat4 vp) {
+    vec3 vec = vec3_zero;
+    vec = vec_mul(m->offset, row);
+    vec.y += m->line_height * row;
+
+    text_draw(label, s, mat4_mul(vp, mat4_translate(mat4_ident, vec)));
 }
 
 void menu_draw_entry(menu m, array_iter iter, shader s, mat4 vp) {
-    menu_entry* entry = iter.data;
+    if(m->is_evicted) {
+        menu_lazy_touch(m);
+    }
 
-    vec3 vec = vec3_zero;
-    vec = vec_mul(m->offset, iter.index);
-    vec.y += font_get_height(m->fnt) * iter.index;
+    menu_entry* entry = iter.data;
+    check_return(entry->label != NULL, "Entries of menus without a font can only be drawn with menu_draw", );
 
-    text_draw(entry->label, s, mat4_mul(vp, mat4_translate(mat4_ident, vec)));
+    menu_draw_label(m, entry->label, iter.index, s, vp);
 }
 
-vec2 menu_calculate_dims(menu m) {
-    vec2 bounds = vec2_zero;
-    float height = font_get_height(m->fnt);
+void menu_set_label_align(menu m, alignment_2d align) {
+    check_return(m != NULL, "Menu is NULL", );
+    check_return(align <= ALIGN_LAST, "Invalid label alignment 0x%x", , align);
+
+    m->label_align = align;
+    m->is_damaged = true;
+
+    if(m->is_virtual) {
+        for(uint16 i = 0; i < m->viewport_size; ++i) {
+            if(m->window_texts[i] != NULL) {
+                text_set_align(m->window_texts[i], align);
+            }
+        }
+        return;
+    }
 
     array_foreach(m->entries, iter) {
         menu_entry* entry = iter.data;
+        if(entry->label != NULL) {
+            text_set_align(entry->label, align);
+        }
+    }
+}
+
+void menu_set_cursor_highlight(menu m, bool enabled, aabb_2d uv_box) {
+    check_return(m != NULL, "Menu is NULL", );
+
+    m->highlight_cursor = enabled;
+    m->highlight_uv = uv_box;
+    m->is_damaged = true;
+}
 
-        vec2 t_bounds = text_get_bounds(entry->label);
-        t_bounds.x += iter.index * m->offset.x;
-        t_bounds.y += iter.index * (m->offset.y + height);
+// Makes room for count more vertices in the menu's vertex stream
+static void menu_reserve_vertices(menu m, uint32 count) {
+    if(m->draw_count + count > m->draw_capacity) {
+        uint32 capacity = m->draw_capacity == 0 ? 256 : m->draw_capacity;
+        while(capacity < m->draw_count + count) {
+            capacity *= 2;
+        }
 
-        bounds.x = max(bounds.x, t_bounds.x);
-        bounds.y = max(bounds.y, t_bounds.y);
+        m->draw_verts = srealloc(m->draw_verts, capacity * sizeof(vt_pt));
+        m->draw_capacity = capacity;
     }
+}
 
-    return bounds;
+// Converts a box in font atlas pixels to texture coordinates
+static aabb_2d menu_get_atlas_uv(vec2 atlas, aabb_2d box) {
+    return (aabb_2d) {
+        .position = { .x = box.position.x / atlas.x, .y = box.position.y / atlas.y },
+        .dimensions = { .x = box.dimensions.x / atlas.x, .y = box.dimensions.y / atlas.y }
+    };
 }
 
-void menu_free(menu m) {
+// Appends the glyphs of str to the menu's vertex stream. The label's alignment point is placed at origin.
+static void menu_build_label(menu m, const char* str, vec2 bounds, vec2 origin, vec2 atlas) {
+    if(str == NULL) {
+        return;
+    }
+
+    aabb_2d label_box = { .position = vec2_zero, .dimensions = bounds };
+    vec2 corner = vec2_sub(origin, aabb_get_origin_2d(label_box, m->label_align));
+
+    float height = m->line_height;
+    vec2 pen = corner;
+    pen.y += height;
+
+    for(const char* c = str; *c != '\0'; ++c) {
+        if(*c == '\n') {
+            pen.x = corner.x;
+            pen.y += height;
+            continue;
+        }
+
+        menu_glyph g;
+        if(!m->glyphs.get_glyph(m->glyphs.data, (unsigned char)*c, &g)) {
+            continue;
+        }
+
+        // Whitespace has no quad, but still advances
+        if(!eq0(g.texture_bounds.dimensions.x) && !eq0(g.texture_bounds.dimensions.y)) {
+            aabb_2d box = {
+                .position = { .x = pen.x + g.bearing.x, .y = pen.y - g.bearing.y },
+                .dimensions = g.texture_bounds.dimensions
+            };
+
+            menu_reserve_vertices(m, 6);
+            build_box(m->draw_verts + m->draw_count, box, menu_get_atlas_uv(atlas, g.texture_bounds));
+            m->draw_count += 6;
+        }
+
+        pen.x += g.advance;
+    }
+}
+
+// Gets the local box covering the row an entry is drawn in, which is where the cursor highlight goes.
+// It's aligned to the entry's offset the same way the entry's label is.
+static aabb_2d menu_get_row_box(menu m, container_index index, vec2 dims) {
+    aabb_2d row = { .position = vec2_zero, .dimensions = { .x = dims.x, .y = m->line_height } };
+    row.position = vec2_sub(menu_get_entry_offset(m, index), aabb_get_origin_2d(row, m->label_align));
+    return row;
+}
+
+uint32 menu_build_vertices(menu m) {
+    check_return(m != NULL, "Menu is NULL", 0);
+
+    vec2 atlas = m->glyphs.get_atlas_size(m->glyphs.data);
+    check_return(atlas.x > 0 && atlas.y > 0, "Glyph atlas dimensions are invalid", 0);
+
+    ui_stat_time_begin(UI_STAT_TIME_MENU_BUILD);
+
+    m->draw_count = 0;
+    m->first_row = m->is_virtual ? m->window_start : 0;
+    m->row_count = m->is_virtual ? menu_get_window_length(m) : array_get_length(m->entries);
+    if(m->row_count > m->row_capacity) {
+        m->row_starts = srealloc(m->row_starts, m->row_count * sizeof(uint32));
+        m->row_capacity = m->row_count;
+    }
+
+    // The highlight goes first, so that it's drawn behind the labels
+    if(m->highlight_cursor && m->cursor != CONTAINER_INDEX_INVALID && m->cursor >= m->first_row && m->cursor - m->first_row < m->row_count) {
+        aabb_2d box = menu_get_row_box(m, m->cursor, menu_calculate_dims(m));
+
+        menu_reserve_vertices(m, 6);
+        build_box(m->draw_verts + m->draw_count, box, menu_get_atlas_uv(atlas, m->highlight_uv));
+        m->draw_count += 6;
+    }
+
+    for(container_index i = 0; i < m->row_count; ++i) {
+        container_index index = m->first_row + i;
+        m->row_starts[i] = m->draw_count;
+
+        // Virtual menus get labels straight from the callback, since they don't need text objects to draw
+        const char* label = NULL;
+        vec2 bounds = vec2_zero;
+        if(m->is_virtual) {
+            label = m->get_label(index, m->label_data);
+            bounds = menu_measure_label(m, label);
+        } else {
+            menu_entry* entry = array_get(m->entries, index);
+            label = entry->str;
+            bounds = entry->label_bounds;
+        }
+
+        menu_build_label(m, label, bounds, menu_get_entry_offset(m, index), atlas);
+    }
+
+    ui_stat_time_end(UI_STAT_TIME_MENU_BUILD);
+
+    return m->draw_count;
+}
+
+const vt_pt* menu_get_vertices(menu m, uint32* count) {
+    check_return(m != NULL, "Menu is NULL", NULL);
+
+    if(count != NULL) {
+        *count = m->draw_count;
+    }
+
+    return m->draw_verts;
+}
+
+uint32 menu_get_entry_vertex_start(menu m, container_index index) {
+    check_return(m != NULL, "Menu is NULL", MENU_VERTEX_NONE);
+
+    if(index < m->first_row || index - m->first_row >= m->row_count) {
+        return MENU_VERTEX_NONE;
+    }
+
+    return m->row_starts[index - m->first_row];
+}
+
+vec2 menu_get_entry_offset(menu m, container_index index) {
+    check_return(m != NULL, "Menu is NULL", vec2_zero);
+
+    // Virtual menus draw their window from the top of the menu
+    container_index row = index;
+    if(m->is_virtual) {
+        row = index - m->window_start;
+    }
+
+    return (vec2) {
+        .x = m->offset.x * row,
+        .y = m->offset.y * row + m->line_height * row
+    };
+}
+
+void menu_draw(menu m, shader s, mat4 vp) {
     check_return(m != NULL, "Menu is NULL", );
+    check_return(m->fnt != NULL, "Menus without a font have no texture to draw with", );
 
-    array_foreach(m->entries, iter) {
-        menu_entry* entry = iter.data;
-        text_free(entry->label, false);
+    uint32 count = menu_build_vertices(m);
+    if(count == 0) {
+        return;
     }
-    array_free(m->entries);
+
+    glUseProgram(s.id);
+
+    shader_bind_uniform_name(s, "u_transform", vp);
+    shader_bind_uniform_texture_name(s, "u_texture", font_get_texture(m->fnt), GL_TEXTURE0);
+    vec2 v0 = vec2_zero;
+    vec2 v1 = (vec2){.x=1,.y=1};
+    shader_bind_uniform_name(s, "uv_offset", v0);
+    shader_bind_uniform_name(s, "uv_scale", v1);
+
+    ui_buffer_upload(&m->draw_buffer, m->draw_verts, count);
+    ui_buffer_render(&m->draw_buffer, s, count);
+}
+
+vec2 menu_calculate_dims(menu m) {
+    check_return(m != NULL, "Menu is NULL", vec2_zero);
+
+    if(m->is_virtual) {
+        // Only the visible window has labels to measure
+        vec2 bounds = vec2_zero;
+        container_index length = menu_get_window_length(m);
+        for(container_index i = 0; i < length; ++i) {
+            vec2 extent = menu_get_entry_extent(m, text_get_bounds(menu_get_label(m, m->window_start + i)), i);
+            bounds.x = max(bounds.x, extent.x);
+            bounds.y = max(bounds.y, extent.y);
+        }
+
+        return bounds;
+    }
+
+    if(!m->dims_valid) {
+        menu_recalculate_dims(m);
+    }
+
+    return m->dims;
+}
+
+void menu_invalidate_dims(menu m) {
+    check_return(m != NULL, "Menu is NULL", );
+
+    m->dims_valid = false;
+    m->is_damaged = true;
+}
+
+void menu_report_damage(menu m, ui_damage d, mat4 mat) {
+    check_return(m != NULL, "Menu is NULL", );
+    check_return(d != NULL, "Damage tracker is NULL", );
+
+    vec2 dims = menu_calculate_dims(m);
+    aabb_2d bounds = ui_damage_transform((aabb_2d){ .position = vec2_zero, .dimensions = dims }, mat);
+    bool moved = bounds.position.x != m->damage_bounds.position.x || bounds.position.y != m->damage_bounds.position.y ||
+                 bounds.dimensions.x != m->damage_bounds.dimensions.x || bounds.dimensions.y != m->damage_bounds.dimensions.y;
+
+    if(m->is_damaged || moved) {
+        ui_damage_add(d, m->damage_bounds);
+        ui_damage_add(d, bounds);
+    } else if(m->cursor != m->damage_cursor) {
+        if(m->damage_cursor != CONTAINER_INDEX_INVALID) {
+            ui_damage_add(d, ui_damage_transform(menu_get_row_box(m, m->damage_cursor, dims), mat));
+        }
+        if(m->cursor != CONTAINER_INDEX_INVALID) {
+            ui_damage_add(d, ui_damage_transform(menu_get_row_box(m, m->cursor, dims), mat));
+        }
+    }
+
+    m->damage_bounds = bounds;
+    m->damage_cursor = m->cursor;
+    m->is_damaged = false;
+}
+
+void menu_free(menu m) {
+    check_return(m != NULL, "Menu is NULL", );
+    check_return(!m->in_arena, "Menus created in an arena are released with the arena", );
+    check_return(m->parent == NULL, "Lazily built submenus are freed with their parent", );
+
+    menu_release(m);
     sfree(m);
 }
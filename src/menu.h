@@ -1,30 +1,327 @@
 #ifndef DF_UI_MENU
 #define DF_UI_MENU
 #include "core/container/array.h"
+#include "math/alignment.h"
 #include "math/matrix.h"
 #include "graphics/shader.h"
 #include "graphics/text.h"
 
+#include "ui_arena.h"
+#include "ui_buffer.h"
+#include "ui_damage.h"
+
+// Gets the label of entry index in a virtual menu. The returned string is copied, and isn't freed by the menu.
+typedef const char* (*menu_label_func)(container_index index, void* user);
+
+struct menu;
+event(menu_activate_event, struct menu* m);
+
+// Populates a lazily built submenu. The menu is created empty, with its parent's font or glyph source.
+typedef void (*menu_build_func)(struct menu* m, void* user);
+
+// Tracks the lazily built submenus of a menu tree, and evicts them when they take up too much memory
+struct menu_lazy_cache;
+
+// The metrics of a glyph, in font atlas pixels
+typedef struct menu_glyph {
+    aabb_2d texture_bounds;
+    vec2 bearing;
+    float advance;
+} menu_glyph;
+
+// Provides the glyphs that menu vertices are built from. Menus created with a font use the font's glyphs,
+// while other sources let menus be built and measured without a font or a GL context.
+typedef struct menu_glyph_source {
+    // Fills g with the metrics of character c. Returns false if there's no glyph for it.
+    bool (*get_glyph)(void* data, uint32 c, menu_glyph* g);
+    // Gets the size of the atlas that texture bounds are in, in pixels
+    vec2 (*get_atlas_size)(void* data);
+    float line_height;
+    void* data;
+} menu_glyph_source;
+
+// Returned by menu_get_entry_vertex_start for entries that weren't built
+#define MENU_VERTEX_NONE 0xFFFFFFFF
+
+// The longest prefix that type-to-search will match
+#define MENU_SEARCH_MAX 31
+
+// Entries moved per page by menu_move_page, for non-virtual menus without a page size
+#define MENU_DEFAULT_PAGE_SIZE 10
+
+// A label in a menu's search index
+typedef struct menu_search_key {
+    const char* label;
+    // Where the label starts in search_strings, since the buffer can move while it's being filled
+    uint32 label_offset;
+    container_index index;
+} menu_search_key;
+
 typedef struct menu {
     container_index cursor;
     array entries;
+    // NULL for menus created with menu_new_with_glyphs, whose entries have no text
     font fnt;
+    menu_glyph_source glyphs;
+    // The line height, cached since it's needed for every entry's position
+    float line_height;
+    // The point of each label that's placed at its row's offset
+    alignment_2d label_align;
     vec3 offset;
     bool can_wrap;
-}* menu;
 
-event(menu_activate_event, menu m);
+    // Cached result of menu_calculate_dims. This is kept up to date as entries change, along with the
+    // number of entries whose extent reaches each edge. It's only recalculated from every entry's cached
+    // label bounds when the last entry at an edge shrinks, moves up or is removed.
+    vec2 dims;
+    container_index dims_count_x;
+    container_index dims_count_y;
+    bool dims_valid;
+
+    // Vertex stream used by menu_draw, holding every drawn row's glyphs with the row's offset applied.
+    // Row i (entry first_row + i) starts at draw_verts[row_starts[i]].
+    vt_pt* draw_verts;
+    uint32 draw_count;
+    uint32 draw_capacity;
+    uint32* row_starts;
+    container_index row_count;
+    container_index row_capacity;
+    container_index first_row;
+    ui_buffer draw_buffer;
+
+    // If set, a quad textured with highlight_uv (in font atlas pixels) is drawn behind the cursor's row
+    bool highlight_cursor;
+    aabb_2d highlight_uv;
+
+    // Virtual menus have no entries array. Instead, labels are fetched on demand
+    // and only the entries in a window around the cursor have text.
+    bool is_virtual;
+    container_index virtual_count;
+    menu_label_func get_label;
+    void* label_data;
+    menu_activate_event* virtual_activate;
+
+    // The visible window of a virtual menu. Texts are recycled as it scrolls,
+    // with entry i stored in slot i % viewport_size.
+    uint16 viewport_size;
+    container_index window_start;
+    text* window_texts;
+    container_index* window_indices;
+
+    // Set for menus created with menu_new_in, which are released with their arena
+    bool in_arena;
+
+    // The number of entries menu_move_page moves by. If 0, virtual menus use their
+    // viewport size and other menus use MENU_DEFAULT_PAGE_SIZE.
+    uint16 page_size;
+
+    // Every label sorted case-insensitively, built on the first search after entries change.
+    // search_ranks maps an entry's index to its position in search_keys.
+    menu_search_key* search_keys;
+    container_index* search_ranks;
+    char* search_strings;
+    container_index search_count;
+    bool search_valid;
+
+    // The text typed so far, and the range of search_keys that starts with it
+    char search_prefix[MENU_SEARCH_MAX + 1];
+    uint8 search_length;
+    container_index search_first;
+    container_index search_end;
+
+    // Lazily built submenus share their root's cache, and keep their parent so it isn't evicted while they're open
+    struct menu_lazy_cache* lazy_cache;
+    bool owns_lazy_cache;
+    struct menu* parent;
+    uint64 last_used;
+    size_t lazy_size;
+    // Set when the cache has freed the menu's texts and vertices, until it's next opened
+    bool is_evicted;
+
+    // Set when anything besides the cursor changes, until it's reported to a damage tracker
+    bool is_damaged;
+    // The cursor and screen bounds last reported to a damage tracker
+    container_index damage_cursor;
+    aabb_2d damage_bounds;
+}* menu;
 
 typedef struct menu_entry {
+    // The label's text, which is NULL in menus without a font
     text label;
+    // The label's string, kept so that labels can be built, measured and searched without their text
+    char* str;
+    vec2 label_bounds;
     menu submenu;
     menu_activate_event* activate;
+
+    // If set, submenu is built by calling build the first time the entry is activated.
+    // Such submenus are owned by this menu, and freed with it.
+    menu_build_func build;
+    void* build_data;
+    bool owns_submenu;
 } menu_entry;
 
 menu menu_new(font fnt);
+
+/** @brief Create a menu that builds its labels from a glyph source instead of a font
+ *
+ * The menu's entries have no text objects, so they can't be drawn individually with menu_draw_entry,
+ * but the menu can be built, measured and navigated without a GL context.
+ *
+ * @param glyphs Provides the glyph metrics and atlas size for the menu's labels
+ */
+menu menu_new_with_glyphs(menu_glyph_source glyphs);
+
+/** @brief Create a menu in an arena. It's released along with the arena, and must not be freed with menu_free.
+ *
+ * @param a The arena to create the menu in
+ * @param fnt The font to draw labels with
+ */
+menu menu_new_in(ui_arena a, font fnt);
+
+/** @brief Create a menu in an arena that builds its labels from a glyph source, like menu_new_with_glyphs
+ *
+ * @param a The arena to create the menu in
+ * @param glyphs Provides the glyph metrics and atlas size for the menu's labels
+ */
+menu menu_new_in_with_glyphs(ui_arena a, menu_glyph_source glyphs);
+
+/** @brief Create a virtual menu, which builds labels only for the visible entries
+ *
+ * @param fnt The font to draw labels with
+ * @param count The number of entries in the menu
+ * @param viewport_size The number of entries that are visible at once
+ * @param get_label Callback that provides the label of an entry
+ * @param user Data passed to get_label
+ * @param event Event called when any entry is activated
+ */
+menu menu_new_virtual(font fnt, container_index count, uint16 viewport_size, menu_label_func get_label, void* user, menu_activate_event* event);
+
+/** @brief Change the number of entries in a virtual menu, discarding any cached labels
+ *
+ * @param m The menu
+ * @param count The new number of entries
+ */
+void menu_set_entry_count(menu m, container_index count);
+container_index menu_get_entry_count(menu m);
+
+/** @brief Get the label of an entry, if it's visible
+ *
+ * @param m The menu
+ * @param index The entry index
+ * @return The entry's label, or NULL if it's outside of a virtual menu's visible window
+ */
+text menu_get_label(menu m, container_index index);
+
 container_index menu_add_entry(menu m, const char* label, menu submenu, menu_activate_event* event);
+
+/** @brief Add an entry whose submenu is only built when it's first activated
+ *
+ * @param m The menu
+ * @param label The entry's label
+ * @param build Callback that populates the submenu
+ * @param user Data passed to build
+ * @param event Event called when the entry is activated, after the submenu is built
+ */
+container_index menu_add_lazy_entry(menu m, const char* label, menu_build_func build, void* user, menu_activate_event* event);
+
+/** @brief Get the submenu of an entry, building it if it's lazy and hasn't been built yet
+ *
+ * @param m The menu
+ * @param index The entry index
+ */
+menu menu_get_submenu(menu m, container_index index);
+
+/** @brief Limit the memory used by the lazily built submenus below this menu
+ *
+ * When a lazy submenu is opened and the estimated size of every built lazy submenu in the tree exceeds the budget,
+ * the label texts and draw buffers of the least recently activated ones are freed. The submenus themselves,
+ * along with their entries and label strings, stay alive, so pointers to them stay valid. Their texts are
+ * recreated when they're activated again or their labels are requested.
+ * The most recently activated submenu and its parents are never evicted. Texts previously returned by
+ * menu_get_label for an evicted submenu become invalid.
+ *
+ * @param m The root menu of the tree
+ * @param budget The budget in bytes, or 0 to never evict
+ */
+void menu_set_lazy_budget(menu m, size_t budget);
+
+/** @brief Get the estimated memory used by the built lazy submenus below this menu
+ *
+ * @param m The root menu of the tree
+ */
+size_t menu_get_lazy_usage(menu m);
+/** @brief Change the label of an entry
+ *
+ * @param m The menu
+ * @param index The entry to change
+ * @param label The new label text
+ */
+void menu_set_entry_label(menu m, container_index index, const char* label);
+
+/** @brief Remove an entry from the menu. Entries after it move up to fill the gap.
+ *
+ * @param m The menu
+ * @param index The entry to remove
+ */
+void menu_remove_entry(menu m, container_index index);
+
+/** @brief Set the offset applied to each successive entry
+ *
+ * @param m The menu
+ * @param offset The offset, in addition to the font's line height
+ */
+void menu_set_offset(menu m, vec3 offset);
+
 container_index menu_set_cursor(menu m, container_index index);
 container_index menu_move_cursor(menu m, int16 offset);
+
+/** @brief Move the cursor by whole pages. This stops at the first and last entries instead of wrapping.
+ *
+ * @param m The menu
+ * @param pages The number of pages to move, negative to move up
+ * @return The new cursor position
+ */
+container_index menu_move_page(menu m, int16 pages);
+
+/** @brief Set the number of entries menu_move_page moves by
+ *
+ * @param m The menu
+ * @param size The page size, or 0 to use the default
+ */
+void menu_set_page_size(menu m, uint16 size);
+
+/** @brief Add a character to the type-to-search prefix, and move the cursor to the first label that starts with it
+ *
+ * Matching is case-insensitive and uses a sorted index of the labels, so each keypress is a binary search.
+ * Virtual menus fetch every label once to build the index.
+ *
+ * @param m The menu
+ * @param c The typed character
+ * @return The matching entry, or CONTAINER_INDEX_INVALID if no label starts with the extended prefix.
+ * The prefix is left unchanged when nothing matches.
+ */
+container_index menu_search_type(menu m, char c);
+
+/** @brief Clear the type-to-search prefix, so that the next search starts over
+ *
+ * @param m The menu
+ */
+void menu_search_reset(menu m);
+
+/** @brief Move the cursor to the next label that starts with a letter, cycling through them on repeated calls
+ *
+ * @param m The menu
+ * @param c The letter
+ * @return The matching entry, or CONTAINER_INDEX_INVALID if no label starts with c
+ */
+container_index menu_jump_to_letter(menu m, char c);
+
+/** @brief Discard the search index. Only needed when a virtual menu's label callback starts returning different labels.
+ *
+ * @param m The menu
+ */
+void menu_invalidate_search(menu m);
 menu menu_activate(menu m);
 menu_entry* menu_get_entry(menu m, container_index index);
 
@@ -35,8 +332,90 @@ menu_entry* menu_get_entry(menu m, container_index index);
 void menu_clear(menu m);
 
 void menu_draw_entry(menu m, array_iter entry, shader s, mat4 vp);
+
+/** @brief Set whether a highlight is drawn behind the cursor's row
+ *
+ * @param m The menu
+ * @param enabled Whether to draw the highlight
+ * @param uv_box The region of the font atlas to draw the highlight with, in pixels. This should be a solid area.
+ */
+void menu_set_cursor_highlight(menu m, bool enabled, aabb_2d uv_box);
+
+/** @brief Set the point of each label that's placed at its row's offset
+ *
+ * @param m The menu
+ * @param align The alignment, which also applies to the labels' texts
+ */
+void menu_set_label_align(menu m, alignment_2d align);
+
+/** @brief Build the vertices for every visible entry into the menu's vertex stream
+ *
+ * Glyphs come from the menu's glyph source. This doesn't touch GL, so menus created with
+ * menu_new_with_glyphs can be built without a context.
+ *
+ * @param m The menu
+ * @return The number of vertices built
+ */
+uint32 menu_build_vertices(menu m);
+
+/** @brief Get the vertices built by menu_build_vertices
+ *
+ * @param m The menu
+ * @param count Set to the number of vertices, if non-NULL
+ */
+const vt_pt* menu_get_vertices(menu m, uint32* count);
+
+/** @brief Get where an entry's vertices start in the vertex stream
+ *
+ * @param m The menu
+ * @param index The entry index
+ * @return The index of the entry's first vertex, or MENU_VERTEX_NONE if it wasn't built
+ */
+uint32 menu_get_entry_vertex_start(menu m, container_index index);
+
+/** @brief Get the offset applied to an entry's vertices
+ *
+ * @param m The menu
+ * @param index The entry index
+ */
+vec2 menu_get_entry_offset(menu m, container_index index);
+
+/** @brief Draw every visible entry in the menu with a single draw call
+ *
+ * @param m The menu
+ * @param s The shader to draw with
+ * @param vp The view-projection matrix
+ */
+void menu_draw(menu m, shader s, mat4 vp);
+
+/** @brief Get the dimensions of the menu's entries
+ *
+ * For normal menus this is cached and maintained as entries change, so it's cheap to call every frame.
+ * Queries are O(1), with the cost paid as entries change: adding an entry is O(1), and removing one adjusts the
+ * entries after it in O(n - index). Relabeling or removing the last entry at the widest or tallest extent
+ * recalculates every entry, in O(n), which removals often do since the last entry is usually the tallest.
+ * Virtual menus measure their visible window.
+ * If the offset field is changed directly instead of with menu_set_offset, menu_invalidate_dims must be called.
+ */
 vec2 menu_calculate_dims(menu m);
 
+/** @brief Force the menu's cached dimensions to be recalculated on the next query
+ *
+ * @param m The menu
+ */
+void menu_invalidate_dims(menu m);
+
+/** @brief Report the menu's damage to a damage tracker
+ *
+ * If only the cursor moved, just the rows it left and entered are damaged.
+ * Any other change, or moving the menu, damages its old and new bounds.
+ *
+ * @param m The menu
+ * @param d The damage tracker
+ * @param mat The transform the menu is drawn with
+ */
+void menu_report_damage(menu m, ui_damage d, mat4 mat);
+
 void menu_free(menu m);
 
 #endif
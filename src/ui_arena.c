@@ -0,0 +1,142 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "ui_arena.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+
+#include <string.h>
+
+#define ARENA_HEADER_SIZE ui_arena_size(sizeof(ui_arena_block))
+
+// Create an arena that allocates memory in blocks of block_size bytes
+ui_arena ui_arena_new(size_t block_size) {
+    check_return(block_size != 0, "Arena blocks can't be empty", NULL);
+
+    ui_arena a = mscalloc(1, struct ui_arena);
+    a->blocks = NULL;
+    a->current = NULL;
+    a->block_size = block_size;
+    a->cleanups = NULL;
+
+    return a;
+}
+
+static void run_cleanups(ui_arena a) {
+    // Cleanups live in the arena's blocks, which stay valid until after they've all run
+    for(ui_arena_cleanup* c = a->cleanups; c != NULL; c = c->next) {
+        c->func(c->data);
+    }
+    a->cleanups = NULL;
+}
+
+// Runs the arena's cleanups, and frees it and all of its memory
+void _ui_arena_free(ui_arena a) {
+    check_return(a != NULL, "Arena is NULL", );
+
+    run_cleanups(a);
+
+    ui_arena_block* block = a->blocks;
+    while(block != NULL) {
+        ui_arena_block* next = block->next;
+        sfree(block);
+        block = next;
+    }
+
+    sfree(a);
+}
+
+// Adds a block with room for at least size bytes after the current one
+static ui_arena_block* add_block(ui_arena a, size_t size) {
+    size_t capacity = max(size, a->block_size);
+    ui_arena_block* block = salloc(ARENA_HEADER_SIZE + capacity);
+    block->capacity = capacity;
+    block->used = 0;
+
+    if(a->current == NULL) {
+        block->next = a->blocks;
+        a->blocks = block;
+    } else {
+        block->next = a->current->next;
+        a->current->next = block;
+    }
+
+    return block;
+}
+
+// Allocate size zeroed bytes from the arena
+void* ui_arena_alloc(ui_arena a, size_t size) {
+    check_return(a != NULL, "Arena is NULL", NULL);
+
+    size = ui_arena_size(size);
+
+    // Blocks after the current one are left over from before a reset, so try them before adding more
+    ui_arena_block* block = a->current;
+    while(block != NULL && block->used + size > block->capacity) {
+        block = block->next;
+        if(block != NULL) {
+            block->used = 0;
+        }
+    }
+    if(block == NULL) {
+        block = add_block(a, size);
+    }
+    a->current = block;
+
+    void* data = (uint8*)block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+    memset(data, 0, size);
+
+    return data;
+}
+
+// Register func to be called with data when the arena is reset or freed
+void ui_arena_defer(ui_arena a, ui_arena_cleanup_func func, void* data) {
+    check_return(a != NULL, "Arena is NULL", );
+    check_return(func != NULL, "Cleanup function is NULL", );
+
+    ui_arena_cleanup* c = ui_arena_mnew(a, ui_arena_cleanup);
+    c->func = func;
+    c->data = data;
+    c->next = a->cleanups;
+    a->cleanups = c;
+}
+
+// Runs the arena's cleanups and releases everything allocated from it, keeping its blocks for reuse
+void ui_arena_reset(ui_arena a) {
+    check_return(a != NULL, "Arena is NULL", );
+
+    run_cleanups(a);
+
+    // Later blocks are cleared as allocation reaches them
+    a->current = a->blocks;
+    if(a->current != NULL) {
+        a->current->used = 0;
+    }
+}
+
+// Get the number of bytes allocated from the arena, and the number of bytes it has reserved
+size_t ui_arena_get_used(ui_arena a) {
+    check_return(a != NULL, "Arena is NULL", 0);
+
+    size_t used = 0;
+    for(ui_arena_block* block = a->blocks; block != NULL; block = block->next) {
+        used += block->used;
+        if(block == a->current) {
+            break;
+        }
+    }
+
+    return used;
+}
+size_t ui_arena_get_capacity(ui_arena a) {
+    check_return(a != NULL, "Arena is NULL", 0);
+
+    size_t capacity = 0;
+    for(ui_arena_block* block = a->blocks; block != NULL; block = block->next) {
+        capacity += block->capacity;
+    }
+
+    return capacity;
+}
@@ -0,0 +1,66 @@
+#ifndef DF_UI_ARENA
+#define DF_UI_ARENA
+
+#include "core/types.h"
+
+#include <stddef.h>
+
+// Allocations are aligned enough for any of the UI's types
+#define UI_ARENA_ALIGN 16
+
+// Gets the arena space an allocation of size bytes takes up, for sizing blocks up front
+#define ui_arena_size(size) (((size) + UI_ARENA_ALIGN - 1) & ~(size_t)(UI_ARENA_ALIGN - 1))
+
+// Releases a resource that lives outside of an arena's memory
+typedef void (*ui_arena_cleanup_func)(void* data);
+
+// A chunk of arena memory. Allocations follow the header.
+typedef struct ui_arena_block {
+    struct ui_arena_block* next;
+    size_t capacity;
+    size_t used;
+} ui_arena_block;
+
+// A cleanup registered with ui_arena_defer. These are allocated in the arena itself.
+typedef struct ui_arena_cleanup {
+    ui_arena_cleanup_func func;
+    void* data;
+    struct ui_arena_cleanup* next;
+} ui_arena_cleanup;
+
+// A bump allocator for everything belonging to one UI screen.
+// Objects created in an arena aren't freed individually. Instead, the whole screen is released at once
+// with ui_arena_reset or ui_arena_free, which also runs the cleanups for resources the arena can't hold
+// (GL buffers, texts and containers owned by dfgame). Reset keeps the blocks, so rebuilding a screen
+// reuses the same memory.
+typedef struct ui_arena {
+    ui_arena_block* blocks;
+    ui_arena_block* current;
+    size_t block_size;
+
+    // Run in reverse order of registration
+    ui_arena_cleanup* cleanups;
+}* ui_arena;
+
+// Create an arena that allocates memory in blocks of block_size bytes. Larger allocations get their own block.
+ui_arena ui_arena_new(size_t block_size);
+
+// Runs the arena's cleanups, and frees it and all of its memory
+#define ui_arena_free(a) { _ui_arena_free(a); a = NULL; }
+void _ui_arena_free(ui_arena a);
+
+// Allocate size zeroed bytes from the arena
+void* ui_arena_alloc(ui_arena a, size_t size);
+#define ui_arena_mnew(a, T) ((T*)ui_arena_alloc(a, sizeof(T)))
+
+// Register func to be called with data when the arena is reset or freed
+void ui_arena_defer(ui_arena a, ui_arena_cleanup_func func, void* data);
+
+// Runs the arena's cleanups and releases everything allocated from it, keeping its blocks for reuse
+void ui_arena_reset(ui_arena a);
+
+// Get the number of bytes allocated from the arena, and the number of bytes it has reserved
+size_t ui_arena_get_used(ui_arena a);
+size_t ui_arena_get_capacity(ui_arena a);
+
+#endif // DF_UI_ARENA
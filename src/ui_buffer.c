@@ -0,0 +1,95 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "ui_buffer.h"
+#include "ui_stats.h"
+
+#include "core/check.h"
+
+#include <stddef.h>
+
+// Initialize a buffer. No GL calls are made until the first upload.
+void ui_buffer_init(ui_buffer* b) {
+    check_return(b != NULL, "Buffer is NULL", );
+
+    b->vao = 0;
+    b->vbo = 0;
+    b->capacity = 0;
+}
+
+// Upload count vertices to the buffer, growing it if needed
+void ui_buffer_upload(ui_buffer* b, const vt_pt* verts, uint32 count) {
+    check_return(b != NULL, "Buffer is NULL", );
+
+    if(b->vbo == 0) {
+        glGenVertexArrays(1, &b->vao);
+        glGenBuffers(1, &b->vbo);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    if(count > b->capacity) {
+        // Grow geometrically, so that streams which slowly grow don't reallocate every frame
+        uint32 capacity = b->capacity == 0 ? 64 : b->capacity;
+        while(capacity < count) {
+            capacity *= 2;
+        }
+
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(vt_pt), NULL, GL_DYNAMIC_DRAW);
+        b->capacity = capacity;
+        ui_stat_add(UI_STAT_BUFFER_ALLOCATIONS, 1);
+    }
+
+    if(count != 0) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(vt_pt), verts);
+        ui_stat_add(UI_STAT_UPLOAD_BYTES, count * sizeof(vt_pt));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Render the first count vertices of the buffer as triangles
+void ui_buffer_render(ui_buffer* b, shader s, uint32 count) {
+    check_return(b != NULL, "Buffer is NULL", );
+    check_return(count <= b->capacity, "Can't render %u vertices from a buffer of %u", , count, b->capacity);
+
+    if(count == 0) {
+        return;
+    }
+
+    GLint pos_loc = glGetAttribLocation(s.id, "i_pos");
+    GLint uv_loc = glGetAttribLocation(s.id, "i_uv");
+
+    glBindVertexArray(b->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+    if(pos_loc != -1) {
+        glEnableVertexAttribArray(pos_loc);
+        glVertexAttribPointer(pos_loc, 3, GL_FLOAT, GL_FALSE, sizeof(vt_pt), (void*)offsetof(vt_pt, position));
+    }
+    if(uv_loc != -1) {
+        glEnableVertexAttribArray(uv_loc);
+        glVertexAttribPointer(uv_loc, 2, GL_FLOAT, GL_FALSE, sizeof(vt_pt), (void*)offsetof(vt_pt, uv));
+    }
+
+    glDrawArrays(GL_TRIANGLES, 0, count);
+    ui_stat_add(UI_STAT_DRAW_CALLS, 1);
+
+    if(pos_loc != -1) {
+        glDisableVertexAttribArray(pos_loc);
+    }
+    if(uv_loc != -1) {
+        glDisableVertexAttribArray(uv_loc);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// Cleanup a buffer, freeing GPU resources
+void ui_buffer_cleanup(ui_buffer* b) {
+    check_return(b != NULL, "Buffer is NULL", );
+
+    if(b->vbo != 0) {
+        glDeleteBuffers(1, &b->vbo);
+        glDeleteVertexArrays(1, &b->vao);
+    }
+
+    ui_buffer_init(b);
+}
@@ -0,0 +1,27 @@
+#ifndef DF_UI_BUFFER
+#define DF_UI_BUFFER
+
+#include "core/types.h"
+#include "graphics/mesh.h"
+#include "graphics/shader.h"
+
+// A growable GPU vertex buffer for streaming vt_pt data
+typedef struct ui_buffer {
+    GLuint vao;
+    GLuint vbo;
+    uint32 capacity;
+} ui_buffer;
+
+// Initialize a buffer. No GL calls are made until the first upload.
+void ui_buffer_init(ui_buffer* b);
+
+// Upload count vertices to the buffer, growing it if needed
+void ui_buffer_upload(ui_buffer* b, const vt_pt* verts, uint32 count);
+
+// Render the first count vertices of the buffer as triangles
+void ui_buffer_render(ui_buffer* b, shader s, uint32 count);
+
+// Cleanup a buffer, freeing GPU resources
+void ui_buffer_cleanup(ui_buffer* b);
+
+#endif // DF_UI_BUFFER
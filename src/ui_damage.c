@@ -0,0 +1,231 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "ui_damage.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+
+#include <math.h>
+
+// Create a damage tracker for a screen
+ui_damage ui_damage_new(aabb_2d screen, uint16 max_regions) {
+    check_return(max_regions != 0, "Damage trackers need at least one region", NULL);
+
+    ui_damage d = mscalloc(1, struct ui_damage);
+    d->screen = screen;
+    d->max_regions = max_regions;
+    d->rects = NULL;
+    d->rect_count = 0;
+    d->rect_capacity = 0;
+    d->regions = salloc(max_regions * sizeof(aabb_2d));
+    d->region_count = 0;
+
+    // Nothing has been drawn yet, so the first regions cover the whole screen
+    d->is_full = true;
+    d->regions_valid = false;
+
+    return d;
+}
+
+// Frees the tracker
+void _ui_damage_free(ui_damage d) {
+    check_return(d != NULL, "Damage tracker is NULL", );
+
+    sfree(d->rects);
+    sfree(d->regions);
+    sfree(d);
+}
+
+void ui_damage_set_screen(ui_damage d, aabb_2d screen) {
+    check_return(d != NULL, "Damage tracker is NULL", );
+
+    d->screen = screen;
+    ui_damage_add_all(d);
+}
+
+static float get_area(aabb_2d box) {
+    return box.dimensions.x * box.dimensions.y;
+}
+
+static aabb_2d get_union(aabb_2d a, aabb_2d b) {
+    float left = min(a.position.x, b.position.x);
+    float top = min(a.position.y, b.position.y);
+    float right = max(a.position.x + a.dimensions.x, b.position.x + b.dimensions.x);
+    float bottom = max(a.position.y + a.dimensions.y, b.position.y + b.dimensions.y);
+
+    return (aabb_2d) {
+        .position = { .x = left, .y = top },
+        .dimensions = { .x = right - left, .y = bottom - top }
+    };
+}
+
+// Gets the area a and b share. Negative if they don't touch.
+static float get_overlap(aabb_2d a, aabb_2d b) {
+    float width = min(a.position.x + a.dimensions.x, b.position.x + b.dimensions.x) - max(a.position.x, b.position.x);
+    float height = min(a.position.y + a.dimensions.y, b.position.y + b.dimensions.y) - max(a.position.y, b.position.y);
+    if(width < 0 || height < 0) {
+        return -1;
+    }
+
+    return width * height;
+}
+
+// Gets the area that merging a and b would redraw without it being damaged
+static float get_merge_cost(aabb_2d a, aabb_2d b) {
+    float overlap = max(get_overlap(a, b), 0);
+    return get_area(get_union(a, b)) - (get_area(a) + get_area(b) - overlap);
+}
+
+void ui_damage_add(ui_damage d, aabb_2d box) {
+    check_return(d != NULL, "Damage tracker is NULL", );
+
+    if(d->is_full) {
+        return;
+    }
+
+    // Snap outwards to whole pixels, since regions are usually used as scissor boxes
+    float left = max(floorf(box.position.x), d->screen.position.x);
+    float top = max(floorf(box.position.y), d->screen.position.y);
+    float right = min(ceilf(box.position.x + box.dimensions.x), d->screen.position.x + d->screen.dimensions.x);
+    float bottom = min(ceilf(box.position.y + box.dimensions.y), d->screen.position.y + d->screen.dimensions.y);
+    if(right <= left || bottom <= top) {
+        return;
+    }
+
+    if(d->rect_count == d->rect_capacity) {
+        d->rect_capacity = max(d->rect_capacity * 2, 16);
+        d->rects = srealloc(d->rects, d->rect_capacity * sizeof(aabb_2d));
+    }
+    d->rects[d->rect_count++] = (aabb_2d) {
+        .position = { .x = left, .y = top },
+        .dimensions = { .x = right - left, .y = bottom - top }
+    };
+    d->regions_valid = false;
+}
+
+void ui_damage_add_all(ui_damage d) {
+    check_return(d != NULL, "Damage tracker is NULL", );
+
+    d->is_full = true;
+    d->rect_count = 0;
+    d->regions_valid = false;
+}
+
+bool ui_damage_is_empty(ui_damage d) {
+    check_return(d != NULL, "Damage tracker is NULL", true);
+
+    return !d->is_full && d->rect_count == 0;
+}
+
+aabb_2d ui_damage_transform(aabb_2d box, mat4 m) {
+    // Only the 2D affine part of m affects where the box lands on screen
+    float left = 0, top = 0, right = 0, bottom = 0;
+    for(uint8 i = 0; i < 4; ++i) {
+        float x = box.position.x + ((i & 1) ? box.dimensions.x : 0);
+        float y = box.position.y + ((i & 2) ? box.dimensions.y : 0);
+        float tx = m.data[0] * x + m.data[4] * y + m.data[12];
+        float ty = m.data[1] * x + m.data[5] * y + m.data[13];
+
+        left = i == 0 ? tx : min(left, tx);
+        right = i == 0 ? tx : max(right, tx);
+        top = i == 0 ? ty : min(top, ty);
+        bottom = i == 0 ? ty : max(bottom, ty);
+    }
+
+    return (aabb_2d) {
+        .position = { .x = left, .y = top },
+        .dimensions = { .x = right - left, .y = bottom - top }
+    };
+}
+
+// Merges the reported damage into as few non-overlapping regions as possible.
+// Overlapping, touching and adjacent damage is combined whenever that doesn't redraw anything extra.
+// If there are still too many regions, the cheapest pairs are merged until they fit.
+static void merge_regions(ui_damage d) {
+    // Work in the rects array, since merging never needs more room than the input
+    uint32 count = 0;
+    for(uint32 i = 0; i < d->rect_count; ++i) {
+        aabb_2d box = d->rects[i];
+
+        // Merging can make the box reach regions it didn't before, so start over after each merge
+        for(uint32 j = 0; j < count;) {
+            float overlap = get_overlap(box, d->rects[j]);
+            if(overlap > 0 || (overlap == 0 && get_merge_cost(box, d->rects[j]) <= 0)) {
+                box = get_union(box, d->rects[j]);
+                d->rects[j] = d->rects[--count];
+                j = 0;
+            } else {
+                ++j;
+            }
+        }
+        d->rects[count++] = box;
+    }
+
+    while(count > d->max_regions) {
+        uint32 best_a = 0, best_b = 1;
+        float best_cost = INFINITY;
+        for(uint32 a = 0; a < count; ++a) {
+            for(uint32 b = a + 1; b < count; ++b) {
+                float cost = get_merge_cost(d->rects[a], d->rects[b]);
+                if(cost < best_cost) {
+                    best_cost = cost;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+
+        d->rects[best_a] = get_union(d->rects[best_a], d->rects[best_b]);
+        d->rects[best_b] = d->rects[--count];
+
+        // The grown region may now overlap others, which are folded into it
+        for(uint32 j = 0; j < count;) {
+            if(j != best_a && get_overlap(d->rects[best_a], d->rects[j]) > 0) {
+                d->rects[best_a] = get_union(d->rects[best_a], d->rects[j]);
+                d->rects[j] = d->rects[--count];
+                if(best_a == count) {
+                    best_a = j;
+                }
+                j = 0;
+            } else {
+                ++j;
+            }
+        }
+    }
+
+    d->rect_count = count;
+    for(uint32 i = 0; i < count; ++i) {
+        d->regions[i] = d->rects[i];
+    }
+    d->region_count = count;
+}
+
+const aabb_2d* ui_damage_get_regions(ui_damage d, uint16* count) {
+    check_return(d != NULL, "Damage tracker is NULL", NULL);
+
+    if(!d->regions_valid) {
+        if(d->is_full) {
+            d->regions[0] = d->screen;
+            d->region_count = 1;
+        } else {
+            merge_regions(d);
+        }
+        d->regions_valid = true;
+    }
+
+    if(count != NULL) {
+        *count = d->region_count;
+    }
+
+    return d->regions;
+}
+
+void ui_damage_clear(ui_damage d) {
+    check_return(d != NULL, "Damage tracker is NULL", );
+
+    d->is_full = false;
+    d->rect_count = 0;
+    d->region_count = 0;
+    d->regions_valid = true;
+}
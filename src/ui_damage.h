@@ -0,0 +1,58 @@
+#ifndef DF_UI_DAMAGE
+#define DF_UI_DAMAGE
+
+#include "core/types.h"
+#include "math/aabb.h"
+#include "math/matrix.h"
+
+// Collects the screen regions that changed since the UI was last drawn, so that an application
+// can keep the UI in a cached layer and only redraw what's dirty.
+// Frames, menus and layouts report their own damage to a tracker. Everything here is CPU-only.
+typedef struct ui_damage {
+    aabb_2d screen;
+    uint16 max_regions;
+
+    // Damage reported since the last clear, snapped to whole pixels and clipped to the screen
+    aabb_2d* rects;
+    uint32 rect_count;
+    uint32 rect_capacity;
+
+    // Set when everything needs to be redrawn
+    bool is_full;
+
+    // The merged regions, rebuilt when damage is added
+    aabb_2d* regions;
+    uint16 region_count;
+    bool regions_valid;
+}* ui_damage;
+
+// Create a damage tracker for a screen. Damage is merged down to at most max_regions regions.
+ui_damage ui_damage_new(aabb_2d screen, uint16 max_regions);
+
+// Frees the tracker
+#define ui_damage_free(d) { _ui_damage_free(d); d = NULL; }
+void _ui_damage_free(ui_damage d);
+
+// Change the screen bounds, which damages the whole screen
+void ui_damage_set_screen(ui_damage d, aabb_2d screen);
+
+// Mark a region of the screen as damaged. Empty boxes are ignored.
+void ui_damage_add(ui_damage d, aabb_2d box);
+
+// Mark the whole screen as damaged
+void ui_damage_add_all(ui_damage d);
+
+// Checks whether anything has been damaged since the last clear
+bool ui_damage_is_empty(ui_damage d);
+
+// Get the screen-space box covering box after transforming it by m
+aabb_2d ui_damage_transform(aabb_2d box, mat4 m);
+
+// Get the merged damage regions. Overlapping and touching damage is combined, and the regions
+// never overlap. The result stays valid until damage is added or cleared.
+const aabb_2d* ui_damage_get_regions(ui_damage d, uint16* count);
+
+// Forget all damage, usually after the damaged regions have been redrawn
+void ui_damage_clear(ui_damage d);
+
+#endif // DF_UI_DAMAGE
@@ -0,0 +1,453 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "ui_document.h"
+
+#include "core/check.h"
+#include "core/memory/alloc.h"
+#include "resource/paths.h"
+#include "resource/xmlutil.h"
+
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(sizeof(vec2) == sizeof(float) * 2, "UI documents store vec2 directly, and expect it to be 2 floats");
+
+// A growable buffer of NUL-terminated strings
+typedef struct string_table {
+    char* data;
+    uint32 length;
+    uint32 capacity;
+} string_table;
+
+// Appends str to the table, returning its offset within the table
+static uint32 string_table_add(string_table* t, const char* str) {
+    uint32 len = strlen(str) + 1;
+    if(t->length + len > t->capacity) {
+        uint32 capacity = t->capacity == 0 ? 1024 : t->capacity;
+        while(capacity < t->length + len) {
+            capacity *= 2;
+        }
+        t->data = srealloc(t->data, capacity);
+        t->capacity = capacity;
+    }
+
+    uint32 offset = t->length;
+    memcpy(t->data + offset, str, len);
+    t->length += len;
+
+    return offset;
+}
+
+// The document being compiled
+typedef struct doc_builder {
+    const char* path;
+
+    ui_doc_node* nodes;
+    uint32 node_count;
+    uint32 node_capacity;
+
+    ui_doc_entry* entries;
+    uint32 entry_count;
+    uint32 entry_capacity;
+
+    string_table strings;
+} doc_builder;
+
+static const char* layout_type_names[] = {
+    [LAYOUT_FREE] = "free",
+    [LAYOUT_STACK_HORIZONTAL] = "stack_horizontal",
+    [LAYOUT_STACK_VERTICAL] = "stack_vertical",
+    [LAYOUT_GRID] = "grid",
+    [LAYOUT_FLEX_HORIZONTAL] = "flex_horizontal",
+    [LAYOUT_FLEX_VERTICAL] = "flex_vertical",
+};
+
+static bool is_named(xmlNodePtr node, const char* name) {
+    return node->type == XML_ELEMENT_NODE && xmlStrcmp(node->name, (const xmlChar*)name) == 0;
+}
+
+// Reads a string property into the string table, returning UI_DOC_NONE if it's missing
+static uint32 read_string(doc_builder* b, xmlNodePtr node, const char* name) {
+    char* value = NULL;
+    if(!xml_property_read(node, name, &value)) {
+        return UI_DOC_NONE;
+    }
+
+    uint32 offset = string_table_add(&b->strings, value);
+    sfree(value);
+
+    return offset;
+}
+
+static uint32 add_node(doc_builder* b, ui_doc_node_type type, uint32 parent) {
+    if(b->node_count == b->node_capacity) {
+        b->node_capacity = max(b->node_capacity * 2, 16);
+        b->nodes = srealloc(b->nodes, b->node_capacity * sizeof(ui_doc_node));
+    }
+
+    b->nodes[b->node_count] = (ui_doc_node) {
+        .parent = parent,
+        .name = UI_DOC_NONE,
+        .frame_path = UI_DOC_NONE,
+        .first_entry = 0,
+        .entry_count = 0,
+        .type = type,
+        .layout_type = LAYOUT_FREE,
+        .align = ALIGN_DEFAULT,
+        .wrap = false,
+        .columns = 1,
+    };
+
+    return b->node_count++;
+}
+
+// Reads the properties shared by everything that can be placed in a layout
+static bool read_placement(doc_builder* b, xmlNodePtr node, ui_doc_node* out) {
+    uint16 align = ALIGN_DEFAULT;
+
+    out->name = read_string(b, node, "name");
+    xml_property_read(node, "dimensions", &out->dims);
+    xml_property_read(node, "padding", &out->padding);
+    xml_property_read(node, "min_dimensions", &out->min_dims);
+    xml_property_read(node, "max_dimensions", &out->max_dims);
+    xml_property_read(node, "grow", &out->grow);
+    xml_property_read(node, "shrink", &out->shrink);
+    xml_property_read(node, "align", &align);
+
+    check_return(align <= ALIGN_LAST, "Invalid alignment 0x%x in %s", false, align, b->path);
+    out->align = align;
+
+    return true;
+}
+
+static bool compile_children(doc_builder* b, xmlNodePtr node, uint32 parent);
+
+static bool compile_menu(doc_builder* b, xmlNodePtr node, uint32 parent) {
+    uint32 index = add_node(b, UI_DOC_MENU, parent);
+    if(!read_placement(b, node, &b->nodes[index])) {
+        return false;
+    }
+    xml_property_read(node, "offset", &b->nodes[index].spacing);
+    xml_property_read(node, "wrap", &b->nodes[index].wrap);
+
+    // Entries are added before any submenus, so that each menu's entries stay contiguous
+    uint32 first_entry = b->entry_count;
+    uint32 entry_count = 0;
+    for(xmlNodePtr child = node->children; child != NULL; child = child->next) {
+        if(!is_named(child, "entry")) {
+            continue;
+        }
+
+        if(b->entry_count == b->entry_capacity) {
+            b->entry_capacity = max(b->entry_capacity * 2, 16);
+            b->entries = srealloc(b->entries, b->entry_capacity * sizeof(ui_doc_entry));
+        }
+
+        ui_doc_entry* entry = &b->entries[b->entry_count++];
+        entry->label = read_string(b, child, "label");
+        entry->event = read_string(b, child, "event");
+        entry->submenu = UI_DOC_NONE;
+        if(entry->label == UI_DOC_NONE) {
+            entry->label = string_table_add(&b->strings, "");
+        }
+        ++entry_count;
+    }
+    b->nodes[index].first_entry = first_entry;
+    b->nodes[index].entry_count = entry_count;
+
+    uint32 entry_index = first_entry;
+    for(xmlNodePtr child = node->children; child != NULL; child = child->next) {
+        if(!is_named(child, "entry")) {
+            continue;
+        }
+
+        for(xmlNodePtr sub = child->children; sub != NULL; sub = sub->next) {
+            if(is_named(sub, "menu")) {
+                uint32 submenu = b->node_count;
+                if(!compile_menu(b, sub, index)) {
+                    return false;
+                }
+                b->entries[entry_index].submenu = submenu;
+                break;
+            }
+        }
+        ++entry_index;
+    }
+
+    return true;
+}
+
+static bool compile_element(doc_builder* b, xmlNodePtr node, uint32 parent) {
+    uint32 index = add_node(b, UI_DOC_ELEMENT, parent);
+    if(!read_placement(b, node, &b->nodes[index])) {
+        return false;
+    }
+
+    char* frame_path = NULL;
+    if(xml_property_read(node, "frame", &frame_path)) {
+        frame_path = combine_paths(get_folder(b->path), frame_path, true);
+        b->nodes[index].frame_path = string_table_add(&b->strings, frame_path);
+        sfree(frame_path);
+    }
+
+    return true;
+}
+
+static bool compile_layout(doc_builder* b, xmlNodePtr node, uint32 parent) {
+    uint32 index = add_node(b, UI_DOC_LAYOUT, parent);
+    if(!read_placement(b, node, &b->nodes[index])) {
+        return false;
+    }
+    xml_property_read(node, "spacing", &b->nodes[index].spacing);
+    xml_property_read(node, "columns", &b->nodes[index].columns);
+    xml_property_read(node, "wrap", &b->nodes[index].wrap);
+
+    char* type = NULL;
+    if(xml_property_read(node, "type", &type)) {
+        bool found = false;
+        for(uint8 i = 0; i < sizeof(layout_type_names) / sizeof(layout_type_names[0]); ++i) {
+            if(strcmp(type, layout_type_names[i]) == 0) {
+                b->nodes[index].layout_type = i;
+                found = true;
+                break;
+            }
+        }
+
+        if(!found) {
+            error("Unknown layout type %s in %s", type, b->path);
+            sfree(type);
+            return false;
+        }
+        sfree(type);
+    }
+
+    return compile_children(b, node, index);
+}
+
+static bool compile_children(doc_builder* b, xmlNodePtr node, uint32 parent) {
+    for(xmlNodePtr child = node->children; child != NULL; child = child->next) {
+        bool success = true;
+        if(is_named(child, "layout")) {
+            success = compile_layout(b, child, parent);
+        } else if(is_named(child, "element")) {
+            success = compile_element(b, child, parent);
+        } else if(is_named(child, "menu")) {
+            success = compile_menu(b, child, parent);
+        } else if(child->type == XML_ELEMENT_NODE) {
+            error("Unknown ui node %s in %s", (const char*)child->name, b->path);
+            success = false;
+        }
+
+        if(!success) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Compile the xml document at path. Returns NULL on failure.
+ui_doc ui_doc_compile(const char* path) {
+    check_return(path != NULL, "UI document path is NULL", NULL);
+
+    xmlDocPtr xml = xmlReadFile(path, NULL, 0);
+    check_return(xml, "Failed to load UI document at path %s", NULL, path);
+
+    doc_builder b = { .path = path };
+    bool success = false;
+
+    xmlNodePtr root = xmlDocGetRootElement(xml);
+    xmlNodePtr first = NULL;
+    if(root != NULL && is_named(root, "ui")) {
+        for(xmlNodePtr child = root->children; child != NULL && first == NULL; child = child->next) {
+            if(child->type == XML_ELEMENT_NODE) {
+                first = child;
+            }
+        }
+    }
+
+    if(first == NULL || !is_named(first, "layout")) {
+        error("UI document %s must contain a root layout", path);
+    } else {
+        success = compile_layout(&b, first, UI_DOC_NONE);
+    }
+    xmlFreeDoc(xml);
+
+    ui_doc doc = NULL;
+    if(success) {
+        uint32 nodes_offset = sizeof(struct ui_doc_header);
+        uint32 entries_offset = nodes_offset + b.node_count * sizeof(ui_doc_node);
+        uint32 strings_offset = entries_offset + b.entry_count * sizeof(ui_doc_entry);
+        uint32 size = strings_offset + b.strings.length;
+
+        doc = salloc(size);
+        *doc = (struct ui_doc_header) {
+            .magic = { UI_DOC_MAGIC[0], UI_DOC_MAGIC[1], UI_DOC_MAGIC[2], UI_DOC_MAGIC[3] },
+            .version = UI_DOC_VERSION,
+            .size = size,
+            .node_count = b.node_count,
+            .entry_count = b.entry_count,
+            .nodes_offset = nodes_offset,
+            .entries_offset = entries_offset,
+            .strings_offset = strings_offset
+        };
+
+        uint8* data = (uint8*)doc;
+        memcpy(data + nodes_offset, b.nodes, b.node_count * sizeof(ui_doc_node));
+        if(b.entry_count > 0) {
+            memcpy(data + entries_offset, b.entries, b.entry_count * sizeof(ui_doc_entry));
+        }
+        if(b.strings.length > 0) {
+            memcpy(data + strings_offset, b.strings.data, b.strings.length);
+        }
+    }
+
+    sfree(b.nodes);
+    sfree(b.entries);
+    sfree(b.strings.data);
+
+    return doc;
+}
+
+// Checks that a string offset lies within the string table, and the string is terminated
+static bool validate_string(ui_doc doc, uint32 offset) {
+    if(offset == UI_DOC_NONE) {
+        return true;
+    }
+
+    uint32 table_size = doc->size - doc->strings_offset;
+    return offset < table_size && memchr((uint8*)doc + doc->strings_offset + offset, '\0', table_size - offset) != NULL;
+}
+
+// Checks everything a loaded document refers to, so that it can be used without further checks
+static bool validate(ui_doc doc, size_t size) {
+    if(size < sizeof(struct ui_doc_header) || memcmp(doc->magic, UI_DOC_MAGIC, 4) != 0 ||
+       doc->version != UI_DOC_VERSION || doc->size != size ||
+       doc->nodes_offset != sizeof(struct ui_doc_header) ||
+       doc->node_count == 0 || doc->node_count > (size - doc->nodes_offset) / sizeof(ui_doc_node) ||
+       doc->entries_offset != doc->nodes_offset + doc->node_count * sizeof(ui_doc_node) ||
+       doc->entry_count > (size - doc->entries_offset) / sizeof(ui_doc_entry) ||
+       doc->strings_offset != doc->entries_offset + doc->entry_count * sizeof(ui_doc_entry)) {
+        return false;
+    }
+
+    for(uint32 i = 0; i < doc->node_count; ++i) {
+        const ui_doc_node* node = ui_doc_get_node(doc, i);
+        bool parent_valid = i == 0 ? node->parent == UI_DOC_NONE : node->parent < i;
+        if(!parent_valid || node->type > UI_DOC_MENU || node->layout_type > LAYOUT_FLEX_VERTICAL || node->align > ALIGN_LAST ||
+           !validate_string(doc, node->name) || !validate_string(doc, node->frame_path) ||
+           node->first_entry > doc->entry_count || node->entry_count > doc->entry_count - node->first_entry) {
+            return false;
+        }
+
+        // Only menus can be nested in menus, and nothing can be nested in an element
+        if(i > 0) {
+            uint8 parent_type = ui_doc_get_node(doc, node->parent)->type;
+            if(parent_type == UI_DOC_ELEMENT || (parent_type == UI_DOC_MENU && node->type != UI_DOC_MENU)) {
+                return false;
+            }
+        }
+    }
+    if(ui_doc_get_node(doc, 0)->type != UI_DOC_LAYOUT) {
+        return false;
+    }
+
+    for(uint32 i = 0; i < doc->entry_count; ++i) {
+        const ui_doc_entry* entry = ui_doc_get_entry(doc, i);
+        if(!validate_string(doc, entry->label) || !validate_string(doc, entry->event) ||
+           (entry->submenu != UI_DOC_NONE && (entry->submenu >= doc->node_count || ui_doc_get_node(doc, entry->submenu)->type != UI_DOC_MENU))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Load a compiled document. Returns NULL if the file is missing or invalid.
+ui_doc ui_doc_load(const char* path) {
+    check_return(path != NULL, "UI document path is NULL", NULL);
+
+    FILE* file = fopen(path, "rb");
+    check_return(file != NULL, "Failed to open UI document %s", NULL, path);
+
+    ui_doc doc = NULL;
+    long size = 0;
+    if(fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= (long)sizeof(struct ui_doc_header) && fseek(file, 0, SEEK_SET) == 0) {
+        doc = salloc(size);
+        if(fread(doc, 1, size, file) != (size_t)size || !validate(doc, size)) {
+            sfree(doc);
+            doc = NULL;
+        }
+    }
+    fclose(file);
+
+    check_return(doc != NULL, "UI document %s is invalid", NULL, path);
+
+    return doc;
+}
+
+// Save a compiled document to path. Returns true on success.
+bool ui_doc_save(ui_doc doc, const char* path) {
+    check_return(doc != NULL, "UI document is NULL", false);
+    check_return(path != NULL, "UI document path is NULL", false);
+
+    FILE* file = fopen(path, "wb");
+    check_return(file != NULL, "Failed to open path %s for writing", false, path);
+
+    bool success = fwrite(doc, 1, doc->size, file) == doc->size;
+    success = (fclose(file) == 0) && success;
+    check_return(success, "Failed to write UI document %s", false, path);
+
+    return true;
+}
+
+void _ui_doc_free(ui_doc doc) {
+    check_return(doc != NULL, "UI document is NULL", );
+
+    sfree(doc);
+}
+
+const ui_doc_node* ui_doc_get_node(ui_doc doc, uint32 index) {
+    check_return(doc != NULL, "UI document is NULL", NULL);
+
+    if(index >= doc->node_count) {
+        return NULL;
+    }
+
+    return (const ui_doc_node*)((uint8*)doc + doc->nodes_offset) + index;
+}
+
+const ui_doc_entry* ui_doc_get_entry(ui_doc doc, uint32 index) {
+    check_return(doc != NULL, "UI document is NULL", NULL);
+
+    if(index >= doc->entry_count) {
+        return NULL;
+    }
+
+    return (const ui_doc_entry*)((uint8*)doc + doc->entries_offset) + index;
+}
+
+const char* ui_doc_get_string(ui_doc doc, uint32 offset) {
+    check_return(doc != NULL, "UI document is NULL", NULL);
+
+    if(offset == UI_DOC_NONE) {
+        return NULL;
+    }
+
+    return (const char*)doc + doc->strings_offset + offset;
+}
+
+uint32 ui_doc_find(ui_doc doc, const char* name) {
+    check_return(doc != NULL, "UI document is NULL", UI_DOC_NONE);
+    check_return(name != NULL, "Name is NULL", UI_DOC_NONE);
+
+    for(uint32 i = 0; i < doc->node_count; ++i) {
+        const char* node_name = ui_doc_get_string(doc, ui_doc_get_node(doc, i)->name);
+        if(node_name != NULL && strcmp(node_name, name) == 0) {
+            return i;
+        }
+    }
+
+    return UI_DOC_NONE;
+}
@@ -0,0 +1,121 @@
+#ifndef DF_UI_DOCUMENT
+#define DF_UI_DOCUMENT
+
+#include "core/types.h"
+#include "math/vector.h"
+
+#include "layout.h"
+
+// UI documents describe screens of nested layouts, elements (optionally drawn with a frame) and menus.
+// They're written in xml and compiled into a single pointer-free block, which can be saved, loaded and
+// instantiated as a ui_screen without any parsing.
+//
+// Xml format:
+//   <ui>
+//     <layout name="..." type="stack_vertical" dimensions="w h" padding="x y" spacing="x y" columns="3" wrap="true">
+//       <element name="..." dimensions="w h" padding="x y" align="0" grow="1" shrink="1"
+//                min_dimensions="w h" max_dimensions="w h" frame="panel.xml"/>
+//       <menu name="..." dimensions="w h" offset="x y" wrap="true">
+//         <entry label="Options" event="open_options">
+//           <menu> ... </menu>
+//         </entry>
+//       </menu>
+//       <layout> ... </layout>
+//     </layout>
+//   </ui>
+// The root must be a single layout. Layout types are free, stack_horizontal, stack_vertical, grid,
+// flex_horizontal and flex_vertical. Vectors are two space-separated numbers, like in frame files.
+// align is an alignment_2d value. Frame paths are relative to the document.
+//
+// Compiled layout (native byte order):
+//   ui_doc_header
+//   ui_doc_node[node_count], in document order, so parents always come before their children
+//   ui_doc_entry[entry_count], grouped by menu
+//   string table of NUL-terminated strings, referenced by offset from its start
+
+#define UI_DOC_MAGIC "DFUI"
+#define UI_DOC_VERSION 1
+
+// Marks a missing node or string
+#define UI_DOC_NONE 0xFFFFFFFF
+
+typedef enum ui_doc_node_type {
+    UI_DOC_LAYOUT,
+    UI_DOC_ELEMENT,
+    UI_DOC_MENU,
+} ui_doc_node_type;
+
+typedef struct ui_doc_header {
+    char magic[4];
+    uint32 version;
+    // The size of the whole document, including this header
+    uint32 size;
+    uint32 node_count;
+    uint32 entry_count;
+    uint32 nodes_offset;
+    uint32 entries_offset;
+    uint32 strings_offset;
+}* ui_doc;
+
+typedef struct ui_doc_node {
+    // The containing layout or menu. UI_DOC_NONE for the root.
+    uint32 parent;
+    uint32 name;
+    // Elements: the resolved path of the frame drawn behind the element
+    uint32 frame_path;
+    // Menus: the range of this menu's entries
+    uint32 first_entry;
+    uint32 entry_count;
+
+    uint8 type;
+    uint8 layout_type;
+    uint8 align;
+    // Layouts: flex wrapping. Menus: cursor wrapping.
+    bool wrap;
+    uint16 columns;
+    uint16 reserved;
+
+    vec2 dims;
+    vec2 padding;
+    // Layouts: the gap between cells or elements. Menus: the offset between entries.
+    vec2 spacing;
+    vec2 min_dims;
+    vec2 max_dims;
+    float grow;
+    float shrink;
+} ui_doc_node;
+
+typedef struct ui_doc_entry {
+    uint32 label;
+    // The name the activation event is looked up by when the document is instantiated
+    uint32 event;
+    // The submenu's node
+    uint32 submenu;
+} ui_doc_entry;
+
+// Compile the xml document at path. Returns NULL on failure.
+ui_doc ui_doc_compile(const char* path);
+
+// Load a compiled document. Returns NULL if the file is missing or invalid.
+ui_doc ui_doc_load(const char* path);
+
+// Save a compiled document to path. Returns true on success.
+bool ui_doc_save(ui_doc doc, const char* path);
+
+// Frees a document. It's a single block, so this is just one free.
+#define ui_doc_free(doc) { _ui_doc_free(doc); doc = NULL; }
+void _ui_doc_free(ui_doc doc);
+
+// Get a node, or NULL if index is out of range
+const ui_doc_node* ui_doc_get_node(ui_doc doc, uint32 index);
+
+// Get an entry, or NULL if index is out of range
+const ui_doc_entry* ui_doc_get_entry(ui_doc doc, uint32 index);
+
+// Get a string by its offset. Returns NULL for UI_DOC_NONE.
+const char* ui_doc_get_string(ui_doc doc, uint32 offset);
+
+// Find a node by name. Returns UI_DOC_NONE if there isn't one.
+uint32 ui_doc_find(ui_doc doc, const char* name);
+
+#endif // DF_UI_DOCUMENT
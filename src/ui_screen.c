@@ -0,0 +1,227 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "ui_screen.h"
+
+#include "core/check.h"
+
+// Gets the arena space a screen built from doc needs, so that it fits in a single block
+static size_t get_screen_size(ui_doc doc) {
+    size_t cleanup = ui_arena_size(sizeof(ui_arena_cleanup));
+    size_t size = ui_arena_size(sizeof(struct ui_screen)) + cleanup +
+                  ui_arena_size(doc->node_count * sizeof(ui_screen_node));
+
+    for(uint32 i = 0; i < doc->node_count; ++i) {
+        const ui_doc_node* node = ui_doc_get_node(doc, i);
+        switch(node->type) {
+            case UI_DOC_LAYOUT:
+                size += ui_arena_size(sizeof(layout)) + cleanup;
+            break;
+            case UI_DOC_ELEMENT:
+                size += ui_arena_size(sizeof(layout_element));
+                if(node->frame_path != UI_DOC_NONE) {
+                    size += ui_arena_size(sizeof(struct frame)) + ui_arena_size(FRAME_VERTEX_MAX * sizeof(vt_pt)) + cleanup;
+                }
+            break;
+            case UI_DOC_MENU:
+                size += ui_arena_size(sizeof(struct menu)) + cleanup;
+                if(node->parent != UI_DOC_NONE && ui_doc_get_node(doc, node->parent)->type == UI_DOC_LAYOUT) {
+                    size += ui_arena_size(sizeof(layout_element));
+                }
+            break;
+        }
+    }
+
+    return size;
+}
+
+// Releases the screen's frame data back to the cache. Registered first, so it runs after everything else.
+static void release_frames(void* data) {
+    ui_screen s = data;
+
+    for(uint32 i = 0; i < s->node_count; ++i) {
+        if(s->nodes[i].frame != NULL) {
+            frame_cache_release(s->cache, s->nodes[i].frame->data);
+        }
+    }
+}
+
+static void apply_placement(layout_element* elem, const ui_doc_node* node) {
+    elem->requested_dims = node->dims;
+    elem->padding = node->padding;
+    elem->align = node->align;
+    elem->grow = node->grow;
+    elem->shrink = node->shrink;
+    elem->min_dims = node->min_dims;
+    elem->max_dims = node->max_dims;
+}
+
+// Creates the objects for a node, without connecting them to anything. Menus use glyphs if it isn't NULL, and fnt otherwise.
+static bool create_node(ui_screen s, uint32 index, font fnt, const menu_glyph_source* glyphs) {
+    const ui_doc_node* node = ui_doc_get_node(s->doc, index);
+    ui_screen_node* out = &s->nodes[index];
+
+    switch(node->type) {
+        case UI_DOC_LAYOUT:
+            out->layout = layout_new_in(s->arena, node->dims, node->layout_type);
+            layout_set_columns(out->layout, node->columns);
+            layout_set_spacing(out->layout, node->spacing);
+            layout_set_wrap(out->layout, node->wrap);
+            out->element = &out->layout->bounds;
+            apply_placement(out->element, node);
+        break;
+        case UI_DOC_ELEMENT:
+            out->element = ui_arena_mnew(s->arena, layout_element);
+            apply_placement(out->element, node);
+
+            if(node->frame_path != UI_DOC_NONE && s->cache != NULL) {
+                frame_data* data = frame_cache_load(s->cache, ui_doc_get_string(s->doc, node->frame_path));
+                if(data != NULL) {
+                    out->frame = frame_new_in(s->arena, data, node->dims);
+                }
+            }
+        break;
+        case UI_DOC_MENU:
+            check_return(fnt != NULL || glyphs != NULL, "UI document has menus, but no font was given", false);
+
+            out->menu = glyphs != NULL ? menu_new_in_with_glyphs(s->arena, *glyphs) : menu_new_in(s->arena, fnt);
+            check_return(out->menu != NULL, "Couldn't create a menu for the UI document", false);
+            out->menu->can_wrap = node->wrap;
+            menu_set_offset(out->menu, (vec3){ .x = node->spacing.x, .y = node->spacing.y, .z = 0 });
+
+            if(node->parent != UI_DOC_NONE && ui_doc_get_node(s->doc, node->parent)->type == UI_DOC_LAYOUT) {
+                out->element = ui_arena_mnew(s->arena, layout_element);
+                apply_placement(out->element, node);
+            }
+        break;
+    }
+
+    return true;
+}
+
+// Fills in a node's menu entries and adds it to its parent layout. Nodes come after their parents, and
+// every node has been created by now, so submenus already exist.
+static void connect_node(ui_screen s, uint32 index, ui_event_lookup_func lookup, void* user) {
+    const ui_doc_node* node = ui_doc_get_node(s->doc, index);
+    ui_screen_node* out = &s->nodes[index];
+
+    if(out->menu != NULL) {
+        for(uint32 i = 0; i < node->entry_count; ++i) {
+            const ui_doc_entry* entry = ui_doc_get_entry(s->doc, node->first_entry + i);
+            menu submenu = entry->submenu != UI_DOC_NONE ? s->nodes[entry->submenu].menu : NULL;
+            menu_activate_event* event = NULL;
+            if(entry->event != UI_DOC_NONE && lookup != NULL) {
+                event = lookup(ui_doc_get_string(s->doc, entry->event), user);
+            }
+
+            menu_add_entry(out->menu, ui_doc_get_string(s->doc, entry->label), submenu, event);
+        }
+
+        // Menus without a declared size take up the space their entries need
+        if(out->element != NULL && node->dims.x == 0 && node->dims.y == 0) {
+            out->element->requested_dims = menu_calculate_dims(out->menu);
+        }
+    }
+
+    if(node->parent == UI_DOC_NONE || s->nodes[node->parent].layout == NULL) {
+        return;
+    }
+
+    layout* parent = s->nodes[node->parent].layout;
+    if(out->layout != NULL) {
+        layout_add_layout(parent, out->layout);
+    } else {
+        layout_add_element(parent, out->element);
+    }
+}
+
+static ui_screen screen_new(ui_doc doc, font fnt, const menu_glyph_source* glyphs, frame_cache cache, ui_event_lookup_func lookup, void* user) {
+    check_return(doc != NULL, "UI document is NULL", NULL);
+
+    ui_arena a = ui_arena_new(get_screen_size(doc));
+    ui_screen s = ui_arena_mnew(a, struct ui_screen);
+    s->arena = a;
+    s->doc = doc;
+    s->cache = cache;
+    s->node_count = doc->node_count;
+    s->nodes = ui_arena_alloc(a, doc->node_count * sizeof(ui_screen_node));
+    ui_arena_defer(a, release_frames, s);
+
+    for(uint32 i = 0; i < doc->node_count; ++i) {
+        if(!create_node(s, i, fnt, glyphs)) {
+            ui_arena_free(a);
+            return NULL;
+        }
+    }
+    for(uint32 i = 0; i < doc->node_count; ++i) {
+        connect_node(s, i, lookup, user);
+    }
+
+    return s;
+}
+
+ui_screen ui_screen_new(ui_doc doc, font fnt, frame_cache cache, ui_event_lookup_func lookup, void* user) {
+    return screen_new(doc, fnt, NULL, cache, lookup, user);
+}
+
+ui_screen ui_screen_new_with_glyphs(ui_doc doc, menu_glyph_source glyphs, frame_cache cache, ui_event_lookup_func lookup, void* user) {
+    return screen_new(doc, NULL, &glyphs, cache, lookup, user);
+}
+
+void _ui_screen_free(ui_screen s) {
+    check_return(s != NULL, "Screen is NULL", );
+
+    // The screen lives in its own arena
+    ui_arena a = s->arena;
+    ui_arena_free(a);
+}
+
+void ui_screen_update(ui_screen s) {
+    check_return(s != NULL, "Screen is NULL", );
+
+    layout_update(s->nodes[0].layout);
+    for(uint32 i = 0; i < s->node_count; ++i) {
+        if(s->nodes[i].frame != NULL) {
+            frame_set_dimensions(s->nodes[i].frame, s->nodes[i].element->calculated_bounds.dimensions);
+        }
+    }
+}
+
+layout* ui_screen_get_root(ui_screen s) {
+    check_return(s != NULL, "Screen is NULL", NULL);
+
+    return s->nodes[0].layout;
+}
+
+uint32 ui_screen_find(ui_screen s, const char* name) {
+    check_return(s != NULL, "Screen is NULL", UI_DOC_NONE);
+
+    return ui_doc_find(s->doc, name);
+}
+
+// Gets a node, or NULL if index is out of range
+static ui_screen_node* get_node(ui_screen s, uint32 index) {
+    check_return(s != NULL, "Screen is NULL", NULL);
+
+    return index < s->node_count ? &s->nodes[index] : NULL;
+}
+
+layout* ui_screen_get_layout(ui_screen s, uint32 index) {
+    ui_screen_node* node = get_node(s, index);
+    return node != NULL ? node->layout : NULL;
+}
+
+layout_element* ui_screen_get_element(ui_screen s, uint32 index) {
+    ui_screen_node* node = get_node(s, index);
+    return node != NULL ? node->element : NULL;
+}
+
+frame ui_screen_get_frame(ui_screen s, uint32 index) {
+    ui_screen_node* node = get_node(s, index);
+    return node != NULL ? node->frame : NULL;
+}
+
+menu ui_screen_get_menu(ui_screen s, uint32 index) {
+    ui_screen_node* node = get_node(s, index);
+    return node != NULL ? node->menu : NULL;
+}
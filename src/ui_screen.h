@@ -0,0 +1,75 @@
+#ifndef DF_UI_SCREEN
+#define DF_UI_SCREEN
+
+#include "graphics/font.h"
+
+#include "frame.h"
+#include "frame_cache.h"
+#include "layout.h"
+#include "menu.h"
+#include "ui_arena.h"
+#include "ui_document.h"
+
+// Gets the event to bind to menu entries that name it in a document. Returns NULL to leave the entry unbound.
+typedef menu_activate_event* (*ui_event_lookup_func)(const char* name, void* user);
+
+// The objects created for one document node. Unused fields are NULL.
+typedef struct ui_screen_node {
+    layout* layout;
+    // The node's place in its layout. For layouts, this is their bounds.
+    layout_element* element;
+    frame frame;
+    menu menu;
+} ui_screen_node;
+
+// A screen instantiated from a UI document. Everything the screen creates lives in one arena block,
+// sized from the document before anything is built, and is released at once when the screen is freed.
+typedef struct ui_screen {
+    ui_arena arena;
+    ui_doc doc;
+    frame_cache cache;
+
+    ui_screen_node* nodes;
+    uint32 node_count;
+}* ui_screen;
+
+/** @brief Build a screen from a compiled document
+ *
+ * @param doc The document. It must outlive the screen.
+ * @param fnt The font for menus. May be NULL if the document has no menus.
+ * @param cache The cache frames are loaded through. If NULL, elements are created without frames.
+ * @param lookup Finds the events named by menu entries. May be NULL.
+ * @param user Data passed to lookup
+ * @return The screen, or NULL on failure
+ */
+ui_screen ui_screen_new(ui_doc doc, font fnt, frame_cache cache, ui_event_lookup_func lookup, void* user);
+
+/** @brief Build a screen whose menus measure their labels with a glyph source instead of a font
+ *
+ * The other parameters are the same as ui_screen_new. Menus are created with menu_new_in_with_glyphs.
+ *
+ * @param glyphs Provides the glyph metrics and atlas size for menu labels
+ * @return The screen, or NULL on failure
+ */
+ui_screen ui_screen_new_with_glyphs(ui_doc doc, menu_glyph_source glyphs, frame_cache cache, ui_event_lookup_func lookup, void* user);
+
+// Frees the screen and everything in it, releasing its frames from the cache
+#define ui_screen_free(s) { _ui_screen_free(s); s = NULL; }
+void _ui_screen_free(ui_screen s);
+
+// Update the screen's layouts, and resize every frame to its element
+void ui_screen_update(ui_screen s);
+
+// Get the root layout
+layout* ui_screen_get_root(ui_screen s);
+
+// Find a node by the name it was given in the document. Returns UI_DOC_NONE if there isn't one.
+uint32 ui_screen_find(ui_screen s, const char* name);
+
+// Get the objects created for a node, or NULL if the node doesn't have one of that kind
+layout* ui_screen_get_layout(ui_screen s, uint32 index);
+layout_element* ui_screen_get_element(ui_screen s, uint32 index);
+frame ui_screen_get_frame(ui_screen s, uint32 index);
+menu ui_screen_get_menu(ui_screen s, uint32 index);
+
+#endif // DF_UI_SCREEN
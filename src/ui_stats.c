@@ -0,0 +1,111 @@
+// Log category, used to filter logs
+#define LOG_CATEGORY "UI"
+
+#include "ui_stats.h"
+
+#include "core/check.h"
+
+#include <stdatomic.h>
+#include <time.h>
+
+// Layout solving and loading can run on several threads, so the totals are atomic
+static _Atomic uint64 counters[UI_STAT_COUNTER_COUNT];
+static _Atomic uint64 time_ns[UI_STAT_TIMER_COUNT];
+static _Atomic uint64 time_samples[UI_STAT_TIMER_COUNT];
+
+static const char* counter_names[UI_STAT_COUNTER_COUNT] = {
+    [UI_STAT_MESH_REBUILDS] = "mesh_rebuilds",
+    [UI_STAT_BUFFER_ALLOCATIONS] = "buffer_allocations",
+    [UI_STAT_UPLOAD_BYTES] = "upload_bytes",
+    [UI_STAT_LAYOUT_SOLVES] = "layout_solves",
+    [UI_STAT_TEXT_CREATIONS] = "text_creations",
+    [UI_STAT_DRAW_CALLS] = "draw_calls",
+};
+
+static const char* timer_names[UI_STAT_TIMER_COUNT] = {
+    [UI_STAT_TIME_MESH_REBUILD] = "mesh_rebuild",
+    [UI_STAT_TIME_LAYOUT_UPDATE] = "layout_update",
+    [UI_STAT_TIME_MENU_BUILD] = "menu_build",
+    [UI_STAT_TIME_BATCH_FLUSH] = "batch_flush",
+};
+
+void _ui_stat_add(ui_stat_counter counter, uint64 n) {
+    atomic_fetch_add_explicit(&counters[counter], n, memory_order_relaxed);
+}
+
+void _ui_stat_add_time(ui_stat_timer timer, uint64 ns) {
+    atomic_fetch_add_explicit(&time_ns[timer], ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&time_samples[timer], 1, memory_order_relaxed);
+}
+
+// Get a monotonic timestamp, in nanoseconds
+uint64 ui_stats_get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Returns true if the library was built with statistics enabled
+bool ui_stats_enabled() {
+#ifdef DF_UI_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Copy the current statistics into out
+void ui_stats_snapshot(ui_stats* out) {
+    check_return(out != NULL, "Stats output is NULL", );
+
+    for(uint8 i = 0; i < UI_STAT_COUNTER_COUNT; ++i) {
+        out->counters[i] = atomic_load_explicit(&counters[i], memory_order_relaxed);
+    }
+    for(uint8 i = 0; i < UI_STAT_TIMER_COUNT; ++i) {
+        out->time_ns[i] = atomic_load_explicit(&time_ns[i], memory_order_relaxed);
+        out->time_samples[i] = atomic_load_explicit(&time_samples[i], memory_order_relaxed);
+    }
+}
+
+// Reset all statistics to zero
+void ui_stats_reset() {
+    for(uint8 i = 0; i < UI_STAT_COUNTER_COUNT; ++i) {
+        atomic_store_explicit(&counters[i], 0, memory_order_relaxed);
+    }
+    for(uint8 i = 0; i < UI_STAT_TIMER_COUNT; ++i) {
+        atomic_store_explicit(&time_ns[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&time_samples[i], 0, memory_order_relaxed);
+    }
+}
+
+// Get the name used for a counter or timer in JSON output
+const char* ui_stats_get_counter_name(ui_stat_counter counter) {
+    check_return(counter < UI_STAT_COUNTER_COUNT, "Invalid stat counter %u", NULL, counter);
+
+    return counter_names[counter];
+}
+const char* ui_stats_get_timer_name(ui_stat_timer timer) {
+    check_return(timer < UI_STAT_TIMER_COUNT, "Invalid stat timer %u", NULL, timer);
+
+    return timer_names[timer];
+}
+
+// Write a snapshot to file as a single JSON object
+bool ui_stats_write_json(const ui_stats* stats, FILE* file) {
+    check_return(stats != NULL, "Stats are NULL", false);
+    check_return(file != NULL, "Output file is NULL", false);
+
+    fprintf(file, "{\"enabled\":%s,\"counters\":{", ui_stats_enabled() ? "true" : "false");
+    for(uint8 i = 0; i < UI_STAT_COUNTER_COUNT; ++i) {
+        fprintf(file, "%s\"%s\":%llu", i == 0 ? "" : ",", counter_names[i], (unsigned long long)stats->counters[i]);
+    }
+
+    fprintf(file, "},\"timers\":{");
+    for(uint8 i = 0; i < UI_STAT_TIMER_COUNT; ++i) {
+        fprintf(file, "%s\"%s\":{\"total_ns\":%llu,\"samples\":%llu}", i == 0 ? "" : ",", timer_names[i],
+                (unsigned long long)stats->time_ns[i], (unsigned long long)stats->time_samples[i]);
+    }
+
+    return fprintf(file, "}}\n") > 0 && !ferror(file);
+}
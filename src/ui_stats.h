@@ -0,0 +1,80 @@
+#ifndef DF_UI_STATS_H
+#define DF_UI_STATS_H
+
+#include "core/types.h"
+
+#include <stdio.h>
+
+// Counters recorded by the UI's hot paths
+typedef enum ui_stat_counter {
+    // Calls to frame_rebuild_mesh that built vertices
+    UI_STAT_MESH_REBUILDS,
+    // GPU buffers created or grown for frame, menu and batch vertices
+    UI_STAT_BUFFER_ALLOCATIONS,
+    // Bytes of vertex or instance data uploaded to the GPU
+    UI_STAT_UPLOAD_BYTES,
+    // Elements re-solved by layout updates
+    UI_STAT_LAYOUT_SOLVES,
+    // Text objects created for menu labels
+    UI_STAT_TEXT_CREATIONS,
+    // Draw calls issued
+    UI_STAT_DRAW_CALLS,
+
+    UI_STAT_COUNTER_COUNT
+} ui_stat_counter;
+
+// Scoped timings recorded by the UI's hot paths
+typedef enum ui_stat_timer {
+    UI_STAT_TIME_MESH_REBUILD,
+    UI_STAT_TIME_LAYOUT_UPDATE,
+    UI_STAT_TIME_MENU_BUILD,
+    UI_STAT_TIME_BATCH_FLUSH,
+
+    UI_STAT_TIMER_COUNT
+} ui_stat_timer;
+
+// A copy of the statistics at one point in time
+typedef struct ui_stats {
+    uint64 counters[UI_STAT_COUNTER_COUNT];
+
+    // The total time spent in each timed scope, and the number of times it was entered
+    uint64 time_ns[UI_STAT_TIMER_COUNT];
+    uint64 time_samples[UI_STAT_TIMER_COUNT];
+} ui_stats;
+
+// Statistics are only recorded when the library is built with the stats option (DF_UI_STATS).
+// Otherwise the recording macros compile to nothing, and snapshots are always zero.
+// Counts are still referenced when disabled, so that values computed only for stats don't cause unused warnings.
+#ifdef DF_UI_STATS
+#define ui_stat_add(counter, n) _ui_stat_add(counter, n)
+#define ui_stat_time_begin(timer) uint64 _ui_stat_start_##timer = ui_stats_get_time()
+#define ui_stat_time_end(timer) _ui_stat_add_time(timer, ui_stats_get_time() - _ui_stat_start_##timer)
+#else
+#define ui_stat_add(counter, n) ((void)(n))
+#define ui_stat_time_begin(timer)
+#define ui_stat_time_end(timer)
+#endif
+
+void _ui_stat_add(ui_stat_counter counter, uint64 n);
+void _ui_stat_add_time(ui_stat_timer timer, uint64 ns);
+
+// Get a monotonic timestamp, in nanoseconds
+uint64 ui_stats_get_time();
+
+// Returns true if the library was built with statistics enabled
+bool ui_stats_enabled();
+
+// Copy the current statistics into out. This is safe to call while other threads are recording.
+void ui_stats_snapshot(ui_stats* out);
+
+// Reset all statistics to zero. Call this once per frame to get per-frame numbers.
+void ui_stats_reset();
+
+// Get the name used for a counter or timer in JSON output
+const char* ui_stats_get_counter_name(ui_stat_counter counter);
+const char* ui_stats_get_timer_name(ui_stat_timer timer);
+
+// Write a snapshot to file as a single JSON object. Returns true on success.
+bool ui_stats_write_json(const ui_stats* stats, FILE* file);
+
+#endif // DF_UI_STATS_H
@@ -0,0 +1,33 @@
+#ifndef DF_UI_TEST
+#define DF_UI_TEST
+
+// Minimal checks for the UI module's tests. Each test file builds into its own executable,
+// which reports every failed check and exits with a non-zero status if there were any.
+
+#include <math.h>
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define test_check(cond, ...) { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n    ", __FILE__, __LINE__, #cond); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        ++test_failures; \
+    } \
+}
+
+#define test_check_float(actual, expected) \
+    test_check(fabsf((float)(actual) - (float)(expected)) < 0.0001f, "expected %g, got %g", (double)(expected), (double)(actual))
+
+// Runs a test function, so that failures are reported with the test's name
+#define test_run(func) { \
+    int failures_before = test_failures; \
+    func(); \
+    fprintf(stderr, "%s %s\n", test_failures == failures_before ? "PASS" : "FAIL", #func); \
+}
+
+#define test_result() (test_failures == 0 ? 0 : 1)
+
+#endif // DF_UI_TEST
@@ -0,0 +1,183 @@
+// Tests for damage tracking: snapping, clipping, merging and the region limit
+
+#include "test.h"
+#include "ui_damage.h"
+
+static const aabb_2d screen = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 100, .y = 100 } };
+
+static aabb_2d make_box(float x, float y, float w, float h) {
+    return (aabb_2d){ .position = { .x = x, .y = y }, .dimensions = { .x = w, .y = h } };
+}
+
+static void check_box(aabb_2d box, float x, float y, float w, float h) {
+    test_check_float(box.position.x, x);
+    test_check_float(box.position.y, y);
+    test_check_float(box.dimensions.x, w);
+    test_check_float(box.dimensions.y, h);
+}
+
+static bool contains(aabb_2d outer, aabb_2d inner) {
+    return inner.position.x >= outer.position.x && inner.position.y >= outer.position.y &&
+           inner.position.x + inner.dimensions.x <= outer.position.x + outer.dimensions.x &&
+           inner.position.y + inner.dimensions.y <= outer.position.y + outer.dimensions.y;
+}
+
+static bool overlaps(aabb_2d a, aabb_2d b) {
+    return a.position.x < b.position.x + b.dimensions.x && b.position.x < a.position.x + a.dimensions.x &&
+           a.position.y < b.position.y + b.dimensions.y && b.position.y < a.position.y + a.dimensions.y;
+}
+
+// Nothing has been drawn before the first frame, so the whole screen is damaged
+static void test_first_frame_is_full() {
+    ui_damage d = ui_damage_new(screen, 4);
+    test_check(!ui_damage_is_empty(d), "a new tracker should be damaged");
+
+    uint16 count = 0;
+    const aabb_2d* regions = ui_damage_get_regions(d, &count);
+    test_check(count == 1, "expected 1 region, got %u", count);
+    if(count == 1) {
+        check_box(regions[0], 0, 0, 100, 100);
+    }
+
+    ui_damage_clear(d);
+    ui_damage_get_regions(d, &count);
+    test_check(ui_damage_is_empty(d), "a cleared tracker should be empty");
+    test_check(count == 0, "expected no regions after clearing, got %u", count);
+
+    ui_damage_free(d);
+}
+
+static void test_snap_and_clip() {
+    ui_damage d = ui_damage_new(screen, 4);
+    ui_damage_clear(d);
+
+    // Snapped outwards to whole pixels
+    ui_damage_add(d, make_box(10.25f, 20.5f, 5.5f, 4.25f));
+    uint16 count = 0;
+    const aabb_2d* regions = ui_damage_get_regions(d, &count);
+    test_check(count == 1, "expected 1 region, got %u", count);
+    if(count == 1) {
+        check_box(regions[0], 10, 20, 6, 5);
+    }
+
+    // Clipped to the screen, and ignored entirely when outside of it
+    ui_damage_clear(d);
+    ui_damage_add(d, make_box(-10, 90, 20, 20));
+    ui_damage_add(d, make_box(150, 150, 10, 10));
+    ui_damage_add(d, make_box(50, 50, 0, 10));
+    regions = ui_damage_get_regions(d, &count);
+    test_check(count == 1, "expected 1 region, got %u", count);
+    if(count == 1) {
+        check_box(regions[0], 0, 90, 10, 10);
+    }
+
+    ui_damage_free(d);
+}
+
+static void test_merge() {
+    ui_damage d = ui_damage_new(screen, 8);
+    ui_damage_clear(d);
+
+    // Overlapping boxes become their union
+    ui_damage_add(d, make_box(10, 10, 10, 10));
+    ui_damage_add(d, make_box(15, 15, 10, 10));
+    uint16 count = 0;
+    const aabb_2d* regions = ui_damage_get_regions(d, &count);
+    test_check(count == 1, "expected overlapping boxes to merge, got %u regions", count);
+    if(count == 1) {
+        check_box(regions[0], 10, 10, 15, 15);
+    }
+
+    // Flush neighbours merge, since that doesn't redraw anything extra
+    ui_damage_clear(d);
+    ui_damage_add(d, make_box(10, 10, 10, 10));
+    ui_damage_add(d, make_box(20, 10, 10, 10));
+    regions = ui_damage_get_regions(d, &count);
+    test_check(count == 1, "expected flush boxes to merge, got %u regions", count);
+    if(count == 1) {
+        check_box(regions[0], 10, 10, 20, 10);
+    }
+
+    // Distant boxes stay separate
+    ui_damage_clear(d);
+    ui_damage_add(d, make_box(0, 0, 10, 10));
+    ui_damage_add(d, make_box(50, 50, 10, 10));
+    ui_damage_get_regions(d, &count);
+    test_check(count == 2, "expected distant boxes to stay apart, got %u regions", count);
+
+    ui_damage_free(d);
+}
+
+// Once there are more regions than allowed, the cheapest pairs are folded together
+static void test_max_regions() {
+    const aabb_2d boxes[] = {
+        make_box(0, 0, 10, 10),
+        make_box(12, 0, 10, 10),
+        make_box(80, 80, 10, 10),
+        make_box(0, 80, 10, 10),
+        make_box(45, 45, 10, 10),
+    };
+    const uint32 box_count = sizeof(boxes) / sizeof(boxes[0]);
+
+    for(uint16 limit = 1; limit <= box_count; ++limit) {
+        ui_damage d = ui_damage_new(screen, limit);
+        ui_damage_clear(d);
+        for(uint32 i = 0; i < box_count; ++i) {
+            ui_damage_add(d, boxes[i]);
+        }
+
+        uint16 count = 0;
+        const aabb_2d* regions = ui_damage_get_regions(d, &count);
+        test_check(count >= 1 && count <= limit, "expected at most %u regions, got %u", limit, count);
+
+        // The two closest boxes are always the first to be folded
+        if(limit == box_count - 1) {
+            bool found = false;
+            for(uint16 i = 0; i < count; ++i) {
+                found = found || (contains(regions[i], boxes[0]) && contains(regions[i], boxes[1]));
+            }
+            test_check(found, "expected the closest pair to be merged with a limit of %u", limit);
+        }
+
+        for(uint32 i = 0; i < box_count; ++i) {
+            bool covered = false;
+            for(uint16 j = 0; j < count; ++j) {
+                covered = covered || contains(regions[j], boxes[i]);
+            }
+            test_check(covered, "box %u isn't covered with a limit of %u", i, limit);
+        }
+        for(uint16 i = 0; i < count; ++i) {
+            for(uint16 j = i + 1; j < count; ++j) {
+                test_check(!overlaps(regions[i], regions[j]), "regions %u and %u overlap with a limit of %u", i, j, limit);
+            }
+        }
+
+        ui_damage_free(d);
+    }
+}
+
+static void test_add_all() {
+    ui_damage d = ui_damage_new(screen, 4);
+    ui_damage_clear(d);
+    ui_damage_add(d, make_box(10, 10, 10, 10));
+    ui_damage_add_all(d);
+
+    uint16 count = 0;
+    const aabb_2d* regions = ui_damage_get_regions(d, &count);
+    test_check(count == 1, "expected 1 region, got %u", count);
+    if(count == 1) {
+        check_box(regions[0], 0, 0, 100, 100);
+    }
+
+    ui_damage_free(d);
+}
+
+int main() {
+    test_run(test_first_frame_is_full);
+    test_run(test_snap_and_clip);
+    test_run(test_merge);
+    test_run(test_max_regions);
+    test_run(test_add_all);
+
+    return test_result();
+}
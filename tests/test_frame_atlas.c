@@ -0,0 +1,96 @@
+// Tests for packing frames into an atlas and saving them, without a GL context
+
+#include "test.h"
+#include "frame_atlas.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char temp_folder[] = "/tmp/dfgame_ui_test.XXXXXX";
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+    return path;
+}
+
+// Makes frame data with a 4 pixel margin, cut from a 32x32 box at (16, 8) of a 64x64 texture
+static void make_test_data(frame_data* data, const char* asset_path) {
+    gltex tex = { .handle = 1, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 16, .y = 8 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_data_new_default(data, tex, box, 4);
+    data->asset_path = (char*)asset_path;
+}
+
+static void test_placeholder_isnt_ready() {
+    frame_image source;
+    frame_image_init(&source, 64, 64);
+    frame_data data;
+    make_test_data(&data, NULL);
+
+    frame_atlas a = frame_atlas_new(128, 128, 1);
+    uint16 page = frame_atlas_add_frame(a, &data, &source);
+    test_check(page == 0, "frame was packed into page %u", page);
+    test_check(!frame_data_is_ready(&data), "frame is ready before its page is uploaded");
+    test_check(data.texture.handle == 0, "placeholder has a texture handle");
+
+    // The source rectangle moves to the top left of the page
+    test_check_float(frame_data_get_box(&data).position.x, 0);
+    test_check_float(frame_data_get_box(&data).position.y, 0);
+
+    frame_atlas_free(a);
+    frame_image_cleanup(&source);
+}
+
+static void test_save_rejects_shared_names() {
+    frame_image source;
+    frame_image_init(&source, 64, 64);
+    frame_data frames[3];
+    uint16 pages[3];
+    make_test_data(&frames[0], "first/button.xml");
+    make_test_data(&frames[1], "second/button.xml");
+    make_test_data(&frames[2], "second/panel.xml");
+
+    frame_atlas a = frame_atlas_new(128, 128, 1);
+    for(uint32 i = 0; i < 3; ++i) {
+        pages[i] = frame_atlas_add_frame(a, &frames[i], &source);
+    }
+
+    char* page_path = make_temp_path("atlas0.png");
+    char* button_path = make_temp_path("button.xml");
+    char* panel_path = make_temp_path("panel.xml");
+
+    // Both buttons would be saved to button.xml, so nothing is written
+    test_check(!frame_atlas_save(a, temp_folder, "atlas", frames, pages, 3), "frames with the same name were saved");
+    test_check(access(page_path, F_OK) != 0, "page was written for a failed save");
+    test_check(access(button_path, F_OK) != 0, "frame was written for a failed save");
+
+    // Frames that weren't packed aren't saved, so they can't collide
+    pages[1] = FRAME_ATLAS_PAGE_INVALID;
+    test_check(frame_atlas_save(a, temp_folder, "atlas", frames, pages, 3), "frames with distinct names weren't saved");
+    test_check(access(page_path, F_OK) == 0, "page wasn't written");
+    test_check(access(button_path, F_OK) == 0 && access(panel_path, F_OK) == 0, "frames weren't written");
+
+    unlink(page_path);
+    unlink(button_path);
+    unlink(panel_path);
+    sfree(page_path);
+    sfree(button_path);
+    sfree(panel_path);
+    frame_atlas_free(a);
+    frame_image_cleanup(&source);
+}
+
+int main() {
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    test_run(test_placeholder_isnt_ready);
+    test_run(test_save_rejects_shared_names);
+
+    rmdir(temp_folder);
+    return test_result();
+}
@@ -0,0 +1,107 @@
+// Tests for grouping frames by texture and transforming their vertices in a frame batch, without a GL context
+
+#include "test.h"
+#include "frame_batch.h"
+
+// Makes frame data with a 4 pixel margin, cut from a 32x32 box. Textures only need a handle and a size to batch.
+static void make_test_data(frame_data* data, GLuint handle) {
+    gltex tex = { .handle = handle, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_data_new_default(data, tex, box, 4);
+}
+
+static mat4 make_translation(float x, float y) {
+    return mat4_translate(mat4_ident, (vec3){ .x = x, .y = y, .z = 0 });
+}
+
+// Checks that a run of batched vertices is the frame's own vertices, moved by (x, y)
+static void check_translated(const vt_pt* batched, frame f, float x, float y) {
+    uint32 count = 0;
+    const vt_pt* src = frame_get_vertices(f, &count);
+    for(uint32 i = 0; i < count; ++i) {
+        test_check_float(batched[i].position.x, src[i].position.x + x);
+        test_check_float(batched[i].position.y, src[i].position.y + y);
+        test_check_float(batched[i].uv.x, src[i].uv.x);
+        test_check_float(batched[i].uv.y, src[i].uv.y);
+    }
+}
+
+static void test_groups_by_texture() {
+    frame_data first_data, second_data;
+    make_test_data(&first_data, 1);
+    make_test_data(&second_data, 2);
+
+    frame a = frame_new(&first_data, (vec2){ .x = 40, .y = 20 });
+    frame b = frame_new(&second_data, (vec2){ .x = 16, .y = 16 });
+    frame c = frame_new(&first_data, (vec2){ .x = 100, .y = 50 });
+    uint32 per_frame = frame_get_vertex_count(&first_data, vec2_zero);
+
+    frame_batch batch = frame_batch_new();
+    frame_batch_add(batch, a, make_translation(10, 5));
+    frame_batch_add(batch, b, make_translation(0, 0));
+    frame_batch_add(batch, c, make_translation(-3, 7));
+
+    // Groups are created in the order their textures are first seen
+    test_check(frame_batch_get_group_count(batch) == 2, "expected 2 groups, got %u", frame_batch_get_group_count(batch));
+    test_check(frame_batch_get_vertex_count(batch) == per_frame * 3, "expected %u vertices, got %u", per_frame * 3, frame_batch_get_vertex_count(batch));
+
+    const frame_batch_group* first = frame_batch_get_group(batch, 0);
+    const frame_batch_group* second = frame_batch_get_group(batch, 1);
+    test_check(first->texture.handle == 1 && second->texture.handle == 2, "groups are out of order");
+    test_check(first->vert_count == per_frame * 2, "expected %u vertices in the first group, got %u", per_frame * 2, first->vert_count);
+    test_check(second->vert_count == per_frame, "expected %u vertices in the second group, got %u", per_frame, second->vert_count);
+
+    check_translated(first->verts, a, 10, 5);
+    check_translated(first->verts + per_frame, c, -3, 7);
+    check_translated(second->verts, b, 0, 0);
+
+    frame_batch_free(batch);
+    frame_free(a, false);
+    frame_free(b, false);
+    frame_free(c, false);
+}
+
+static void test_clear_reuses_storage() {
+    frame_data data;
+    make_test_data(&data, 1);
+    frame f = frame_new(&data, (vec2){ .x = 40, .y = 20 });
+
+    frame_batch batch = frame_batch_new();
+    frame_batch_add(batch, f, mat4_ident);
+    const vt_pt* verts = frame_batch_get_group(batch, 0)->verts;
+
+    frame_batch_clear(batch);
+    test_check(frame_batch_get_group_count(batch) == 0, "clear left %u groups", frame_batch_get_group_count(batch));
+    test_check(frame_batch_get_vertex_count(batch) == 0, "clear left %u vertices", frame_batch_get_vertex_count(batch));
+
+    frame_batch_add(batch, f, make_translation(1, 2));
+    test_check(frame_batch_get_group(batch, 0)->verts == verts, "vertex storage wasn't reused");
+    check_translated(frame_batch_get_group(batch, 0)->verts, f, 1, 2);
+
+    frame_batch_free(batch);
+    frame_free(f, false);
+}
+
+static void test_skips_frames_without_vertices() {
+    frame_data loading = { .texture = { .handle = 0, .width = 0, .height = 0 } };
+    frame empty = frame_new(NULL, (vec2){ .x = 10, .y = 10 });
+    frame pending = frame_new(&loading, (vec2){ .x = 10, .y = 10 });
+
+    frame_batch batch = frame_batch_new();
+    frame_batch_add(batch, empty, mat4_ident);
+    frame_batch_add(batch, pending, mat4_ident);
+    test_check(frame_batch_get_vertex_count(batch) == 0, "expected no vertices, got %u", frame_batch_get_vertex_count(batch));
+    test_check(frame_batch_get_group_count(batch) == 0, "expected no groups, got %u", frame_batch_get_group_count(batch));
+
+    frame_batch_free(batch);
+    frame_free(empty, false);
+    frame_free(pending, false);
+}
+
+int main() {
+    test_run(test_groups_by_texture);
+    test_run(test_clear_reuses_storage);
+    test_run(test_skips_frames_without_vertices);
+
+    return test_result();
+}
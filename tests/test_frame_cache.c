@@ -0,0 +1,143 @@
+// Tests that the frame cache shares frames and textures between loads, with a stub texture loader so that no GL context is needed
+
+#include "test.h"
+#include "frame_cache.h"
+#include "frame_io.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char temp_folder[] = "/tmp/dfgame_ui_test.XXXXXX";
+
+static uint32 texture_loads;
+static uint32 texture_releases;
+
+static gltex load_test_texture(const char* path, void* user) {
+    ++texture_loads;
+    return (gltex){ .handle = texture_loads, .width = 64, .height = 64 };
+}
+
+static void release_test_texture(gltex* tex, void* user) {
+    ++texture_releases;
+    tex->handle = 0;
+}
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+    return path;
+}
+
+static void write_frame(const char* path, const char* texture_name, uint16 margin) {
+    frame_data data = { 0 };
+    gltex tex = { .handle = 1, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_data_new_default(&data, tex, box, margin);
+    data.texture.asset_path = (char*)texture_name;
+
+    save_frame(path, &data);
+}
+
+static frame_cache make_cache() {
+    texture_loads = texture_releases = 0;
+
+    frame_cache c = frame_cache_new();
+    frame_cache_set_texture_loader(c, load_test_texture, release_test_texture, NULL);
+    return c;
+}
+
+static void test_shared_texture() {
+    char* a_path = make_temp_path("a.xml");
+    char* b_path = make_temp_path("b.xml");
+    write_frame(a_path, "shared.png", 4);
+    write_frame(b_path, "./shared.png", 6);
+
+    frame_cache c = make_cache();
+    frame_data* a = frame_cache_load(c, a_path);
+    frame_data* b = frame_cache_load(c, b_path);
+    test_check(a != NULL && b != NULL && a != b, "frames weren't loaded separately");
+    test_check(frame_cache_get_frame_count(c) == 2, "expected 2 frames, got %u", frame_cache_get_frame_count(c));
+    test_check(frame_cache_get_texture_count(c) == 1, "expected 1 texture, got %u", frame_cache_get_texture_count(c));
+    test_check(texture_loads == 1, "texture was loaded %u times", texture_loads);
+    test_check(a->texture.handle == b->texture.handle, "frames don't share their texture");
+
+    // The texture is only released along with the last frame using it
+    frame_cache_release(c, b);
+    test_check(texture_releases == 0, "texture was released while still in use");
+    test_check(frame_cache_get_texture_count(c) == 1, "texture was removed while still in use");
+    frame_cache_release(c, a);
+    test_check(texture_releases == 1, "texture was released %u times", texture_releases);
+    test_check(frame_cache_get_frame_count(c) == 0 && frame_cache_get_texture_count(c) == 0, "cache isn't empty");
+
+    frame_cache_free(c);
+    unlink(a_path);
+    unlink(b_path);
+    sfree(a_path);
+    sfree(b_path);
+}
+
+static void test_path_spellings() {
+    char* path = make_temp_path("a.xml");
+    char* other_spelling = make_temp_path(".//missing/../a.xml");
+    write_frame(path, "texture.png", 4);
+
+    frame_cache c = make_cache();
+    frame_data* first = frame_cache_load(c, path);
+    frame_data* second = frame_cache_load(c, other_spelling);
+    test_check(first != NULL && first == second, "the same file was loaded twice");
+    test_check(frame_cache_get_frame_count(c) == 1, "expected 1 frame, got %u", frame_cache_get_frame_count(c));
+    test_check(first != NULL && strcmp(first->asset_path, path) == 0, "asset path %s isn't normalized", first->asset_path);
+
+    // Both loads hold a reference
+    frame_cache_release(c, second);
+    test_check(frame_cache_get_frame_count(c) == 1, "frame was freed while still in use");
+    frame_cache_release(c, first);
+    test_check(frame_cache_get_frame_count(c) == 0, "frame wasn't freed");
+
+    frame_cache_free(c);
+    unlink(path);
+    sfree(path);
+    sfree(other_spelling);
+}
+
+static void test_reload_keeps_address() {
+    char* path = make_temp_path("a.xml");
+    char* other_spelling = make_temp_path("./a.xml");
+    write_frame(path, "first.png", 4);
+
+    frame_cache c = make_cache();
+    frame_data* data = frame_cache_load(c, path);
+    uint32 revision = data->revision;
+
+    write_frame(path, "second.png", 9);
+    test_check(frame_cache_reload(c, other_spelling), "frame wasn't reloaded");
+    test_check(frame_cache_load(c, path) == data, "reloaded data moved");
+    test_check(data->margins.left == 9, "reloaded data has margin %u", data->margins.left);
+    test_check(data->revision != revision, "reloaded data's revision didn't change");
+
+    // The first texture isn't used anymore, so it's released in favour of the second
+    test_check(texture_loads == 2 && texture_releases == 1, "textures were loaded %u times and released %u times", texture_loads, texture_releases);
+    test_check(frame_cache_get_texture_count(c) == 1, "expected 1 texture, got %u", frame_cache_get_texture_count(c));
+
+    frame_cache_release(c, data);
+    frame_cache_release(c, data);
+    frame_cache_free(c);
+    unlink(path);
+    sfree(path);
+    sfree(other_spelling);
+}
+
+int main() {
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    test_run(test_shared_texture);
+    test_run(test_path_spellings);
+    test_run(test_reload_keeps_address);
+
+    rmdir(temp_folder);
+    return test_result();
+}
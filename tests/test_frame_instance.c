@@ -0,0 +1,155 @@
+// Tests for packing frames into instance records, checked against the vertices frame_build_vertices makes
+
+#include "test.h"
+#include "frame_instance.h"
+
+#include <string.h>
+
+#define TEXTURE_SIZE 64
+
+// The corner of its slice that each of a slice's 6 vertices is at, in the order build_box writes them
+static const uint8 box_corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+
+// Makes frame data with a different margin on each side, cut from a 24x20 box at (8, 4)
+static void make_test_data(frame_data* data, GLuint handle, frame_fill center_fill) {
+    gltex tex = { .handle = handle, .width = TEXTURE_SIZE, .height = TEXTURE_SIZE };
+    aabb_2d box = { .position = { .x = 8, .y = 4 }, .dimensions = { .x = 24, .y = 20 } };
+    frame_margins margins = { .left = 2, .top = 3, .right = 5, .bottom = 7 };
+    frame_data_new(data, tex, box, margins, FRAME_FILL_STRETCH, center_fill);
+}
+
+// Makes a transform that scales by (2, 3), rotates by a quarter turn and moves by (100, 50)
+static mat4 make_test_transform() {
+    mat4 m = mat4_ident;
+    m.data[0] = 0;
+    m.data[1] = 2;
+    m.data[4] = -3;
+    m.data[5] = 0;
+    m.data[12] = 100;
+    m.data[13] = 50;
+    return m;
+}
+
+static vec2 transform_point(mat4 m, vec3 p) {
+    return (vec2) {
+        .x = m.data[0] * p.x + m.data[4] * p.y + m.data[12],
+        .y = m.data[1] * p.x + m.data[5] * p.y + m.data[13]
+    };
+}
+
+// Expands an instance the way frame_instance_vertex_source does, and checks it against the frame's vertices moved by m
+static void check_expansion(const frame_data* data, vec2 dims, alignment_2d align, mat4 m) {
+    frame_instance instance;
+    test_check(frame_instance_build(data, dims, align, m, &instance), "instance wasn't built");
+
+    float pos_x[4] = { -instance.margins.left, 0, instance.dims[0], instance.dims[0] + instance.margins.right };
+    float pos_y[4] = { -instance.margins.top, 0, instance.dims[1], instance.dims[1] + instance.margins.bottom };
+    float uv_x[4] = { 0, instance.margins.left, instance.uv_box[2] - instance.margins.right, instance.uv_box[2] };
+    float uv_y[4] = { 0, instance.margins.top, instance.uv_box[3] - instance.margins.bottom, instance.uv_box[3] };
+
+    vt_pt verts[FRAME_VERTEX_MAX];
+    uint32 count = frame_build_vertices(data, dims, align, verts);
+    test_check(count == FRAME_VERTEX_MAX, "expected %u vertices, got %u", FRAME_VERTEX_MAX, count);
+
+    for(uint32 v = 0; v < count; ++v) {
+        uint8 slice = v / 6;
+        uint8 column = slice % 3 + box_corners[v % 6][0];
+        uint8 row = slice / 3 + box_corners[v % 6][1];
+
+        vec2 expected = transform_point(m, verts[v].position);
+        test_check_float(instance.origin[0] + instance.axes[0] * pos_x[column] + instance.axes[2] * pos_y[row], expected.x);
+        test_check_float(instance.origin[1] + instance.axes[1] * pos_x[column] + instance.axes[3] * pos_y[row], expected.y);
+        test_check_float((instance.uv_box[0] + uv_x[column]) / TEXTURE_SIZE, verts[v].uv.x);
+        test_check_float((instance.uv_box[1] + uv_y[row]) / TEXTURE_SIZE, verts[v].uv.y);
+    }
+}
+
+static void test_record_fields() {
+    frame_data data;
+    make_test_data(&data, 1, FRAME_FILL_STRETCH);
+
+    frame_instance instance;
+    test_check(frame_instance_build(&data, (vec2){ .x = 40, .y = 30 }, ALIGN_DEFAULT, make_test_transform(), &instance), "instance wasn't built");
+
+    test_check_float(instance.axes[0], 0);
+    test_check_float(instance.axes[1], 2);
+    test_check_float(instance.axes[2], -3);
+    test_check_float(instance.axes[3], 0);
+    test_check_float(instance.origin[0], 100);
+    test_check_float(instance.origin[1], 50);
+    test_check_float(instance.dims[0], 40);
+    test_check_float(instance.dims[1], 30);
+    test_check_float(instance.uv_box[0], 8);
+    test_check_float(instance.uv_box[1], 4);
+    test_check_float(instance.uv_box[2], 24);
+    test_check_float(instance.uv_box[3], 20);
+    test_check(instance.margins.left == 2 && instance.margins.top == 3 && instance.margins.right == 5 && instance.margins.bottom == 7,
+               "margins weren't copied");
+}
+
+static void test_matches_vertices() {
+    frame_data data;
+    make_test_data(&data, 1, FRAME_FILL_STRETCH);
+
+    check_expansion(&data, (vec2){ .x = 40, .y = 30 }, ALIGN_DEFAULT, mat4_ident);
+    check_expansion(&data, (vec2){ .x = 40, .y = 30 }, ALIGN_DEFAULT, make_test_transform());
+    check_expansion(&data, (vec2){ .x = 17, .y = 9 }, ALIGN_CENTER, make_test_transform());
+}
+
+static void test_rejects_unsupported_data() {
+    frame_data tiled, loading;
+    make_test_data(&tiled, 1, FRAME_FILL_TILE);
+    make_test_data(&loading, 0, FRAME_FILL_STRETCH);
+    loading.texture.width = loading.texture.height = 0;
+
+    frame_instance instance;
+    test_check(!frame_instance_build(&tiled, (vec2){ .x = 40, .y = 30 }, ALIGN_DEFAULT, mat4_ident, &instance), "tiled data was instanced");
+    test_check(!frame_instance_build(&loading, (vec2){ .x = 40, .y = 30 }, ALIGN_DEFAULT, mat4_ident, &instance), "loading data was instanced");
+}
+
+static void test_batch_groups() {
+    frame_data first_data, second_data, tiled_data;
+    make_test_data(&first_data, 1, FRAME_FILL_STRETCH);
+    make_test_data(&second_data, 2, FRAME_FILL_STRETCH);
+    make_test_data(&tiled_data, 1, FRAME_FILL_TILE);
+
+    frame a = frame_new(&first_data, (vec2){ .x = 40, .y = 30 });
+    frame b = frame_new(&second_data, (vec2){ .x = 10, .y = 10 });
+    frame c = frame_new(&first_data, (vec2){ .x = 5, .y = 60 });
+    frame tiled = frame_new(&tiled_data, (vec2){ .x = 40, .y = 30 });
+
+    frame_instance_batch batch = frame_instance_batch_new();
+    test_check(frame_instance_batch_add(batch, a, mat4_ident), "frame wasn't added");
+    test_check(frame_instance_batch_add(batch, b, mat4_ident), "frame wasn't added");
+    test_check(frame_instance_batch_add(batch, c, make_test_transform()), "frame wasn't added");
+    test_check(!frame_instance_batch_add(batch, tiled, mat4_ident), "tiled frame was added");
+
+    test_check(frame_instance_batch_get_group_count(batch) == 2, "expected 2 groups, got %u", frame_instance_batch_get_group_count(batch));
+    test_check(frame_instance_batch_get_instance_count(batch) == 3, "expected 3 instances, got %u", frame_instance_batch_get_instance_count(batch));
+    test_check(frame_instance_batch_get_upload_size(batch) == 3 * sizeof(frame_instance), "upload size is %zu", frame_instance_batch_get_upload_size(batch));
+
+    // Each instance matches the record built directly from its frame
+    const frame_instance_group* first = frame_instance_batch_get_group(batch, 0);
+    frame_instance expected;
+    frame_instance_build(&first_data, c->dims, c->align, make_test_transform(), &expected);
+    test_check(first->texture.handle == 1 && first->instance_count == 2, "first group has %u instances", first->instance_count);
+    test_check(memcmp(&first->instances[1], &expected, sizeof(frame_instance)) == 0, "batched instance differs from its record");
+
+    frame_instance_batch_clear(batch);
+    test_check(frame_instance_batch_get_instance_count(batch) == 0, "clear left %u instances", frame_instance_batch_get_instance_count(batch));
+
+    frame_instance_batch_free(batch);
+    frame_free(a, false);
+    frame_free(b, false);
+    frame_free(c, false);
+    frame_free(tiled, false);
+}
+
+int main() {
+    test_run(test_record_fields);
+    test_run(test_matches_vertices);
+    test_run(test_rejects_unsupported_data);
+    test_run(test_batch_groups);
+
+    return test_result();
+}
@@ -0,0 +1,186 @@
+// Tests for loading frames on worker threads, with stub image functions so that no GL context is needed
+
+#include "test.h"
+#include "frame_io.h"
+#include "frame_loader.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char temp_folder[] = "/tmp/dfgame_ui_test.XXXXXX";
+
+// While closed, decodes wait for it to open, so that loads can be seen before a worker finishes them
+static atomic_bool decode_gate;
+static atomic_uint decode_count;
+static uint32 upload_count;
+
+static bool decode_test_image(const char* path, frame_image* image, void* user) {
+    while(!atomic_load(&decode_gate)) {
+        usleep(1000);
+    }
+
+    atomic_fetch_add(&decode_count, 1);
+    frame_image_init(image, 64, 64);
+    return true;
+}
+
+// Textures named bad.png fail to upload, and the rest get increasing handles
+static gltex upload_test_image(const char* path, const frame_image* image, void* user) {
+    if(strstr(path, "bad.png") != NULL) {
+        return (gltex){ 0 };
+    }
+
+    ++upload_count;
+    return (gltex){ .handle = upload_count, .width = image->width, .height = image->height };
+}
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+    return path;
+}
+
+static void write_frame(const char* path, const char* texture_name, uint16 margin) {
+    frame_data data = { 0 };
+    gltex tex = { .handle = 1, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_data_new_default(&data, tex, box, margin);
+    data.texture.asset_path = (char*)texture_name;
+
+    save_frame(path, &data);
+}
+
+static frame_loader make_loader() {
+    atomic_store(&decode_gate, true);
+    atomic_store(&decode_count, 0);
+    upload_count = 0;
+
+    frame_loader l = frame_loader_new(2);
+    frame_loader_set_image_funcs(l, decode_test_image, upload_test_image, NULL);
+    return l;
+}
+
+static void wait_for_idle(frame_loader l) {
+    while(!frame_loader_is_idle(l)) {
+        usleep(1000);
+    }
+}
+
+static void test_load_states() {
+    frame_loader l = make_loader();
+    char* paths[3] = { make_temp_path("a.xml"), make_temp_path("b.xml"), make_temp_path("c.xml") };
+    frame_data data[3];
+    frame_load_handle handles[3];
+
+    // Nothing is decoded until the gate opens
+    atomic_store(&decode_gate, false);
+    for(uint32 i = 0; i < 3; ++i) {
+        write_frame(paths[i], "texture.png", i + 1);
+        handles[i] = frame_loader_load(l, paths[i], &data[i]);
+        test_check(!frame_data_is_ready(&data[i]), "frame %u is ready before it's loaded", i);
+    }
+    for(uint32 i = 0; i < 3; ++i) {
+        test_check(frame_loader_get_state(l, handles[i]) == FRAME_LOAD_PENDING, "load %u isn't pending", i);
+    }
+    test_check(frame_loader_update(l, 3) == 0, "loads finished before they were decoded");
+
+    atomic_store(&decode_gate, true);
+    wait_for_idle(l);
+    for(uint32 i = 0; i < 3; ++i) {
+        test_check(frame_loader_get_state(l, handles[i]) == FRAME_LOAD_DECODED, "load %u isn't decoded", i);
+    }
+
+    // Only budget loads are uploaded per update
+    test_check(frame_loader_update(l, 2) == 2, "expected 2 uploads");
+    test_check(upload_count == 2, "%u textures were uploaded", upload_count);
+    test_check(frame_loader_update(l, 2) == 1, "expected 1 upload");
+    test_check(frame_loader_update(l, 2) == 0, "expected no uploads");
+
+    for(uint32 i = 0; i < 3; ++i) {
+        test_check(frame_loader_get_state(l, handles[i]) == FRAME_LOAD_READY, "load %u isn't ready", i);
+        test_check(frame_data_is_ready(&data[i]), "frame %u isn't ready", i);
+        test_check(data[i].margins.left == i + 1, "frame %u has margin %u", i, data[i].margins.left);
+        test_check(data[i].asset_path != NULL && strcmp(data[i].asset_path, paths[i]) == 0, "frame %u has the wrong asset path", i);
+        frame_loader_release(l, handles[i]);
+        sfree(data[i].asset_path);
+    }
+
+    frame_loader_free(l);
+    for(uint32 i = 0; i < 3; ++i) {
+        unlink(paths[i]);
+        sfree(paths[i]);
+    }
+}
+
+static void test_cancel() {
+    frame_loader l = make_loader();
+    char* path = make_temp_path("cancelled.xml");
+    write_frame(path, "texture.png", 4);
+
+    // Released while a worker is decoding it
+    frame_data pending;
+    atomic_store(&decode_gate, false);
+    frame_load_handle h = frame_loader_load(l, path, &pending);
+    frame_loader_release(l, h);
+    atomic_store(&decode_gate, true);
+    wait_for_idle(l);
+    test_check(frame_loader_update(l, 4) == 0, "cancelled load was uploaded");
+
+    // Released once it's decoded, before its upload
+    frame_data decoded;
+    h = frame_loader_load(l, path, &decoded);
+    wait_for_idle(l);
+    test_check(frame_loader_get_state(l, h) == FRAME_LOAD_DECODED, "load isn't decoded");
+    frame_loader_release(l, h);
+    test_check(frame_loader_update(l, 4) == 0, "cancelled load was uploaded");
+
+    test_check(upload_count == 0, "%u textures were uploaded", upload_count);
+    test_check(!frame_data_is_ready(&pending) && !frame_data_is_ready(&decoded), "cancelled frame data was written");
+
+    frame_loader_free(l);
+    unlink(path);
+    sfree(path);
+}
+
+static void test_failed_loads() {
+    frame_loader l = make_loader();
+    char* missing_path = make_temp_path("missing.xml");
+    char* bad_path = make_temp_path("bad.xml");
+    write_frame(bad_path, "bad.png", 4);
+
+    frame_data missing, bad;
+    frame_load_handle missing_handle = frame_loader_load(l, missing_path, &missing);
+    frame_load_handle bad_handle = frame_loader_load(l, bad_path, &bad);
+    wait_for_idle(l);
+
+    // A missing file fails on the worker, without reaching the decoder
+    test_check(frame_loader_get_state(l, missing_handle) == FRAME_LOAD_FAILED, "missing frame didn't fail");
+    test_check(atomic_load(&decode_count) == 1, "%u images were decoded", atomic_load(&decode_count));
+
+    // A texture that fails to upload fails the load
+    test_check(frame_loader_update(l, 4) == 1, "expected 1 finished load");
+    test_check(frame_loader_get_state(l, bad_handle) == FRAME_LOAD_FAILED, "failed upload didn't fail the load");
+    test_check(!frame_data_is_ready(&missing) && !frame_data_is_ready(&bad), "failed frame data is ready");
+
+    // Neither handle is released, so freeing the loader frees them
+    frame_loader_free(l);
+    unlink(bad_path);
+    sfree(missing_path);
+    sfree(bad_path);
+}
+
+int main() {
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    test_run(test_load_states);
+    test_run(test_cancel);
+    test_run(test_failed_loads);
+
+    rmdir(temp_folder);
+    return test_result();
+}
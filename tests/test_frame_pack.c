@@ -0,0 +1,100 @@
+// Tests for building frame packs and finding frames in them by path
+
+#include "test.h"
+#include "frame_io.h"
+#include "frame_pack.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FRAME_COUNT 50
+
+static char temp_folder[] = "/tmp/dfgame_ui_test.XXXXXX";
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+    return path;
+}
+
+static void write_frame(const char* path, uint16 margin) {
+    frame_data data = { 0 };
+    gltex tex = { .handle = 1, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_data_new_default(&data, tex, box, margin);
+    data.texture.asset_path = "texture.png";
+
+    save_frame(path, &data);
+}
+
+static void test_find() {
+    // Files are named out of order, so the build order isn't already sorted
+    char* paths[FRAME_COUNT + 1];
+    char name[32];
+    for(uint32 i = 0; i < FRAME_COUNT; ++i) {
+        snprintf(name, sizeof(name), "frame%u.xml", (i * 37) % FRAME_COUNT);
+        paths[i] = make_temp_path(name);
+        write_frame(paths[i], i);
+    }
+
+    // The last frame repeats the first path, which should still find the first frame
+    paths[FRAME_COUNT] = paths[0];
+
+    char* pack_path = make_temp_path("frames.dffp");
+    test_check(frame_pack_build(pack_path, (const char* const*)paths, FRAME_COUNT + 1), "pack wasn't built");
+
+    frame_pack p = frame_pack_open(pack_path);
+    test_check(p != NULL, "pack wasn't opened");
+    if(p != NULL) {
+        test_check(frame_pack_get_count(p) == FRAME_COUNT + 1, "expected %u frames, got %u", FRAME_COUNT + 1, frame_pack_get_count(p));
+
+        for(uint32 i = 0; i < FRAME_COUNT; ++i) {
+            uint32 index = frame_pack_find(p, paths[i]);
+            test_check(index == i, "found %s at %u instead of %u", paths[i], index, i);
+            test_check(frame_pack_get_margins(p, i).left == i, "frame %u has the wrong margins", i);
+        }
+
+        char* missing = make_temp_path("missing.xml");
+        test_check(frame_pack_find(p, missing) == CONTAINER_INDEX_INVALID, "found a path that isn't in the pack");
+        test_check(frame_pack_find(p, "") == CONTAINER_INDEX_INVALID, "found an empty path");
+        sfree(missing);
+
+        frame_pack_close(p);
+    }
+
+    unlink(pack_path);
+    sfree(pack_path);
+    for(uint32 i = 0; i < FRAME_COUNT; ++i) {
+        unlink(paths[i]);
+        sfree(paths[i]);
+    }
+}
+
+static void test_empty_pack() {
+    char* pack_path = make_temp_path("empty.dffp");
+    test_check(frame_pack_build(pack_path, NULL, 0), "empty pack wasn't built");
+
+    frame_pack p = frame_pack_open(pack_path);
+    test_check(p != NULL, "empty pack wasn't opened");
+    if(p != NULL) {
+        test_check(frame_pack_find(p, "frame.xml") == CONTAINER_INDEX_INVALID, "found a frame in an empty pack");
+        frame_pack_close(p);
+    }
+
+    unlink(pack_path);
+    sfree(pack_path);
+}
+
+int main() {
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    test_run(test_find);
+    test_run(test_empty_pack);
+
+    rmdir(temp_folder);
+    return test_result();
+}
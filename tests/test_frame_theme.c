@@ -0,0 +1,95 @@
+// Tests for loading themes, including skins that reference separate frame files and skins that share a name
+
+#include "test.h"
+#include "frame_io.h"
+#include "frame_theme.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static char temp_folder[] = "/tmp/dfgame_ui_test.XXXXXX";
+
+static const char* test_theme =
+    "<theme>\n"
+    "  <skin name=\"button\"><frame margin=\"4\" position=\"0 0\" dimensions=\"32 32\" texture=\"ui.png\"/></skin>\n"
+    "  <skin name=\"panel\"><frame path=\"frames/panel.xml\"/></skin>\n"
+    "  <skin name=\"button\"><frame margin=\"7\" position=\"0 0\" dimensions=\"32 32\" texture=\"other.png\"/></skin>\n"
+    "  <skin name=\"alert\"><frame margin=\"2\" position=\"0 0\" dimensions=\"16 16\" texture=\"ui.png\"/></skin>\n"
+    "  <skin name=\"button\"><frame margin=\"9\" position=\"0 0\" dimensions=\"32 32\" texture=\"other.png\"/></skin>\n"
+    "</theme>\n";
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+    return path;
+}
+
+static void write_frame(const char* path, const char* texture_name, uint16 margin) {
+    frame_data data = { 0 };
+    gltex tex = { .handle = 1, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_data_new_default(&data, tex, box, margin);
+    data.texture.asset_path = (char*)texture_name;
+
+    save_frame(path, &data);
+}
+
+static void test_load() {
+    char* frames_folder = make_temp_path("frames");
+    char* frame_path = make_temp_path("frames/panel.xml");
+    char* theme_path = make_temp_path("theme.xml");
+    mkdir(frames_folder, 0700);
+    write_frame(frame_path, "panel.png", 5);
+
+    FILE* file = fopen(theme_path, "w");
+    fputs(test_theme, file);
+    fclose(file);
+
+    frame_theme t = frame_theme_load(theme_path, NULL);
+    test_check(t != NULL, "theme wasn't loaded");
+    if(t == NULL) {
+        return;
+    }
+
+    // Skins are sorted by name, and duplicates are dropped
+    test_check(frame_theme_get_count(t) == 3, "expected 3 skins, got %u", frame_theme_get_count(t));
+    const char* expected_names[] = { "alert", "button", "panel" };
+    for(uint32 i = 0; i < 3 && i < frame_theme_get_count(t); ++i) {
+        test_check(strcmp(frame_theme_get_name(t, i), expected_names[i]) == 0, "skin %u is %s", i, frame_theme_get_name(t, i));
+    }
+
+    // The first skin named button wins
+    frame_data* button = frame_theme_find(t, "button");
+    test_check(button != NULL && button->margins.left == 4, "kept the wrong button skin");
+
+    // The panel's frame file is found relative to the theme, and its texture relative to the frame file
+    frame_data* panel = frame_theme_find(t, "panel");
+    char* texture_path = make_temp_path("frames/panel.png");
+    test_check(panel != NULL && panel->margins.left == 5, "panel's frame file wasn't loaded");
+    test_check(panel != NULL && panel->texture.asset_path != NULL && strcmp(panel->texture.asset_path, texture_path) == 0,
+               "panel's texture path is %s", panel != NULL ? panel->texture.asset_path : NULL);
+    test_check(frame_theme_find(t, "missing") == NULL, "found a skin that isn't in the theme");
+
+    frame_theme_free(t);
+    unlink(frame_path);
+    unlink(theme_path);
+    rmdir(frames_folder);
+    sfree(texture_path);
+    sfree(frames_folder);
+    sfree(frame_path);
+    sfree(theme_path);
+}
+
+int main() {
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    test_run(test_load);
+
+    rmdir(temp_folder);
+    return test_result();
+}
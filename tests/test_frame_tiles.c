@@ -0,0 +1,73 @@
+// Tests that tiled frames are split into the expected number of tiles, and stretched when they'd need too many
+
+#include "test.h"
+#include "frame.h"
+
+#include <math.h>
+
+// Makes frame data with tiled edges and center, and a 4 pixel margin around a 24x24 center
+static void make_tiled_data(frame_data* data) {
+    gltex tex = { .handle = 1, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_margins margins = { .left = 4, .top = 4, .right = 4, .bottom = 4 };
+    frame_data_new(data, tex, box, margins, FRAME_FILL_TILE, FRAME_FILL_TILE);
+}
+
+// Builds a frame's vertices, and checks that their number matches frame_get_vertex_count
+static uint32 build_checked(const frame_data* data, vec2 dims) {
+    uint32 count = frame_get_vertex_count(data, dims);
+    vt_pt* verts = scalloc(count == 0 ? 1 : count, sizeof(vt_pt));
+    uint32 built = frame_build_vertices(data, dims, ALIGN_DEFAULT, verts);
+    test_check(built == count, "counted %u vertices, but built %u", count, built);
+    sfree(verts);
+
+    return count;
+}
+
+static void test_tile_counts() {
+    frame_data data;
+    make_tiled_data(&data);
+
+    // A 60x30 center needs 3x2 tiles, each edge covers 60 or 30 pixels, and corners are single boxes
+    uint32 count = build_checked(&data, (vec2){ .x = 60, .y = 30 });
+    uint32 expected = (4 + 3 + 3 + 2 + 2 + 3 * 2) * 6;
+    test_check(count == expected, "expected %u vertices, got %u", expected, count);
+}
+
+static void test_limit_stretches() {
+    frame_data data;
+    make_tiled_data(&data);
+
+    // The center would need 100x100 tiles, and each edge stays under the limit
+    uint32 count = build_checked(&data, (vec2){ .x = 2400, .y = 2400 });
+    uint32 expected = (4 + 4 * 100 + 1) * 6;
+    test_check(count == expected, "expected %u vertices, got %u", expected, count);
+
+    // Once the edges need too many tiles too, every slice is stretched
+    count = build_checked(&data, (vec2){ .x = 24 * (FRAME_TILE_MAX + 1), .y = 24 * (FRAME_TILE_MAX + 1) });
+    test_check(count == FRAME_VERTEX_MAX, "expected %u vertices, got %u", FRAME_VERTEX_MAX, count);
+
+    // An infinitely wide frame stretches its center and horizontal edges, and still tiles the 30 pixel vertical edges
+    count = build_checked(&data, (vec2){ .x = INFINITY, .y = 30 });
+    expected = (4 + 1 + 1 + 2 + 2 + 1) * 6;
+    test_check(count == expected, "expected %u vertices, got %u", expected, count);
+
+    // A frame only warns about stretching once, however often it's rebuilt
+    frame f = frame_new(&data, (vec2){ .x = 2400, .y = 2400 });
+    test_check(!f->warned_tile_limit, "frame warned before it was built");
+    frame_rebuild_mesh(f);
+    test_check(f->warned_tile_limit, "stretched frame didn't warn");
+    frame_set_dimensions(f, (vec2){ .x = 60, .y = 30 });
+    frame_rebuild_mesh(f);
+    frame_set_dimensions(f, (vec2){ .x = 2400, .y = 2400 });
+    frame_rebuild_mesh(f);
+    test_check(f->warned_tile_limit && f->vert_count == (4 + 4 * 100 + 1) * 6, "stretched frame has %u vertices", f->vert_count);
+    frame_free(f, false);
+}
+
+int main() {
+    test_run(test_tile_counts);
+    test_run(test_limit_stretches);
+
+    return test_result();
+}
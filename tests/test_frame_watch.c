@@ -0,0 +1,140 @@
+// Tests that a polling frame watcher reloads rewritten frame files and textures, and only dirties the frames using them
+
+#include "test.h"
+#include "frame.h"
+#include "frame_io.h"
+#include "frame_watch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char temp_folder[] = "/tmp/dfgame_ui_test.XXXXXX";
+
+// Textures are never read, so first.png loads as handle 1 and second.png as handle 2. Each load is counted.
+static uint32 texture_loads[2];
+
+static gltex load_test_texture(const char* path, void* user) {
+    uint32 i = strstr(path, "first.png") != NULL ? 0 : 1;
+    ++texture_loads[i];
+    return (gltex){ .handle = i + 1, .width = 64, .height = 64 };
+}
+
+static void release_test_texture(gltex* tex, void* user) {
+    tex->handle = 0;
+}
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+    return path;
+}
+
+// Writes a frame file using the texture at texture_name, next to it in the temp folder
+static void write_frame(const char* path, const char* texture_name, uint16 margin) {
+    frame_data data = { 0 };
+    gltex tex = { .handle = 1, .width = 64, .height = 64 };
+    aabb_2d box = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 32, .y = 32 } };
+    frame_data_new_default(&data, tex, box, margin);
+    data.texture.asset_path = (char*)texture_name;
+
+    save_frame(path, &data);
+}
+
+// Writes a fake texture file. Its size changes with length, so the rewrite is seen even within the file system's timestamp resolution.
+static void write_texture(const char* path, uint32 length) {
+    FILE* file = fopen(path, "w");
+    for(uint32 i = 0; i < length; ++i) {
+        fputc('x', file);
+    }
+    fclose(file);
+}
+
+// Gets a frame's vertices, so that it's no longer dirty
+static void settle(frame f) {
+    frame_get_vertices(f, NULL);
+}
+
+static void test_polling_reload() {
+    texture_loads[0] = texture_loads[1] = 0;
+
+    char* first_texture = make_temp_path("first.png");
+    char* second_texture = make_temp_path("second.png");
+    char* a_path = make_temp_path("a.xml");
+    char* b_path = make_temp_path("b.xml");
+    char* c_path = make_temp_path("c.xml");
+    write_texture(first_texture, 10);
+    write_texture(second_texture, 10);
+    write_frame(a_path, "first.png", 4);
+    write_frame(b_path, "first.png", 4);
+    write_frame(c_path, "second.png", 4);
+
+    frame_cache cache = frame_cache_new();
+    frame_cache_set_texture_loader(cache, load_test_texture, release_test_texture, NULL);
+    frame_data* a_data = frame_cache_load(cache, a_path);
+    frame_data* b_data = frame_cache_load(cache, b_path);
+    frame_data* c_data = frame_cache_load(cache, c_path);
+    test_check(a_data != NULL && b_data != NULL && c_data != NULL, "frames weren't loaded");
+    test_check(texture_loads[0] == 1 && texture_loads[1] == 1, "textures were loaded %u and %u times", texture_loads[0], texture_loads[1]);
+
+    vec2 dims = { .x = 100, .y = 50 };
+    frame a = frame_new(a_data, dims);
+    frame b = frame_new(b_data, dims);
+    frame c = frame_new(c_data, dims);
+    settle(a);
+    settle(b);
+    settle(c);
+
+    frame_watcher watcher = frame_watcher_new(cache, true);
+    test_check(frame_watcher_is_polling(watcher), "watcher isn't polling");
+    test_check(frame_watcher_update(watcher) == 0, "unchanged files were reloaded");
+
+    // Rewriting a frame file only dirties the frame using it
+    write_frame(a_path, "first.png", 12);
+    test_check(frame_watcher_update(watcher) == 1, "expected 1 reload");
+    test_check(a_data->margins.left == 12, "frame data wasn't replaced, margin is %u", a_data->margins.left);
+    test_check(frame_needs_rebuild(a), "rewritten frame isn't dirty");
+    test_check(!frame_needs_rebuild(b) && !frame_needs_rebuild(c), "unchanged frames are dirty");
+    test_check(texture_loads[0] == 1, "unchanged texture was reloaded");
+    settle(a);
+
+    // Rewriting a texture dirties every frame using it, and no others
+    write_texture(first_texture, 20);
+    test_check(frame_watcher_update(watcher) == 1, "expected 1 reload");
+    test_check(texture_loads[0] == 2 && texture_loads[1] == 1, "textures were loaded %u and %u times", texture_loads[0], texture_loads[1]);
+    test_check(frame_needs_rebuild(a) && frame_needs_rebuild(b), "frames using the texture aren't dirty");
+    test_check(!frame_needs_rebuild(c), "frame using another texture is dirty");
+    settle(a);
+    settle(b);
+
+    // Nothing changed since the last update
+    test_check(frame_watcher_update(watcher) == 0, "unchanged files were reloaded");
+    test_check(!frame_needs_rebuild(a) && !frame_needs_rebuild(b) && !frame_needs_rebuild(c), "frames are dirty without changes");
+
+    frame_watcher_free(watcher);
+    frame_free(a, false);
+    frame_free(b, false);
+    frame_free(c, false);
+    frame_cache_release(cache, a_data);
+    frame_cache_release(cache, b_data);
+    frame_cache_release(cache, c_data);
+    frame_cache_free(cache);
+
+    char* paths[] = { first_texture, second_texture, a_path, b_path, c_path };
+    for(uint32 i = 0; i < 5; ++i) {
+        unlink(paths[i]);
+        sfree(paths[i]);
+    }
+}
+
+int main() {
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    test_run(test_polling_reload);
+
+    rmdir(temp_folder);
+    return test_result();
+}
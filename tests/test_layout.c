@@ -0,0 +1,164 @@
+// Tests for adding elements to layouts, and for only re-solving the layouts that changed
+
+#include "test.h"
+#include "layout.h"
+
+#include <string.h>
+
+static void test_initialized_elements() {
+    layout l;
+    layout_init(&l, (vec2){ .x = 100, .y = 100 }, LAYOUT_STACK_VERTICAL);
+
+    // Fill the elements with garbage first, like uninitialized stack memory
+    layout_element elements[3];
+    memset(elements, 0xAB, sizeof(elements));
+    for(uint32 i = 0; i < 3; ++i) {
+        layout_element_init(&elements[i], (vec2){ .x = 10, .y = 20 });
+        layout_add_element(&l, &elements[i]);
+    }
+
+    layout_update(&l);
+    for(uint32 i = 0; i < 3; ++i) {
+        test_check_float(elements[i].calculated_bounds.position.y, i * 20);
+        test_check_float(elements[i].calculated_bounds.dimensions.x, 10);
+        test_check_float(elements[i].calculated_bounds.dimensions.y, 20);
+    }
+
+    layout_cleanup(&l);
+}
+
+static void test_add_resets_bookkeeping() {
+    layout l, child;
+    layout_init(&l, (vec2){ .x = 100, .y = 100 }, LAYOUT_STACK_HORIZONTAL);
+    layout_init(&child, (vec2){ .x = 30, .y = 30 }, LAYOUT_FREE);
+
+    // Only the inputs are set, and the rest is left as garbage
+    layout_element elem;
+    memset(&elem, 0xAB, sizeof(elem));
+    elem.requested_dims = (vec2){ .x = 40, .y = 10 };
+    elem.padding = vec2_zero;
+    elem.align = ALIGN_DEFAULT;
+    layout_add_element(&l, &elem);
+    layout_add_layout(&l, &child);
+
+    test_check(elem.parent == &l, "element's parent wasn't set");
+    test_check(elem.sublayout == NULL, "element's nested layout wasn't cleared");
+    test_check(elem.index == NULL, "element's index wasn't cleared");
+    test_check(child.bounds.sublayout == &child, "nested layout lost its bounds' link");
+
+    layout_update(&l);
+    test_check_float(elem.calculated_bounds.dimensions.x, 40);
+    test_check_float(child.bounds.calculated_bounds.position.x, 40);
+
+    layout_cleanup(&child);
+    layout_cleanup(&l);
+}
+
+// A vertical stack of two horizontal stacks, each holding two elements
+typedef struct nested_tree {
+    layout root;
+    layout rows[2];
+    layout_element elements[4];
+} nested_tree;
+
+static void make_nested_tree(nested_tree* t) {
+    layout_init(&t->root, (vec2){ .x = 100, .y = 100 }, LAYOUT_STACK_VERTICAL);
+    for(uint32 r = 0; r < 2; ++r) {
+        layout_init(&t->rows[r], (vec2){ .x = 100, .y = 30 }, LAYOUT_STACK_HORIZONTAL);
+        layout_add_layout(&t->root, &t->rows[r]);
+        for(uint32 i = 0; i < 2; ++i) {
+            layout_element_init(&t->elements[r * 2 + i], (vec2){ .x = 20, .y = 10 });
+            layout_add_element(&t->rows[r], &t->elements[r * 2 + i]);
+        }
+    }
+
+    layout_update(&t->root);
+}
+
+static void cleanup_nested_tree(nested_tree* t) {
+    layout_cleanup(&t->rows[0]);
+    layout_cleanup(&t->rows[1]);
+    layout_cleanup(&t->root);
+}
+
+static void test_unchanged_update() {
+    nested_tree t;
+    make_nested_tree(&t);
+    test_check(layout_get_solve_count(&t.root) == 6, "first update solved %u elements", layout_get_solve_count(&t.root));
+
+    layout_update(&t.root);
+    test_check(layout_get_solve_count(&t.root) == 0, "unchanged update solved %u elements", layout_get_solve_count(&t.root));
+
+    cleanup_nested_tree(&t);
+}
+
+static void test_nested_change() {
+    nested_tree t;
+    make_nested_tree(&t);
+
+    // Only the row holding the element is re-solved
+    layout_element_set_requested_dims(&t.elements[3], (vec2){ .x = 35, .y = 10 });
+    layout_update(&t.root);
+    test_check(layout_get_solve_count(&t.root) == 2, "expected 2 solved elements, got %u", layout_get_solve_count(&t.root));
+    test_check(layout_get_solve_count(&t.rows[0]) == 0, "unchanged row solved %u elements", layout_get_solve_count(&t.rows[0]));
+    test_check(layout_get_solve_count(&t.rows[1]) == 2, "changed row solved %u elements", layout_get_solve_count(&t.rows[1]));
+    test_check_float(t.elements[3].calculated_bounds.dimensions.x, 35);
+
+    cleanup_nested_tree(&t);
+}
+
+static void test_parent_move() {
+    nested_tree t;
+    make_nested_tree(&t);
+
+    // Moving the first row pushes the second down, and both rows' elements have to follow
+    layout_element_set_requested_dims(&t.rows[0].bounds, (vec2){ .x = 100, .y = 45 });
+    layout_update(&t.root);
+    test_check(layout_get_solve_count(&t.root) == 6, "expected 6 solved elements, got %u", layout_get_solve_count(&t.root));
+    test_check_float(t.elements[2].calculated_bounds.position.y, 45);
+
+    // Moving the root re-solves everything below it
+    t.root.bounds.calculated_bounds.position = (vec2){ .x = 10, .y = 5 };
+    layout_update(&t.root);
+    test_check(layout_get_solve_count(&t.root) == 6, "expected 6 solved elements, got %u", layout_get_solve_count(&t.root));
+    test_check_float(t.elements[1].calculated_bounds.position.x, 30);
+    test_check_float(t.elements[2].calculated_bounds.position.y, 50);
+
+    cleanup_nested_tree(&t);
+}
+
+static void test_cleanup_detaches_children() {
+    layout l;
+    layout_init(&l, (vec2){ .x = 100, .y = 100 }, LAYOUT_STACK_VERTICAL);
+    layout_element elem;
+    layout_element_init(&elem, (vec2){ .x = 10, .y = 10 });
+    layout_add_element(&l, &elem);
+    layout_cleanup(&l);
+
+    // The layout is gone, so changing the element mustn't touch it
+    test_check(elem.parent == NULL, "element still points at its cleaned up layout");
+    memset(&l, 0xAB, sizeof(l));
+    layout_element_set_requested_dims(&elem, (vec2){ .x = 20, .y = 20 });
+}
+
+static void test_null_layouts() {
+    // These log an error instead of crashing
+    layout_set_columns(NULL, 2);
+    layout_set_spacing(NULL, vec2_zero);
+    layout_set_wrap(NULL, true);
+    layout_set_damage(NULL, NULL);
+    layout_add_element(NULL, NULL);
+    layout_cleanup(NULL);
+}
+
+int main() {
+    test_run(test_initialized_elements);
+    test_run(test_add_resets_bookkeeping);
+    test_run(test_unchanged_update);
+    test_run(test_nested_change);
+    test_run(test_parent_move);
+    test_run(test_cleanup_detaches_children);
+    test_run(test_null_layouts);
+
+    return test_result();
+}
@@ -0,0 +1,95 @@
+// Tests that flat layouts give bit-identical results to layouts of separate elements
+
+#include "test.h"
+#include "layout.h"
+#include "layout_flat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Not a multiple of any vector width, so the scalar tails of the vector passes are covered too
+#define ELEMENT_COUNT 1003
+
+static float random_float(float low, float high) {
+    return low + (high - low) * ((float)rand() / (float)RAND_MAX);
+}
+
+// Solves the same random elements with a layout and a flat layout, and counts the elements whose bounds differ in any bit
+static uint32 compare_layouts(layout_type type, vec2 bounds, uint32 count) {
+    layout l;
+    layout_flat flat;
+    layout_init(&l, bounds, type);
+    layout_flat_init(&flat, bounds, type);
+    layout_element* elements = scalloc(count, sizeof(layout_element));
+
+    for(uint32 i = 0; i < count; ++i) {
+        // Some elements have padding wider than the layout, which gives the clamp a negative upper limit
+        vec2 padding = { .x = random_float(0, 4), .y = random_float(0, 4) };
+        if(rand() % 50 == 0) {
+            padding = vec2_mul(bounds, 0.75f);
+        }
+
+        elements[i].requested_dims = (vec2){ .x = random_float(-5, 60), .y = random_float(-5, 60) };
+        elements[i].padding = padding;
+        elements[i].align = (alignment_2d)(rand() % (ALIGN_LAST + 1));
+        layout_add_element(&l, &elements[i]);
+        layout_flat_add_element(&flat, elements[i].requested_dims, padding, elements[i].align);
+    }
+
+    layout_update(&l);
+    layout_flat_update(&flat);
+
+    uint32 mismatches = 0;
+    for(uint32 i = 0; i < count; ++i) {
+        aabb_2d expected = elements[i].calculated_bounds;
+        aabb_2d actual = layout_flat_get_bounds(&flat, i);
+        if(memcmp(&expected, &actual, sizeof(aabb_2d)) != 0) {
+            ++mismatches;
+        }
+    }
+
+    layout_cleanup(&l);
+    layout_flat_cleanup(&flat);
+    sfree(elements);
+
+    return mismatches;
+}
+
+static void check_type(layout_type type) {
+    // Large bounds leave room to spare, and small ones make the stacks overflow and rescale
+    const vec2 sizes[] = {
+        { .x = 100000, .y = 100000 },
+        { .x = 1920, .y = 1080 },
+        { .x = 37, .y = 23 },
+    };
+
+    for(uint32 s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        for(uint32 count = 1; count <= ELEMENT_COUNT; count += ELEMENT_COUNT / 3) {
+            uint32 mismatches = compare_layouts(type, sizes[s], count);
+            test_check(mismatches == 0, "%u of %u elements differ in %gx%g bounds", mismatches, count, sizes[s].x, sizes[s].y);
+        }
+    }
+}
+
+static void test_free() {
+    srand(1);
+    check_type(LAYOUT_FREE);
+}
+
+static void test_stack_horizontal() {
+    srand(2);
+    check_type(LAYOUT_STACK_HORIZONTAL);
+}
+
+static void test_stack_vertical() {
+    srand(3);
+    check_type(LAYOUT_STACK_VERTICAL);
+}
+
+int main() {
+    test_run(test_free);
+    test_run(test_stack_horizontal);
+    test_run(test_stack_vertical);
+
+    return test_result();
+}
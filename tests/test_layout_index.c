@@ -0,0 +1,200 @@
+// Tests for hit-testing layout elements with a layout index, checked against a linear scan
+
+#include "test.h"
+#include "layout.h"
+#include "layout_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ELEMENT_COUNT 200
+
+static const aabb_2d index_area = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 200, .y = 200 } };
+static const vec2 cell_size = { .x = 25, .y = 25 };
+
+static float random_float(float low, float high) {
+    return low + (high - low) * ((float)rand() / (float)RAND_MAX);
+}
+
+static void set_bounds(layout_element* elem, float x, float y, float width, float height) {
+    elem->calculated_bounds = (aabb_2d){ .position = { .x = x, .y = y }, .dimensions = { .x = width, .y = height } };
+}
+
+static bool contains_point(aabb_2d box, vec2 point) {
+    return point.x >= box.position.x && point.x <= box.position.x + box.dimensions.x &&
+           point.y >= box.position.y && point.y <= box.position.y + box.dimensions.y;
+}
+
+static bool overlaps(aabb_2d a, aabb_2d b) {
+    return a.position.x <= b.position.x + b.dimensions.x && b.position.x <= a.position.x + a.dimensions.x &&
+           a.position.y <= b.position.y + b.dimensions.y && b.position.y <= a.position.y + a.dimensions.y;
+}
+
+static void test_spanning_element() {
+    layout_index idx = layout_index_new(index_area, cell_size);
+    layout_element wide, small;
+    layout_element_init(&wide, vec2_zero);
+    layout_element_init(&small, vec2_zero);
+    set_bounds(&wide, 10, 10, 120, 80);
+    set_bounds(&small, 60, 40, 5, 5);
+    layout_index_update(idx, &wide);
+    layout_index_update(idx, &small);
+    test_check(layout_index_get_count(idx) == 2, "expected 2 elements, got %u", layout_index_get_count(idx));
+
+    // The wide element covers 24 cells, and the query 16 of them
+    layout_element* found[8];
+    aabb_2d query = { .position = { .x = 30, .y = 30 }, .dimensions = { .x = 90, .y = 60 } };
+    uint32 count = layout_index_query_rect(idx, query, found, 8);
+    test_check(count == 2, "expected 2 elements, got %u", count);
+    test_check(count == 2 && found[0] != found[1], "an element was reported twice");
+
+    // The smallest element under a point wins
+    test_check(layout_index_query_point(idx, (vec2){ .x = 62, .y = 42 }) == &small, "small element wasn't found");
+    test_check(layout_index_query_point(idx, (vec2){ .x = 100, .y = 80 }) == &wide, "wide element wasn't found");
+    test_check(layout_index_query_point(idx, (vec2){ .x = 150, .y = 150 }) == NULL, "found an element in empty space");
+
+    layout_index_free(idx);
+}
+
+static void test_outside_grid() {
+    layout_index idx = layout_index_new(index_area, cell_size);
+    layout_element before, after;
+    layout_element_init(&before, vec2_zero);
+    layout_element_init(&after, vec2_zero);
+    set_bounds(&before, -60, -60, 10, 10);
+    set_bounds(&after, 500, 90, 20, 20);
+    layout_index_update(idx, &before);
+    layout_index_update(idx, &after);
+
+    // Elements beyond the grid are kept in its edge cells
+    test_check(idx->cells[0].count == 1 && idx->cells[0].elements[0] == &before, "element before the grid isn't in the first cell");
+    const layout_index_cell* right = &idx->cells[3 * idx->columns + idx->columns - 1];
+    const layout_index_cell* right_below = &idx->cells[4 * idx->columns + idx->columns - 1];
+    test_check(right->count == 1 && right->elements[0] == &after, "element after the grid isn't in the right edge cell");
+    test_check(right_below->count == 1, "element after the grid doesn't span its rows");
+
+    test_check(layout_index_query_point(idx, (vec2){ .x = -55, .y = -55 }) == &before, "element before the grid wasn't found");
+    test_check(layout_index_query_point(idx, (vec2){ .x = 510, .y = 100 }) == &after, "element after the grid wasn't found");
+    test_check(layout_index_query_point(idx, (vec2){ .x = 300, .y = 100 }) == NULL, "found an element between the grid and one beyond it");
+
+    layout_element* found[2];
+    aabb_2d everything = { .position = { .x = -1000, .y = -1000 }, .dimensions = { .x = 2000, .y = 2000 } };
+    test_check(layout_index_query_rect(idx, everything, found, 2) == 2, "elements outside the grid weren't all found");
+
+    layout_index_free(idx);
+}
+
+static void test_update_only_moves_changed() {
+    layout_index idx = layout_index_new(index_area, cell_size);
+    layout_element elements[3];
+    for(uint32 i = 0; i < 3; ++i) {
+        layout_element_init(&elements[i], vec2_zero);
+        set_bounds(&elements[i], 2 + i, 2 + i, 5, 5);
+        layout_index_update(idx, &elements[i]);
+    }
+
+    // An element that hasn't moved is left where it is, so the cell's order doesn't change
+    const layout_index_cell* cell = &idx->cells[0];
+    layout_index_update(idx, &elements[0]);
+    test_check(cell->count == 3 && cell->elements[0] == &elements[0] && cell->elements[2] == &elements[2], "unchanged element was re-filed");
+
+    // A moved element is removed and re-inserted, which puts it at the end
+    set_bounds(&elements[0], 3, 3, 5, 5);
+    layout_index_update(idx, &elements[0]);
+    test_check(cell->count == 3 && cell->elements[2] == &elements[0], "moved element wasn't re-filed");
+    test_check(elements[0].indexed_bounds.position.x == 3, "indexed bounds weren't updated");
+
+    // Solving a layout files its elements, and re-solving it unchanged leaves them alone
+    layout l;
+    layout_init(&l, index_area.dimensions, LAYOUT_STACK_VERTICAL);
+    layout_set_index(&l, idx);
+    layout_element stacked[2];
+    for(uint32 i = 0; i < 2; ++i) {
+        layout_element_init(&stacked[i], (vec2){ .x = 30, .y = 30 });
+        layout_add_element(&l, &stacked[i]);
+    }
+    layout_update(&l);
+    test_check(layout_index_get_count(idx) == 5, "expected 5 elements, got %u", layout_index_get_count(idx));
+    test_check(layout_index_query_point(idx, (vec2){ .x = 10, .y = 40 }) == &stacked[1], "solved element wasn't indexed");
+
+    layout_element_set_requested_dims(&stacked[0], (vec2){ .x = 30, .y = 50 });
+    layout_update(&l);
+    test_check(layout_index_query_point(idx, (vec2){ .x = 10, .y = 60 }) == &stacked[1], "moved element wasn't re-filed");
+
+    layout_cleanup(&l);
+    layout_index_free(idx);
+}
+
+static void test_matches_linear_scan() {
+    srand(11);
+
+    layout_index idx = layout_index_new(index_area, cell_size);
+    layout_element* elements = scalloc(ELEMENT_COUNT, sizeof(layout_element));
+    for(uint32 i = 0; i < ELEMENT_COUNT; ++i) {
+        // Sizes are distinct, so the smallest element under a point is never a tie. Some elements are outside the grid.
+        layout_element_init(&elements[i], vec2_zero);
+        set_bounds(&elements[i], random_float(-40, 220), random_float(-40, 220), 2 + i * 0.25f, 3 + i * 0.125f);
+        layout_index_update(idx, &elements[i]);
+    }
+
+    uint32 point_mismatches = 0;
+    for(uint32 q = 0; q < 1000; ++q) {
+        vec2 point = { .x = random_float(-60, 260), .y = random_float(-60, 260) };
+
+        layout_element* expected = NULL;
+        for(uint32 i = 0; i < ELEMENT_COUNT; ++i) {
+            aabb_2d b = elements[i].calculated_bounds;
+            if(contains_point(b, point) && (expected == NULL ||
+               b.dimensions.x * b.dimensions.y < expected->calculated_bounds.dimensions.x * expected->calculated_bounds.dimensions.y)) {
+                expected = &elements[i];
+            }
+        }
+
+        point_mismatches += layout_index_query_point(idx, point) != expected;
+    }
+    test_check(point_mismatches == 0, "%u point queries differ from a linear scan", point_mismatches);
+
+    uint32 rect_mismatches = 0;
+    layout_element** found = scalloc(ELEMENT_COUNT, sizeof(layout_element*));
+    for(uint32 q = 0; q < 200; ++q) {
+        aabb_2d box = { .position = { .x = random_float(-60, 260), .y = random_float(-60, 260) },
+                        .dimensions = { .x = random_float(0, 80), .y = random_float(0, 80) } };
+
+        uint32 expected = 0;
+        for(uint32 i = 0; i < ELEMENT_COUNT; ++i) {
+            expected += overlaps(elements[i].calculated_bounds, box);
+        }
+
+        // Every element is reported once, so the count matches and nothing repeats
+        uint32 count = layout_index_query_rect(idx, box, found, ELEMENT_COUNT);
+        bool matches = count == expected;
+        for(uint32 i = 0; i < count && matches; ++i) {
+            matches = overlaps(found[i]->calculated_bounds, box);
+            for(uint32 j = 0; j < i && matches; ++j) {
+                matches = found[i] != found[j];
+            }
+        }
+        rect_mismatches += !matches;
+    }
+    test_check(rect_mismatches == 0, "%u rect queries differ from a linear scan", rect_mismatches);
+
+    // The index is freed first, since it detaches the elements still in it
+    layout_index_free(idx);
+    sfree(found);
+    sfree(elements);
+}
+
+static void test_null_layout() {
+    // This logs an error instead of crashing
+    layout_set_index(NULL, NULL);
+}
+
+int main() {
+    test_run(test_spanning_element);
+    test_run(test_outside_grid);
+    test_run(test_update_only_moves_changed);
+    test_run(test_matches_linear_scan);
+    test_run(test_null_layout);
+
+    return test_result();
+}
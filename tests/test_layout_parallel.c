@@ -0,0 +1,174 @@
+// Tests that parallel layout updates give identical results to serial ones, including solve counts, damage and indexing
+
+#include "test.h"
+#include "layout.h"
+#include "layout_index.h"
+#include "layout_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PANEL_COUNT 6
+#define PANEL_ELEMENTS 20
+#define ELEMENT_COUNT (PANEL_COUNT * PANEL_ELEMENTS)
+
+// A grid of wrapped flex panels, with a damage tracker and an index on the root
+typedef struct test_tree {
+    layout root;
+    layout panels[PANEL_COUNT];
+    layout_element elements[ELEMENT_COUNT];
+    ui_damage damage;
+    layout_index index;
+} test_tree;
+
+static const aabb_2d screen = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 600, .y = 400 } };
+
+// Builds the same tree for the same seed
+static test_tree* make_tree(uint32 seed) {
+    srand(seed);
+
+    test_tree* t = scalloc(1, sizeof(test_tree));
+    layout_init(&t->root, screen.dimensions, LAYOUT_GRID);
+    layout_set_columns(&t->root, 3);
+    layout_set_spacing(&t->root, (vec2){ .x = 4, .y = 4 });
+
+    t->damage = ui_damage_new(screen, 64);
+    t->index = layout_index_new(screen, (vec2){ .x = 50, .y = 50 });
+    layout_set_damage(&t->root, t->damage);
+    layout_set_index(&t->root, t->index);
+
+    for(uint32 p = 0; p < PANEL_COUNT; ++p) {
+        layout_init(&t->panels[p], (vec2){ .x = 190, .y = 190 }, p % 2 == 0 ? LAYOUT_FLEX_HORIZONTAL : LAYOUT_FLEX_VERTICAL);
+        layout_set_wrap(&t->panels[p], true);
+        layout_set_spacing(&t->panels[p], (vec2){ .x = 2, .y = 3 });
+        layout_add_layout(&t->root, &t->panels[p]);
+
+        for(uint32 i = 0; i < PANEL_ELEMENTS; ++i) {
+            layout_element* elem = &t->elements[p * PANEL_ELEMENTS + i];
+            layout_element_init(elem, (vec2){ .x = 5 + rand() % 40, .y = 5 + rand() % 40 });
+            layout_add_element(&t->panels[p], elem);
+            layout_element_set_flex(elem, (float)(rand() % 3), (float)(rand() % 2));
+        }
+    }
+
+    return t;
+}
+
+static void free_tree(test_tree* t) {
+    for(uint32 p = 0; p < PANEL_COUNT; ++p) {
+        layout_cleanup(&t->panels[p]);
+    }
+    layout_cleanup(&t->root);
+    ui_damage_free(t->damage);
+    layout_index_free(t->index);
+    sfree(t);
+}
+
+static uint32 get_element_index(const test_tree* t, const layout_element* elem) {
+    return elem - t->elements;
+}
+
+// Checks that two trees were solved, reported and indexed identically
+static void compare_trees(test_tree* serial, test_tree* parallel) {
+    uint32 mismatches = 0;
+    for(uint32 i = 0; i < ELEMENT_COUNT; ++i) {
+        mismatches += memcmp(&serial->elements[i].calculated_bounds, &parallel->elements[i].calculated_bounds, sizeof(aabb_2d)) != 0;
+        mismatches += memcmp(&serial->elements[i].damage_bounds, &parallel->elements[i].damage_bounds, sizeof(aabb_2d)) != 0;
+        mismatches += memcmp(&serial->elements[i].indexed_bounds, &parallel->elements[i].indexed_bounds, sizeof(aabb_2d)) != 0;
+    }
+    for(uint32 p = 0; p < PANEL_COUNT; ++p) {
+        mismatches += memcmp(&serial->panels[p].bounds.calculated_bounds, &parallel->panels[p].bounds.calculated_bounds, sizeof(aabb_2d)) != 0;
+        test_check(layout_get_solve_count(&serial->panels[p]) == layout_get_solve_count(&parallel->panels[p]),
+                   "panel %u solved %u elements serially and %u in parallel", p,
+                   layout_get_solve_count(&serial->panels[p]), layout_get_solve_count(&parallel->panels[p]));
+    }
+    test_check(mismatches == 0, "%u bounds differ", mismatches);
+    test_check(layout_get_solve_count(&serial->root) == layout_get_solve_count(&parallel->root),
+               "solved %u elements serially and %u in parallel", layout_get_solve_count(&serial->root), layout_get_solve_count(&parallel->root));
+
+    // Damage is reported in the same order, so the raw rectangles match
+    test_check(serial->damage->rect_count == parallel->damage->rect_count,
+               "%u damage rects serially and %u in parallel", serial->damage->rect_count, parallel->damage->rect_count);
+    if(serial->damage->rect_count == parallel->damage->rect_count && serial->damage->rect_count != 0) {
+        test_check(memcmp(serial->damage->rects, parallel->damage->rects, serial->damage->rect_count * sizeof(aabb_2d)) == 0, "damage differs");
+    }
+
+    // Each cell holds the same elements in the same order
+    test_check(layout_index_get_count(serial->index) == layout_index_get_count(parallel->index), "index counts differ");
+    uint32 cell_mismatches = 0;
+    for(uint32 c = 0; c < (uint32)serial->index->columns * serial->index->rows; ++c) {
+        const layout_index_cell* a = &serial->index->cells[c];
+        const layout_index_cell* b = &parallel->index->cells[c];
+        if(a->count != b->count) {
+            ++cell_mismatches;
+            continue;
+        }
+        for(uint32 i = 0; i < a->count; ++i) {
+            cell_mismatches += get_element_index(serial, a->elements[i]) != get_element_index(parallel, b->elements[i]);
+        }
+    }
+    test_check(cell_mismatches == 0, "%u index cells differ", cell_mismatches);
+
+    ui_damage_clear(serial->damage);
+    ui_damage_clear(parallel->damage);
+}
+
+static void check_pool(uint16 thread_count) {
+    layout_pool pool = layout_pool_new(thread_count);
+    test_tree* serial = make_tree(7);
+    test_tree* parallel = make_tree(7);
+
+    layout_update(&serial->root);
+    layout_update_parallel(&parallel->root, pool);
+    compare_trees(serial, parallel);
+
+    // Nothing changed, so nothing is solved
+    layout_update(&serial->root);
+    layout_update_parallel(&parallel->root, pool);
+    test_check(layout_get_solve_count(&parallel->root) == 0, "unchanged tree solved %u elements", layout_get_solve_count(&parallel->root));
+    compare_trees(serial, parallel);
+
+    // One element changes
+    layout_element_set_requested_dims(&serial->elements[25], (vec2){ .x = 70, .y = 12 });
+    layout_element_set_requested_dims(&parallel->elements[25], (vec2){ .x = 70, .y = 12 });
+    layout_update(&serial->root);
+    layout_update_parallel(&parallel->root, pool);
+    compare_trees(serial, parallel);
+
+    // The root shrinks, which moves and resizes every panel
+    aabb_2d smaller = { .position = { .x = 10, .y = 20 }, .dimensions = { .x = 450, .y = 300 } };
+    serial->root.bounds.calculated_bounds = smaller;
+    parallel->root.bounds.calculated_bounds = smaller;
+    layout_update(&serial->root);
+    layout_update_parallel(&parallel->root, pool);
+    compare_trees(serial, parallel);
+
+    free_tree(serial);
+    free_tree(parallel);
+    layout_pool_free(pool);
+}
+
+static void test_no_threads() {
+    check_pool(0);
+}
+
+static void test_threads() {
+    check_pool(4);
+}
+
+static void test_null_layout() {
+    layout_pool pool = layout_pool_new(0);
+
+    // This logs an error instead of crashing
+    layout_update_parallel(NULL, pool);
+
+    layout_pool_free(pool);
+}
+
+int main() {
+    test_run(test_no_threads);
+    test_run(test_threads);
+    test_run(test_null_layout);
+
+    return test_result();
+}
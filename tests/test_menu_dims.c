@@ -0,0 +1,139 @@
+// Tests that a menu's cached dimensions match a full recalculation as entries are added, removed and relabeled
+
+#include "test.h"
+#include "menu.h"
+
+#include <stdlib.h>
+
+#define OPERATIONS 5000
+#define MAX_ENTRIES 40
+
+// Every character is 5 pixels wide, and lines are 10 pixels tall
+static bool get_test_glyph(void* data, uint32 c, menu_glyph* g) {
+    *g = (menu_glyph) {
+        .texture_bounds = { .position = vec2_zero, .dimensions = { .x = 4, .y = 8 } },
+        .bearing = { .x = 0, .y = 8 },
+        .advance = 5
+    };
+    return true;
+}
+
+static vec2 get_test_atlas_size(void* data) {
+    return (vec2){ .x = 64, .y = 64 };
+}
+
+static menu make_test_menu(vec3 offset) {
+    menu_glyph_source glyphs = {
+        .get_glyph = get_test_glyph,
+        .get_atlas_size = get_test_atlas_size,
+        .line_height = 10,
+        .data = NULL
+    };
+
+    menu m = menu_new_with_glyphs(glyphs);
+    menu_set_offset(m, offset);
+    return m;
+}
+
+// Makes a label of 0 to 11 characters, which sometimes has a second line
+static const char* make_label(char* buffer) {
+    int length = rand() % 12;
+    for(int i = 0; i < length; ++i) {
+        buffer[i] = 'a' + rand() % 26;
+    }
+    if(length > 2 && rand() % 8 == 0) {
+        buffer[length / 2] = '\n';
+    }
+    buffer[length] = '\0';
+
+    return buffer;
+}
+
+// Runs random changes against a menu, comparing its cached dims with a recalculation after each one
+static void run_random_changes(vec3 offset, unsigned int seed) {
+    srand(seed);
+    menu m = make_test_menu(offset);
+    menu check = make_test_menu(offset);
+    char label[16];
+
+    // Setting the offset invalidates the dims, so they're calculated once up front
+    menu_calculate_dims(m);
+
+    int mismatches = 0;
+    for(int op = 0; op < OPERATIONS; ++op) {
+        container_index count = menu_get_entry_count(m);
+        int choice = rand() % 3;
+        if(count == 0 || (choice == 0 && count < MAX_ENTRIES)) {
+            menu_add_entry(m, make_label(label), NULL, NULL);
+        } else if(choice == 1) {
+            menu_remove_entry(m, rand() % count);
+        } else {
+            menu_set_entry_label(m, rand() % count, make_label(label));
+        }
+
+        // The cache is updated as entries change, so it shouldn't be invalidated
+        if(!m->dims_valid) {
+            ++mismatches;
+        }
+
+        vec2 cached = menu_calculate_dims(m);
+        menu_clear(check);
+        array_foreach(m->entries, iter) {
+            menu_add_entry(check, ((menu_entry*)iter.data)->str, NULL, NULL);
+        }
+        menu_invalidate_dims(check);
+        vec2 expected = menu_calculate_dims(check);
+
+        if(cached.x != expected.x || cached.y != expected.y) {
+            ++mismatches;
+        }
+    }
+
+    test_check(mismatches == 0, "%d of %d changes left the cached dims wrong", mismatches, OPERATIONS);
+
+    menu_free(m);
+    menu_free(check);
+}
+
+static void test_random_changes() {
+    run_random_changes((vec3){ .x = 0, .y = 0, .z = 0 }, 1);
+}
+
+static void test_random_changes_with_offset() {
+    run_random_changes((vec3){ .x = 3, .y = 2, .z = 0 }, 2);
+}
+
+static void test_random_changes_with_negative_offset() {
+    run_random_changes((vec3){ .x = -4, .y = -12, .z = 0 }, 3);
+}
+
+static void test_remove_keeps_edges() {
+    menu m = make_test_menu(vec3_zero);
+    menu_add_entry(m, "aaaaaa", NULL, NULL);
+    menu_add_entry(m, "a", NULL, NULL);
+    menu_add_entry(m, "aaaaaa", NULL, NULL);
+
+    test_check_float(menu_calculate_dims(m).x, 30);
+    test_check_float(menu_calculate_dims(m).y, 30);
+
+    // Another entry is just as wide, so removing one of the widest keeps the width
+    menu_remove_entry(m, 0);
+    test_check(m->dims_count_x == 1, "expected 1 entry at the right edge, got %u", m->dims_count_x);
+    test_check_float(menu_calculate_dims(m).x, 30);
+    test_check_float(menu_calculate_dims(m).y, 20);
+
+    // Shrinking the last wide entry falls back to the next widest
+    menu_set_entry_label(m, 1, "aa");
+    test_check_float(menu_calculate_dims(m).x, 10);
+
+    menu_free(m);
+}
+
+int main() {
+    test_run(test_random_changes);
+    test_run(test_random_changes_with_offset);
+    test_run(test_random_changes_with_negative_offset);
+    test_run(test_remove_keeps_edges);
+
+    return test_result();
+}
@@ -0,0 +1,110 @@
+// Tests for lazily built submenus, their eviction, and the order of activation events
+
+#include "test.h"
+#include "menu.h"
+
+#define SUBMENU_ENTRIES 20
+
+static bool get_test_glyph(void* data, uint32 c, menu_glyph* g) {
+    *g = (menu_glyph) {
+        .texture_bounds = { .position = vec2_zero, .dimensions = { .x = 6, .y = 8 } },
+        .bearing = { .x = 1, .y = 8 },
+        .advance = 7
+    };
+    return true;
+}
+
+static vec2 get_test_atlas_size(void* data) {
+    return (vec2){ .x = 64, .y = 64 };
+}
+
+static menu make_test_menu() {
+    menu_glyph_source glyphs = {
+        .get_glyph = get_test_glyph,
+        .get_atlas_size = get_test_atlas_size,
+        .line_height = 10,
+        .data = NULL
+    };
+
+    return menu_new_with_glyphs(glyphs);
+}
+
+static int build_count = 0;
+
+static void build_test_submenu(menu m, void* user) {
+    ++build_count;
+    for(int i = 0; i < SUBMENU_ENTRIES; ++i) {
+        menu_add_entry(m, "entry", NULL, NULL);
+    }
+}
+
+static void test_eviction_keeps_submenus() {
+    build_count = 0;
+    menu root = make_test_menu();
+    menu_add_lazy_entry(root, "first", build_test_submenu, NULL, NULL);
+    menu_add_lazy_entry(root, "second", build_test_submenu, NULL, NULL);
+    menu_set_lazy_budget(root, 0);
+
+    menu first = menu_get_submenu(root, 0);
+    test_check(first != NULL, "lazy submenu wasn't built");
+    test_check(menu_build_vertices(first) > 0, "lazy submenu has no vertices");
+    size_t one = menu_get_lazy_usage(root);
+    test_check(one > 0, "built submenu isn't counted");
+
+    // Only one submenu fits, so opening the second evicts the first
+    menu_set_lazy_budget(root, one + one / 2);
+    menu second = menu_get_submenu(root, 1);
+    test_check(first->is_evicted, "least recently used submenu wasn't evicted");
+    test_check(!second->is_evicted, "opened submenu was evicted");
+    test_check(menu_get_lazy_usage(root) <= one + one / 2, "usage %zu is over budget", menu_get_lazy_usage(root));
+
+    // The evicted submenu keeps its entries, and reopening it doesn't build it again
+    test_check(first->draw_verts == NULL && first->draw_capacity == 0, "evicted submenu kept its vertices");
+    test_check(menu_get_entry_count(first) == SUBMENU_ENTRIES, "evicted submenu lost its entries");
+    test_check(menu_get_submenu(root, 0) == first, "reopened submenu moved");
+    test_check(build_count == 2, "expected 2 builds, got %d", build_count);
+    test_check(!first->is_evicted && second->is_evicted, "reopening didn't evict the other submenu");
+    test_check(menu_build_vertices(first) > 0, "reopened submenu has no vertices");
+
+    menu_free(root);
+}
+
+static menu replacement = NULL;
+static menu seen_submenu = NULL;
+
+// Gives the entry under the cursor a submenu, like an event that creates its submenu on demand
+static void set_submenu_event(menu m) {
+    menu_get_entry(m, m->cursor)->submenu = replacement;
+}
+
+static void record_submenu_event(menu m) {
+    seen_submenu = menu_get_entry(m, m->cursor)->submenu;
+}
+
+static void test_activation_order() {
+    build_count = 0;
+    menu root = make_test_menu();
+    replacement = make_test_menu();
+    menu_add_entry(root, "plain", NULL, set_submenu_event);
+    menu_add_lazy_entry(root, "lazy", build_test_submenu, NULL, record_submenu_event);
+
+    // Entries without a builder call their event first, and return whatever submenu it left
+    menu_set_cursor(root, 0);
+    test_check(menu_activate(root) == replacement, "event's submenu wasn't returned");
+
+    // Lazy submenus are built before the event, so that it can see them
+    menu_set_cursor(root, 1);
+    menu sub = menu_activate(root);
+    test_check(sub != NULL && seen_submenu == sub, "event didn't see the built submenu");
+    test_check(build_count == 1, "expected 1 build, got %d", build_count);
+
+    menu_free(root);
+    menu_free(replacement);
+}
+
+int main() {
+    test_run(test_eviction_keeps_submenus);
+    test_run(test_activation_order);
+
+    return test_result();
+}
@@ -0,0 +1,177 @@
+// Tests for building menu vertices from an injected glyph source, without a font or GL context
+
+#include "test.h"
+#include "menu.h"
+
+#define ATLAS_WIDTH 256
+#define ATLAS_HEIGHT 128
+#define LINE_HEIGHT 10
+
+// Lowercase letters are 6x8 quads with a bearing of (1, 8) and an advance of 7, and spaces advance by 3.
+// Nothing else has a glyph.
+static bool get_test_glyph(void* data, uint32 c, menu_glyph* g) {
+    if(c == ' ') {
+        *g = (menu_glyph){ .advance = 3 };
+        return true;
+    }
+    if(c < 'a' || c > 'z') {
+        return false;
+    }
+
+    *g = (menu_glyph) {
+        .texture_bounds = { .position = { .x = (c - 'a') * 8, .y = 0 }, .dimensions = { .x = 6, .y = 8 } },
+        .bearing = { .x = 1, .y = 8 },
+        .advance = 7
+    };
+    return true;
+}
+
+static vec2 get_test_atlas_size(void* data) {
+    return (vec2){ .x = ATLAS_WIDTH, .y = ATLAS_HEIGHT };
+}
+
+static menu make_test_menu() {
+    menu_glyph_source glyphs = {
+        .get_glyph = get_test_glyph,
+        .get_atlas_size = get_test_atlas_size,
+        .line_height = LINE_HEIGHT,
+        .data = NULL
+    };
+
+    menu m = menu_new_with_glyphs(glyphs);
+    menu_set_offset(m, (vec3){ .x = 2, .y = 1, .z = 0 });
+    menu_add_entry(m, "ab", NULL, NULL);
+    menu_add_entry(m, "a b", NULL, NULL);
+    menu_add_entry(m, "", NULL, NULL);
+    menu_add_entry(m, "z?z", NULL, NULL);
+
+    return m;
+}
+
+// Gets the box covered by the quad whose vertices start at first
+static aabb_2d get_quad_box(const vt_pt* first) {
+    float left = first[0].position.x, right = left;
+    float top = first[0].position.y, bottom = top;
+    for(uint8 i = 1; i < 6; ++i) {
+        left = min(left, first[i].position.x);
+        right = max(right, first[i].position.x);
+        top = min(top, first[i].position.y);
+        bottom = max(bottom, first[i].position.y);
+    }
+
+    return (aabb_2d){ .position = { .x = left, .y = top }, .dimensions = { .x = right - left, .y = bottom - top } };
+}
+
+static void check_quad(const vt_pt* first, float x, float y, float w, float h) {
+    aabb_2d box = get_quad_box(first);
+    test_check_float(box.position.x, x);
+    test_check_float(box.position.y, y);
+    test_check_float(box.dimensions.x, w);
+    test_check_float(box.dimensions.y, h);
+}
+
+static void test_vertex_counts() {
+    menu m = make_test_menu();
+
+    // One quad per glyph with a texture. Spaces and missing glyphs only advance, or are skipped.
+    uint32 count = menu_build_vertices(m);
+    test_check(count == 36, "expected 36 vertices, got %u", count);
+
+    const uint32 starts[] = { 0, 12, 24, 24 };
+    for(container_index i = 0; i < 4; ++i) {
+        uint32 start = menu_get_entry_vertex_start(m, i);
+        test_check(start == starts[i], "expected entry %u to start at %u, got %u", i, starts[i], start);
+    }
+    test_check(menu_get_entry_vertex_start(m, 4) == MENU_VERTEX_NONE, "entries past the end weren't built");
+
+    menu_free(m);
+}
+
+static void test_vertex_offsets() {
+    menu m = make_test_menu();
+    menu_build_vertices(m);
+
+    uint32 count = 0;
+    const vt_pt* verts = menu_get_vertices(m, &count);
+
+    // Entry 1 is offset by one row: (2, 1) plus the line height
+    vec2 offset = menu_get_entry_offset(m, 1);
+    test_check_float(offset.x, 2);
+    test_check_float(offset.y, 11);
+
+    // Glyphs hang from the baseline, a line below the row's top
+    const vt_pt* row = verts + menu_get_entry_vertex_start(m, 1);
+    check_quad(row, 3, 13, 6, 8);
+    // The space advances the pen without a quad of its own
+    check_quad(row + 6, 13, 13, 6, 8);
+
+    // UVs are normalized by the atlas size
+    aabb_2d uv = { .position = { .x = row[0].uv.x, .y = row[0].uv.y } };
+    for(uint8 i = 0; i < 6; ++i) {
+        uv.dimensions.x = max(uv.dimensions.x, row[i].uv.x);
+        uv.dimensions.y = max(uv.dimensions.y, row[i].uv.y);
+        uv.position.x = min(uv.position.x, row[i].uv.x);
+        uv.position.y = min(uv.position.y, row[i].uv.y);
+    }
+    test_check_float(uv.position.x, 0);
+    test_check_float(uv.dimensions.x, 6.0f / ATLAS_WIDTH);
+    test_check_float(uv.dimensions.y, 8.0f / ATLAS_HEIGHT);
+
+    menu_free(m);
+}
+
+// Dimensions come from the same glyph metrics as the vertices
+static void test_dims() {
+    menu m = make_test_menu();
+
+    vec2 dims = menu_calculate_dims(m);
+    test_check_float(dims.x, 20);
+    test_check_float(dims.y, 43);
+
+    menu_free(m);
+}
+
+static void test_alignment() {
+    menu m = make_test_menu();
+    menu_set_label_align(m, ALIGN_CENTER);
+    menu_build_vertices(m);
+
+    // "ab" is 14x10, so centering it moves it back by half of that
+    const vt_pt* verts = menu_get_vertices(m, NULL);
+    check_quad(verts, -6, -3, 6, 8);
+
+    menu_free(m);
+}
+
+// The cursor highlight is built first, so every row starts after it
+static void test_highlight() {
+    menu m = make_test_menu();
+    aabb_2d uv_box = { .position = { .x = 0, .y = 64 }, .dimensions = { .x = 4, .y = 4 } };
+    menu_set_cursor_highlight(m, true, uv_box);
+    menu_set_cursor(m, 1);
+
+    uint32 count = menu_build_vertices(m);
+    test_check(count == 42, "expected 42 vertices, got %u", count);
+    test_check(menu_get_entry_vertex_start(m, 0) == 6, "expected the first row to start after the highlight");
+
+    const vt_pt* verts = menu_get_vertices(m, NULL);
+    check_quad(verts, 2, 11, 20, LINE_HEIGHT);
+
+    // Centered labels are centered on their entry's offset, and so is the highlight behind them
+    menu_set_label_align(m, ALIGN_CENTER);
+    menu_build_vertices(m);
+    verts = menu_get_vertices(m, NULL);
+    check_quad(verts, 2 - 10, 11 - LINE_HEIGHT / 2, 20, LINE_HEIGHT);
+
+    menu_free(m);
+}
+
+int main() {
+    test_run(test_vertex_counts);
+    test_run(test_vertex_offsets);
+    test_run(test_dims);
+    test_run(test_alignment);
+    test_run(test_highlight);
+
+    return test_result();
+}
@@ -0,0 +1,250 @@
+// Tests for compiling, saving and loading UI documents, and instantiating them with a stub glyph source and no frame cache
+
+#include "test.h"
+#include "ui_document.h"
+#include "ui_screen.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char temp_folder[] = "/tmp/dfgame_ui_test.XXXXXX";
+
+static const char* test_document =
+    "<ui>\n"
+    "  <layout name=\"root\" type=\"stack_vertical\" dimensions=\"200 100\" spacing=\"2 4\">\n"
+    "    <element name=\"panel\" dimensions=\"50 20\" padding=\"1 2\" min_dimensions=\"10 10\" frame=\"panel.xml\" grow=\"1\"/>\n"
+    "    <menu name=\"main\" offset=\"0 12\" wrap=\"true\">\n"
+    "      <entry label=\"start\" event=\"start_game\"/>\n"
+    "      <entry label=\"options\">\n"
+    "        <menu name=\"options_menu\">\n"
+    "          <entry label=\"back\"/>\n"
+    "        </menu>\n"
+    "      </entry>\n"
+    "    </menu>\n"
+    "    <layout name=\"row\" type=\"stack_horizontal\" dimensions=\"200 30\"/>\n"
+    "  </layout>\n"
+    "</ui>\n";
+
+// Every glyph is a 6x8 quad with an advance of 7
+static bool get_test_glyph(void* data, uint32 c, menu_glyph* g) {
+    *g = (menu_glyph) {
+        .texture_bounds = { .position = { .x = 0, .y = 0 }, .dimensions = { .x = 6, .y = 8 } },
+        .bearing = { .x = 0, .y = 8 },
+        .advance = 7
+    };
+    return true;
+}
+
+static vec2 get_test_atlas_size(void* data) {
+    return (vec2){ .x = 64, .y = 64 };
+}
+
+static char* make_temp_path(const char* name) {
+    char* path = salloc(strlen(temp_folder) + strlen(name) + 2);
+    sprintf(path, "%s/%s", temp_folder, name);
+    return path;
+}
+
+static void write_file(const char* path, const void* data, size_t size) {
+    FILE* file = fopen(path, "wb");
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+static ui_doc compile_test_document() {
+    char* path = make_temp_path("screen.xml");
+    write_file(path, test_document, strlen(test_document));
+
+    ui_doc doc = ui_doc_compile(path);
+    unlink(path);
+    sfree(path);
+    return doc;
+}
+
+// Writes a copy of doc to path after passing it to corrupt, and checks that it's rejected
+static void check_rejected(ui_doc doc, const char* path, size_t size, void (*corrupt)(ui_doc copy), const char* what) {
+    ui_doc copy = salloc(doc->size);
+    memcpy(copy, doc, doc->size);
+    corrupt(copy);
+    write_file(path, copy, size);
+    sfree(copy);
+
+    ui_doc loaded = ui_doc_load(path);
+    test_check(loaded == NULL, "document with %s was loaded", what);
+    if(loaded != NULL) {
+        ui_doc_free(loaded);
+    }
+}
+
+static void corrupt_nothing(ui_doc copy) { }
+
+static void corrupt_parent(ui_doc copy) {
+    ((ui_doc_node*)((uint8*)copy + copy->nodes_offset))[1].parent = 3;
+}
+
+static void corrupt_string(ui_doc copy) {
+    ((ui_doc_node*)((uint8*)copy + copy->nodes_offset))[1].name = copy->size;
+}
+
+static void corrupt_submenu(ui_doc copy) {
+    ((ui_doc_entry*)((uint8*)copy + copy->entries_offset))[0].submenu = 0;
+}
+
+static void corrupt_magic(ui_doc copy) {
+    copy->magic[0] = 'X';
+}
+
+static void test_round_trip() {
+    ui_doc doc = compile_test_document();
+    test_check(doc != NULL, "document didn't compile");
+    if(doc == NULL) {
+        return;
+    }
+
+    // Nodes are in document order, with submenus after their parent's entries
+    test_check(doc->node_count == 5, "expected 5 nodes, got %u", doc->node_count);
+    test_check(doc->entry_count == 3, "expected 3 entries, got %u", doc->entry_count);
+    uint32 panel = ui_doc_find(doc, "panel");
+    uint32 main_menu = ui_doc_find(doc, "main");
+    uint32 options = ui_doc_find(doc, "options_menu");
+    test_check(ui_doc_find(doc, "root") == 0 && panel == 1 && main_menu == 2 && options == 3 && ui_doc_find(doc, "row") == 4,
+               "nodes are out of order");
+    test_check(ui_doc_find(doc, "missing") == UI_DOC_NONE, "found a node that isn't in the document");
+
+    char* path = make_temp_path("screen.ui");
+    test_check(ui_doc_save(doc, path), "document wasn't saved");
+    ui_doc loaded = ui_doc_load(path);
+    test_check(loaded != NULL, "document wasn't loaded");
+    if(loaded == NULL) {
+        ui_doc_free(doc);
+        sfree(path);
+        return;
+    }
+    test_check(loaded->size == doc->size && memcmp(loaded, doc, doc->size) == 0, "loaded document differs");
+
+    const ui_doc_node* root = ui_doc_get_node(loaded, 0);
+    test_check(root->type == UI_DOC_LAYOUT && root->layout_type == LAYOUT_STACK_VERTICAL && root->parent == UI_DOC_NONE, "root isn't a vertical layout");
+    test_check(root->dims.x == 200 && root->dims.y == 100, "root has dimensions %gx%g", root->dims.x, root->dims.y);
+    test_check(root->spacing.x == 2 && root->spacing.y == 4, "root has spacing %gx%g", root->spacing.x, root->spacing.y);
+
+    const ui_doc_node* element = ui_doc_get_node(loaded, panel);
+    test_check(element->type == UI_DOC_ELEMENT && element->parent == 0, "panel isn't an element in the root");
+    test_check(element->dims.x == 50 && element->dims.y == 20 && element->padding.x == 1 && element->padding.y == 2 &&
+               element->min_dims.x == 10 && element->grow == 1, "panel's placement wasn't read");
+
+    // Frame paths are resolved against the document's folder
+    char* frame_path = make_temp_path("panel.xml");
+    const char* loaded_frame_path = ui_doc_get_string(loaded, element->frame_path);
+    test_check(loaded_frame_path != NULL && strcmp(loaded_frame_path, frame_path) == 0, "panel's frame path is %s", loaded_frame_path);
+    sfree(frame_path);
+
+    const ui_doc_node* menu_node = ui_doc_get_node(loaded, main_menu);
+    test_check(menu_node->type == UI_DOC_MENU && menu_node->wrap && menu_node->spacing.y == 12, "main menu wasn't read");
+    test_check(menu_node->entry_count == 2, "main menu has %u entries", menu_node->entry_count);
+
+    const ui_doc_entry* start = ui_doc_get_entry(loaded, menu_node->first_entry);
+    const ui_doc_entry* options_entry = ui_doc_get_entry(loaded, menu_node->first_entry + 1);
+    test_check(strcmp(ui_doc_get_string(loaded, start->label), "start") == 0, "first entry is %s", ui_doc_get_string(loaded, start->label));
+    test_check(strcmp(ui_doc_get_string(loaded, start->event), "start_game") == 0, "first entry's event is %s", ui_doc_get_string(loaded, start->event));
+    test_check(start->submenu == UI_DOC_NONE, "first entry has a submenu");
+    test_check(options_entry->event == UI_DOC_NONE && ui_doc_get_string(loaded, options_entry->event) == NULL, "second entry has an event");
+    test_check(options_entry->submenu == options, "second entry's submenu is node %u", options_entry->submenu);
+
+    const ui_doc_node* submenu = ui_doc_get_node(loaded, options);
+    test_check(submenu->parent == main_menu && submenu->entry_count == 1, "options menu isn't nested in the main menu");
+    test_check(strcmp(ui_doc_get_string(loaded, ui_doc_get_entry(loaded, submenu->first_entry)->label), "back") == 0, "options menu's entry is wrong");
+
+    test_check(ui_doc_get_node(loaded, loaded->node_count) == NULL, "got a node past the end");
+    test_check(ui_doc_get_entry(loaded, loaded->entry_count) == NULL, "got an entry past the end");
+
+    ui_doc_free(loaded);
+    ui_doc_free(doc);
+    unlink(path);
+    sfree(path);
+}
+
+static void test_corrupted() {
+    ui_doc doc = compile_test_document();
+    char* path = make_temp_path("corrupted.ui");
+
+    // An untouched copy loads, so the rejections below come from the corruption
+    write_file(path, doc, doc->size);
+    ui_doc loaded = ui_doc_load(path);
+    test_check(loaded != NULL, "untouched copy wasn't loaded");
+    if(loaded != NULL) {
+        ui_doc_free(loaded);
+    }
+
+    check_rejected(doc, path, doc->size - 1, corrupt_nothing, "a truncated string table");
+    check_rejected(doc, path, doc->nodes_offset + 8, corrupt_nothing, "truncated nodes");
+    check_rejected(doc, path, doc->size, corrupt_parent, "a parent after its child");
+    check_rejected(doc, path, doc->size, corrupt_string, "a string outside the table");
+    check_rejected(doc, path, doc->size, corrupt_submenu, "a submenu that isn't a menu");
+    check_rejected(doc, path, doc->size, corrupt_magic, "the wrong magic");
+
+    ui_doc_free(doc);
+    unlink(path);
+    sfree(path);
+}
+
+static void test_screen_without_cache() {
+    ui_doc doc = compile_test_document();
+    menu_glyph_source glyphs = {
+        .get_glyph = get_test_glyph,
+        .get_atlas_size = get_test_atlas_size,
+        .line_height = 10,
+        .data = NULL
+    };
+
+    ui_screen s = ui_screen_new_with_glyphs(doc, glyphs, NULL, NULL, NULL);
+    test_check(s != NULL, "screen wasn't built");
+    if(s == NULL) {
+        ui_doc_free(doc);
+        return;
+    }
+
+    uint32 panel = ui_screen_find(s, "panel");
+    uint32 main_menu = ui_screen_find(s, "main");
+    uint32 options = ui_screen_find(s, "options_menu");
+    layout* root = ui_screen_get_root(s);
+    test_check(root != NULL && ui_screen_get_layout(s, 0) == root, "root layout wasn't built");
+    test_check(ui_screen_get_layout(s, ui_screen_find(s, "row")) != NULL, "nested layout wasn't built");
+
+    // Without a cache, the element is laid out without a frame
+    test_check(ui_screen_get_element(s, panel) != NULL, "panel has no element");
+    test_check(ui_screen_get_frame(s, panel) == NULL, "panel has a frame without a cache");
+
+    menu m = ui_screen_get_menu(s, main_menu);
+    menu sub = ui_screen_get_menu(s, options);
+    test_check(m != NULL && sub != NULL, "menus weren't built");
+    test_check(m != NULL && menu_get_entry_count(m) == 2 && m->can_wrap, "main menu has the wrong entries");
+    test_check(m != NULL && menu_get_entry(m, 1)->submenu == sub, "options entry doesn't open the options menu");
+    test_check(sub != NULL && menu_get_entry_count(sub) == 1, "options menu has the wrong entries");
+
+    // Only the main menu is placed in the root, and it's sized to its entries
+    test_check(ui_screen_get_element(s, main_menu) != NULL, "main menu has no element");
+    test_check(ui_screen_get_element(s, options) == NULL, "submenu has an element");
+    ui_screen_update(s);
+    const layout_element* menu_elem = ui_screen_get_element(s, main_menu);
+    test_check(menu_elem->calculated_bounds.dimensions.y > 0, "main menu wasn't given any space");
+    test_check(menu_elem->calculated_bounds.position.y > ui_screen_get_element(s, panel)->calculated_bounds.position.y,
+               "main menu isn't below the panel");
+
+    ui_screen_free(s);
+    ui_doc_free(doc);
+}
+
+int main() {
+    if(mkdtemp(temp_folder) == NULL) {
+        fprintf(stderr, "Can't create a temporary folder\n");
+        return 1;
+    }
+
+    test_run(test_round_trip);
+    test_run(test_corrupted);
+    test_run(test_screen_without_cache);
+
+    rmdir(temp_folder);
+    return test_result();
+}